@@ -32,7 +32,8 @@ void benchmarkTrees(KDNode* root,
 
     auto startKD = std::chrono::high_resolution_clock::now();
 
-    nearestNeighbor(root, qlat, qlon, kdNearest, bestDistKD, 0);
+    QueryStats kdStats;
+    nearestNeighbor(root, qlat, qlon, kdNearest, bestDistKD, 0, kdStats);
 
     auto endKD = std::chrono::high_resolution_clock::now();
 
@@ -46,7 +47,8 @@ void benchmarkTrees(KDNode* root,
     auto startRTree = std::chrono::high_resolution_clock::now();
 
     Point queryPt = {qlon, qlat};
-    rtree.nearestNeighbor(queryPt, rtreeNearest, bestDistRTree);
+    QueryStats rtreeStats;
+    rtree.nearestNeighbor(queryPt, rtreeNearest, bestDistRTree, rtreeStats);
 
     auto endRTree = std::chrono::high_resolution_clock::now();
 
@@ -68,4 +70,11 @@ void benchmarkTrees(KDNode* root,
     std::cout << "KD Tree Time      : " << kdTime.count() << " microseconds\n";
     std::cout << "R-Tree Time       : " << rtreeTime.count() << " microseconds\n";
     std::cout << "Linear Search Time: " << linearTime.count() << " microseconds\n";
+
+    std::cout << "\nQuery Work (nodes visited / distance evals / subtrees pruned):\n";
+    std::cout << "KD Tree           : " << kdStats.nodesVisited << " / " << kdStats.distanceEvals
+              << " / " << kdStats.subtreesPruned << "\n";
+    std::cout << "R-Tree            : " << rtreeStats.nodesVisited << " / " << rtreeStats.distanceEvals
+              << " / " << rtreeStats.subtreesPruned << "\n";
+    std::cout << "Linear Search     : " << civs.size() << " / " << civs.size() << " / 0\n";
 }
@@ -7,3 +7,9 @@
 void benchmarkTrees(KDNode* root, const RTree& rtree, const std::vector<Civilization>& civs);
 
 void runSpatialScalingTest();
+
+void runSnapshotConcurrencyTest();
+
+void runRegionAssignmentBenchmark();
+
+void runRTreeUpdateBenchmark();
@@ -0,0 +1,127 @@
+// Standalone: replacing the global operator new below must not reach the
+// CLI or the server, so this file is its own executable (json_benchmark).
+#include "../utils/civ_record.h"
+#include "../utils/json_writer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Counts every heap allocation in the process so the benchmark can report
+// allocations per serialized record.
+static std::atomic<size_t> allocationCount{0};
+
+void* operator new(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1)) return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+namespace {
+
+// Previous server style: one stream per record, concatenated with +=
+std::string streamRecord(const Civilization& c) {
+    std::ostringstream j;
+    j << std::fixed << std::setprecision(4);
+    j << "{\"id\":" << c.id << ",\"name\":\"" << c.name << "\","
+      << "\"latitude\":" << c.latitude << ",\"longitude\":" << c.longitude << ","
+      << "\"start_year\":" << c.startYear << ",\"end_year\":" << c.endYear << ","
+      << "\"region\":\"" << c.region << "\","
+      << "\"resource_density\":" << c.resourceDensity << ",\"knowledge_density\":" << c.knowledgeDensity << ","
+      << "\"military_strength\":" << c.militaryStrength << ","
+      << std::setprecision(2) << "\"spatial_score\":" << c.spatialScore() << "}";
+    return j.str();
+}
+
+} // namespace
+
+// Times the server's record writer (CivRecord::writeJSON) against the
+// ostringstream style it replaced; exits non-zero if the reused writer
+// allocates per record.
+int main() {
+    const int RECORDS = 10000;
+    const int ROUNDS = 20;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> lat_dis(-90.0, 90.0);
+    std::uniform_real_distribution<double> lon_dis(-180.0, 180.0);
+    std::uniform_real_distribution<double> density(0.0, 100.0);
+    std::vector<CivRecord> civs;
+    civs.reserve(RECORDS);
+    for (int i = 0; i < RECORDS; ++i) {
+        Civilization c{i, "Civ \"" + std::to_string(i) + "\"", lat_dis(gen), lon_dis(gen), 2000 - i, 2100 - i,
+                       "Region " + std::to_string(i % 12), density(gen), density(gen), density(gen)};
+        civs.emplace_back(std::move(c));
+        civs.back().prepareJSON();
+    }
+
+    std::cout << "\n======================================================\n";
+    std::cout << "        JSON Serialization (" << RECORDS << " records/response)\n";
+    std::cout << "======================================================\n";
+    std::cout << std::left << std::setw(22) << "Writer"
+              << std::setw(20) << "Response (us)"
+              << std::setw(20) << "Allocs / record" << "\n";
+    std::cout << "------------------------------------------------------\n";
+
+    // ostringstream + string concatenation
+    size_t streamBytes = 0;
+    size_t allocBefore = allocationCount.load();
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        std::string json = "[";
+        for (int i = 0; i < RECORDS; ++i) {
+            if (i) json += ",";
+            json += streamRecord(civs[i]);
+        }
+        json += "]";
+        streamBytes = json.size();
+    }
+    auto end = std::chrono::high_resolution_clock::now();
+    double streamAllocs = double(allocationCount.load() - allocBefore) / (double(RECORDS) * ROUNDS);
+    std::cout << std::left << std::setw(22) << "ostringstream"
+              << std::setw(20) << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / ROUNDS
+              << std::setw(20) << streamAllocs << "\n";
+
+    // Reused per-thread writer; the first response grows the buffer
+    JsonWriter& warm = threadJsonWriter();
+    warm.raw('[');
+    for (int i = 0; i < RECORDS; ++i) {
+        if (i) warm.raw(',');
+        civs[i].writeJSON(warm);
+    }
+    warm.raw(']');
+
+    size_t writerBytes = 0;
+    allocBefore = allocationCount.load();
+    start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < ROUNDS; ++r) {
+        JsonWriter& w = threadJsonWriter();
+        w.raw('[');
+        for (int i = 0; i < RECORDS; ++i) {
+            if (i) w.raw(',');
+            civs[i].writeJSON(w);
+        }
+        w.raw(']');
+        writerBytes = w.size();
+    }
+    end = std::chrono::high_resolution_clock::now();
+    size_t writerAllocs = allocationCount.load() - allocBefore;
+    std::cout << std::left << std::setw(22) << "JsonWriter (reused)"
+              << std::setw(20) << std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / ROUNDS
+              << std::setw(20) << double(writerAllocs) / (double(RECORDS) * ROUNDS) << "\n";
+    std::cout << "======================================================\n";
+
+    // The stream version leaves names unescaped, so it is only a lower bound on size
+    bool ok = writerAllocs == 0 && writerBytes >= streamBytes;
+    std::cout << "Zero allocations per record: [" << (ok ? "PASS" : "FAIL") << "]\n";
+    return ok ? 0 : 1;
+}
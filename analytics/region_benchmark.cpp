@@ -0,0 +1,53 @@
+#include "benchmark.h"
+#include "../core/regions/region_index.h"
+#include "../data/region_loader.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+
+void runRegionAssignmentBenchmark() {
+    const int POINTS = 1000000;
+
+    RegionIndex index;
+    auto polygons = loadRegionPolygons("region_polygons.csv");
+    if (polygons.empty()) {
+        std::cout << "region_polygons.csv not found, benchmark skipped.\n";
+        return;
+    }
+    index.build(polygons);
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> lat_dis(-60.0, 60.0);
+    std::uniform_real_distribution<double> lon_dis(-120.0, 140.0);
+    std::vector<std::pair<double, double>> latLons;
+    latLons.reserve(POINTS);
+    for (int i = 0; i < POINTS; ++i) latLons.push_back({lat_dis(gen), lon_dis(gen)});
+
+    unsigned hw = std::max(1u, std::thread::hardware_concurrency());
+
+    std::cout << "\n======================================================\n";
+    std::cout << "       Bulk Region Assignment (Point-in-Polygon)    \n";
+    std::cout << "======================================================\n";
+    std::cout << POINTS << " points, " << index.size() << " polygon regions\n\n";
+    std::cout << std::left << std::setw(15) << "Threads"
+              << std::setw(20) << "Assign Time (ms)"
+              << std::setw(20) << "Assigned Points" << "\n";
+    std::cout << "------------------------------------------------------\n";
+
+    for (unsigned threads : {1u, hw}) {
+        auto start = std::chrono::high_resolution_clock::now();
+        auto assigned = index.assignAll(latLons, threads);
+        auto end = std::chrono::high_resolution_clock::now();
+
+        size_t hits = 0;
+        for (int id : assigned) hits += id >= 0;
+
+        std::cout << std::left << std::setw(15) << threads
+                  << std::setw(20) << std::chrono::duration_cast<std::chrono::milliseconds>(end - start).count()
+                  << std::setw(20) << hits << "\n";
+        if (hw == 1) break;
+    }
+    std::cout << "======================================================\n";
+}
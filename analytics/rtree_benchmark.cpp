@@ -0,0 +1,67 @@
+#include "benchmark.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+
+// Incremental R-Tree maintenance and queries on one uniformly filled tree:
+// insert, then delete, then time nearest and range queries on what is left.
+// Same workload as validation TEST 1, kept here so changes to node layout
+// can be compared build against build.
+void runRTreeUpdateBenchmark() {
+    const int INSERT_COUNT = 500000;
+    const int DELETE_COUNT = 200000;
+    const int QUERIES = 20000;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> lat_dis(-90.0, 90.0);
+    std::uniform_real_distribution<double> lon_dis(-180.0, 180.0);
+
+    std::vector<Point> pts;
+    pts.reserve(INSERT_COUNT);
+    for (int i = 0; i < INSERT_COUNT; i++) {
+        Civilization c{i, "Bench", lat_dis(gen), lon_dis(gen), 2000};
+        pts.push_back({c.longitude, c.latitude, c});
+    }
+    std::vector<std::pair<double, double>> queries;
+    for (int i = 0; i < QUERIES; i++) queries.push_back({lat_dis(gen), lon_dis(gen)});
+
+    using Clock = std::chrono::high_resolution_clock;
+    auto ms = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<double, std::milli>(b - a).count();
+    };
+
+    RTree rtree(8);
+    auto t0 = Clock::now();
+    for (const auto& p : pts) rtree.insert(p);
+    auto t1 = Clock::now();
+    for (int i = 0; i < DELETE_COUNT; i++) rtree.remove(pts[i]);
+    auto t2 = Clock::now();
+
+    size_t found = 0;
+    for (const auto& q : queries) {
+        Civilization best;
+        double bestDist;
+        found += rtree.nearestNeighbor({q.second, q.first, Civilization()}, best, bestDist);
+    }
+    auto t3 = Clock::now();
+    size_t hits = 0;
+    for (const auto& q : queries)
+        hits += rtree.search(Rectangle(q.second - 5, q.first - 5, q.second + 5, q.first + 5)).size();
+    auto t4 = Clock::now();
+
+    std::cout << "\n======================================================\n";
+    std::cout << "          R-Tree Update & Query Benchmark           \n";
+    std::cout << "======================================================\n";
+    std::cout << INSERT_COUNT << " inserts, " << DELETE_COUNT << " deletes, "
+              << QUERIES << " queries each (fan-out 8)\n\n";
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(28) << "Insert (ms)" << ms(t0, t1) << "\n";
+    std::cout << std::left << std::setw(28) << "Delete (ms)" << ms(t1, t2) << "\n";
+    std::cout << std::left << std::setw(28) << "Nearest (us/query)" << 1000 * ms(t2, t3) / QUERIES << "\n";
+    std::cout << std::left << std::setw(28) << "Range 10x10 deg (us/query)" << 1000 * ms(t3, t4) / QUERIES
+              << "  (" << hits / QUERIES << " hits avg)\n";
+    std::cout << std::defaultfloat;
+    if (found != (size_t)QUERIES) std::cout << "Nearest missed on a non-empty tree!\n";
+    std::cout << "======================================================\n";
+}
@@ -0,0 +1,134 @@
+#include "benchmark.h"
+#include "../core/rtree/snapshot_rtree.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <shared_mutex>
+#include <thread>
+
+namespace {
+
+struct LatencySummary {
+    double p50Us;
+    double p99Us;
+    double maxUs;
+    size_t queries;
+    double insertMs;
+};
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0.0;
+    size_t idx = static_cast<size_t>(p * (samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + idx, samples.end());
+    return samples[idx];
+}
+
+// Runs one reader issuing range queries while a writer streams `stream` inserts.
+// `read` and `write` wrap whichever synchronisation scheme is under test.
+template <typename ReadFn, typename WriteFn>
+LatencySummary measureReadsDuringInserts(const std::vector<Point>& stream, ReadFn read, WriteFn write) {
+    std::atomic<bool> writing{true};
+    std::vector<double> latencies;
+    latencies.reserve(1 << 16);
+
+    std::thread reader([&]() {
+        std::mt19937 gen(7);
+        std::uniform_real_distribution<double> lat_dis(-80.0, 80.0);
+        std::uniform_real_distribution<double> lon_dis(-170.0, 170.0);
+        while (writing.load(std::memory_order_relaxed)) {
+            double qlat = lat_dis(gen), qlon = lon_dis(gen);
+            Rectangle box(qlon - 5, qlat - 5, qlon + 5, qlat + 5);
+            auto s = std::chrono::high_resolution_clock::now();
+            read(box);
+            auto e = std::chrono::high_resolution_clock::now();
+            latencies.push_back(std::chrono::duration<double, std::micro>(e - s).count());
+        }
+    });
+
+    auto startInsert = std::chrono::high_resolution_clock::now();
+    for (const auto& p : stream) write(p);
+    auto endInsert = std::chrono::high_resolution_clock::now();
+    writing = false;
+    reader.join();
+
+    LatencySummary summary;
+    summary.queries = latencies.size();
+    summary.insertMs = std::chrono::duration<double, std::milli>(endInsert - startInsert).count();
+    summary.p50Us = percentile(latencies, 0.50);
+    summary.p99Us = percentile(latencies, 0.99);
+    summary.maxUs = latencies.empty() ? 0.0 : *std::max_element(latencies.begin(), latencies.end());
+    return summary;
+}
+
+void printRow(const std::string& label, const LatencySummary& s) {
+    std::cout << std::left << std::setw(18) << label
+              << std::setw(12) << s.queries
+              << std::setw(12) << s.p50Us
+              << std::setw(12) << s.p99Us
+              << std::setw(14) << s.maxUs
+              << std::setw(14) << s.insertMs << "\n";
+}
+
+} // namespace
+
+void runSnapshotConcurrencyTest() {
+    const int PRELOAD = 100000;
+    const int STREAM = 50000;
+
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> lat_dis(-90.0, 90.0);
+    std::uniform_real_distribution<double> lon_dis(-180.0, 180.0);
+
+    std::vector<Point> preload, stream;
+    for (int i = 0; i < PRELOAD + STREAM; ++i) {
+        Civilization c{i, "Benchmark", lat_dis(gen), lon_dis(gen), 2000};
+        (i < PRELOAD ? preload : stream).push_back({c.longitude, c.latitude, c});
+    }
+
+    std::cout << "\n======================================================\n";
+    std::cout << "    Read Latency During Sustained Insert Stream     \n";
+    std::cout << "======================================================\n";
+    std::cout << PRELOAD << " preloaded points, " << STREAM << " streamed inserts, 10x10 degree range reads\n\n";
+    std::cout << std::left << std::setw(18) << "Index"
+              << std::setw(12) << "Queries"
+              << std::setw(12) << "p50 (us)"
+              << std::setw(12) << "p99 (us)"
+              << std::setw(14) << "Max (us)"
+              << std::setw(14) << "Insert (ms)" << "\n";
+    std::cout << "------------------------------------------------------\n";
+
+    {
+        RTree rtree(8);
+        for (const auto& p : preload) rtree.insert(p);
+        std::shared_mutex mtx;
+
+        auto summary = measureReadsDuringInserts(stream,
+            [&](const Rectangle& box) {
+                std::shared_lock<std::shared_mutex> lock(mtx);
+                return rtree.search(box).size();
+            },
+            [&](const Point& p) {
+                std::unique_lock<std::shared_mutex> lock(mtx);
+                rtree.insert(p);
+            });
+        printRow("Locked RTree", summary);
+    }
+
+    {
+        SnapshotRTree rtree(8);
+        rtree.insertBatch(preload);
+
+        auto summary = measureReadsDuringInserts(stream,
+            [&](const Rectangle& box) {
+                return rtree.snapshot().search(box).size();
+            },
+            [&](const Point& p) {
+                rtree.insert(p);
+            });
+        printRow("Snapshot RTree", summary);
+    }
+    std::cout << "======================================================\n";
+}
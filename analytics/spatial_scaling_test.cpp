@@ -1,4 +1,5 @@
 #include "benchmark.h"
+#include "../core/rtree/fixed_rtree.h"
 #include <iostream>
 #include <vector>
 #include <chrono>
@@ -18,7 +19,9 @@ void runSpatialScalingTest() {
     std::cout << std::left << std::setw(15) << "Dataset Size" 
               << std::setw(20) << "Insert Time (ms)" 
               << std::setw(20) << "Range Query (ms)" 
-              << std::setw(20) << "NN Search (us)" << "\n";
+              << std::setw(20) << "NN Search (us)"
+              << std::setw(20) << "NN Nodes (avg)"
+              << std::setw(20) << "Range Pruned (%)" << "\n";
     std::cout << "------------------------------------------------------\n";
 
     for (int size : sizes) {
@@ -44,6 +47,9 @@ void runSpatialScalingTest() {
         auto results = rtree.search(queryBox);
         auto endRange = std::chrono::high_resolution_clock::now();
         double rangeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endRange - startRange).count();
+
+        QueryStats rangeStats;
+        rtree.search(queryBox, [](const Point&) {}, rangeStats);
         
         // Nearest Neighbor Test
         Point queryPt = {45.0, 45.0, Civilization()};
@@ -53,10 +59,44 @@ void runSpatialScalingTest() {
         rtree.nearestNeighbor(queryPt, best, bestDist);
         auto endNN = std::chrono::high_resolution_clock::now();
         double nnUs = std::chrono::duration_cast<std::chrono::microseconds>(endNN - startNN).count();
+
+        // Work per nearest query, summed over random queries
+        const int NN_SAMPLES = 1000;
+        QueryStats nnStats;
+        for (int q = 0; q < NN_SAMPLES; ++q) {
+            rtree.nearestNeighbor({lon_dis(gen), lat_dis(gen), Civilization()}, best, bestDist, nnStats);
+        }
         
         std::cout << std::left << std::setw(15) << size 
                   << std::setw(20) << insertMs 
                   << std::setw(20) << rangeMs 
+                  << std::setw(20) << nnUs
+                  << std::setw(20) << (double)nnStats.nodesVisited / NN_SAMPLES
+                  << std::setw(20) << rangeStats.pruningRatio() * 100 << "\n";
+
+        // Same workload on the compile-time fan-out tree with inline nodes
+        FixedRTree<Point, 8> ftree;
+        startInsert = std::chrono::high_resolution_clock::now();
+        for (const auto& p : testPoints) {
+            ftree.insert(p);
+        }
+        endInsert = std::chrono::high_resolution_clock::now();
+        insertMs = std::chrono::duration_cast<std::chrono::milliseconds>(endInsert - startInsert).count();
+
+        startRange = std::chrono::high_resolution_clock::now();
+        auto fixedResults = ftree.intersecting(queryBox);
+        endRange = std::chrono::high_resolution_clock::now();
+        rangeMs = std::chrono::duration_cast<std::chrono::milliseconds>(endRange - startRange).count();
+
+        Point fixedBest;
+        startNN = std::chrono::high_resolution_clock::now();
+        ftree.nearest(queryPt.x, queryPt.y, fixedBest, bestDist);
+        endNN = std::chrono::high_resolution_clock::now();
+        nnUs = std::chrono::duration_cast<std::chrono::microseconds>(endNN - startNN).count();
+
+        std::cout << std::left << std::setw(15) << "  fixed<8>"
+                  << std::setw(20) << insertMs
+                  << std::setw(20) << rangeMs
                   << std::setw(20) << nnUs << "\n";
     }
     std::cout << "======================================================\n";
@@ -1,15 +1,43 @@
+#include <algorithm>
 #include <iostream>
 #include <vector>
 #include <random>
 #include <chrono>
 #include <iomanip>
 #include <cmath>
+#include <limits>
+#include <cstring>
+#include <map>
+#include <set>
 #include "core/rtree/rtree.h"
+#include "core/rtree/snapshot_rtree.h"
+#include "core/rtree/fixed_rtree.h"
+#include "core/regions/region_index.h"
+#include "core/aggregate.h"
 #include "core/kd_tree.h"
+#include "core/kd_index.h"
+#include "core/temporal/interval_tree.h"
+#include "core/voronoi/delaunay.h"
+#include "core/tiles/cluster_pyramid.h"
+#include "utils/civframe.h"
 
 using namespace std;
 using namespace std::chrono;
 
+// Per-node summary for the aggregate R-Tree test: count/sum/min/max of start year
+struct YearSummary {
+    Aggregate<1> agg;
+    void add(const Point& p) { agg.add({(double)p.civ.startYear}); }
+    void merge(const YearSummary& other) { agg.merge(other.agg); }
+};
+
+// Per-node best spatial score, bounding KDIndex::topKInRange
+struct ScoreSummary {
+    double maxScore = numeric_limits<double>::lowest();
+    void add(const Civilization& c) { maxScore = max(maxScore, c.spatialScore()); }
+    void merge(const ScoreSummary& other) { maxScore = max(maxScore, other.maxScore); }
+};
+
 int main() {
     cout << "\n======================================================\n";
     cout << "          FULL SYSTEM VALIDATION TESTING          \n";
@@ -118,7 +146,22 @@ int main() {
                 match = false;
                 break;
             }
+
+            vector<Civilization> kdRange;
+            rangeSearch(kdRoot, qlat-5, qlat+5, qlon-5, qlon+5, 0, kdRange);
+            if (rtree.search(Rectangle(qlon-5, qlat-5, qlon+5, qlat+5)).size() != kdRange.size()) {
+                match = false;
+                break;
+            }
         }
+        // Visitors that stop early must see exactly the hits they asked for
+        int kdSeen = 0, rtSeen = 0;
+        bool kdDone = rangeVisit(kdRoot, -90, 90, -180, 180, 0,
+                                 [&](const Civilization&) { return ++kdSeen == 3 ? Visit::Stop : Visit::Continue; });
+        bool rtDone = rtree.search(Rectangle(-180, -90, 180, 90),
+                                   [&](const Point&) { return ++rtSeen == 3 ? Visit::Stop : Visit::Continue; });
+        if (kdDone || rtDone || kdSeen != 3 || rtSeen != 3) match = false;
+
         if(!match) {
             allTestsPass = false;
             cout << "  -> FAIL: NN mismatch between KD and R-Tree!\n";
@@ -161,7 +204,533 @@ int main() {
     }
 
     // ---------------------------------------------------------
-    // 5. SUMMARY
+    // 5. Snapshot Isolation (copy-on-write R-Tree)
+    // ---------------------------------------------------------
+    cout << "\n[TEST 5] Snapshot Isolation\n";
+    {
+        SnapshotRTree srtree(8);
+        RTree rtree(8);
+        vector<Point> pts;
+        for(int i=0; i<30000; i++) {
+            Civilization c{i, "Snapshot", lat_dis(gen), lon_dis(gen), 2000};
+            pts.push_back({c.longitude, c.latitude, c});
+        }
+        vector<Point> first(pts.begin(), pts.begin() + 20000);
+        srtree.insertBatch(first);
+        for(auto& p : first) rtree.insert(p);
+
+        RTreeSnapshot before = srtree.snapshot();
+        for(int i=20000; i<30000; i++) srtree.insert(pts[i]);
+        for(int i=0; i<5000; i++) srtree.remove(pts[i]);
+        RTreeSnapshot after = srtree.snapshot();
+
+        Rectangle world(-180, -90, 180, 90);
+        bool ok = before.search(world).size() == 20000 && before.size() == 20000 &&
+                  after.search(world).size() == 25000 && after.size() == 25000 &&
+                  after.getVersion() > before.getVersion();
+
+        for(int i=0; i<100 && ok; i++) {
+            Point q{lon_dis(gen), lat_dis(gen), Civilization()};
+            Civilization snapBest, rtBest;
+            double snapDist, rtDist;
+            before.nearestNeighbor(q, snapBest, snapDist);
+            rtree.nearestNeighbor(q, rtBest, rtDist);
+            if (abs(snapDist - rtDist) > 1e-6) ok = false;
+        }
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: Snapshot did not stay consistent under writes!\n";
+        } else {
+            cout << "  -> PASS: Old snapshot unchanged, new version sees writes.\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 6. Polygon Region Lookup vs Brute Force
+    // ---------------------------------------------------------
+    cout << "\n[TEST 6] Polygon Region Lookup\n";
+    {
+        // Random star-shaped polygons so both convex and concave edges are covered
+        vector<RegionPolygon> polys;
+        uniform_real_distribution<double> r_dis(1.0, 8.0);
+        for(int i=0; i<300; i++) {
+            RegionPolygon poly;
+            poly.label = "Poly" + to_string(i);
+            double clat = lat_dis(gen) * 0.8, clon = lon_dis(gen) * 0.9;
+            int verts = 3 + i % 14;
+            for(int v=0; v<verts; v++) {
+                double a = 2 * M_PI * v / verts;
+                double r = r_dis(gen);
+                poly.lats.push_back(clat + r * sin(a));
+                poly.lons.push_back(clon + r * cos(a));
+            }
+            polys.push_back(poly);
+        }
+        RegionIndex index;
+        index.build(polys);
+
+        auto bruteForce = [&](double lat, double lon) {
+            vector<int> ids;
+            for(size_t p=0; p<polys.size(); p++) {
+                const auto& P = polys[p];
+                bool inside = false;
+                for(size_t i=0, j=P.lats.size()-1; i<P.lats.size(); j=i++) {
+                    if(((P.lats[i] > lat) != (P.lats[j] > lat)) &&
+                       (lon < (P.lons[j]-P.lons[i]) * (lat-P.lats[i]) / (P.lats[j]-P.lats[i]) + P.lons[i]))
+                        inside = !inside;
+                }
+                if(inside) ids.push_back((int)p);
+            }
+            return ids;
+        };
+
+        bool ok = true;
+        int hits = 0;
+        vector<pair<double,double>> latLons;
+        for(int i=0; i<20000 && ok; i++) {
+            double qlat = lat_dis(gen), qlon = lon_dis(gen);
+            latLons.push_back({qlat, qlon});
+            auto expected = bruteForce(qlat, qlon);
+            if(index.locate(qlat, qlon) != expected) ok = false;
+            hits += !expected.empty();
+        }
+
+        auto assigned = index.assignAll(latLons, 4);
+        for(size_t i=0; i<latLons.size() && ok; i++) {
+            auto expected = bruteForce(latLons[i].first, latLons[i].second);
+            if(assigned[i] != (expected.empty() ? -1 : expected.front())) ok = false;
+        }
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: Polygon lookup disagrees with brute force!\n";
+        } else {
+            cout << "  -> PASS: " << hits << " polygon hits matched brute force.\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 7. Aggregate R-Tree vs Brute Force
+    // ---------------------------------------------------------
+    cout << "\n[TEST 7] Aggregate R-Tree\n";
+    {
+        BasicRTree<Point, YearSummary> atree(8);
+        vector<Point> pts;
+        uniform_int_distribution<int> year_dis(-3000, 2000);
+        for(int i=0; i<50000; i++) {
+            Civilization c{i, "Agg", lat_dis(gen), lon_dis(gen), year_dis(gen)};
+            pts.push_back({c.longitude, c.latitude, c});
+            atree.insert(pts.back());
+        }
+        for(int i=0; i<10000; i++) atree.remove(pts[i]);
+
+        bool ok = true;
+        for(int q=0; q<200 && ok; q++) {
+            double qlat = lat_dis(gen), qlon = lon_dis(gen), span = 1 + q % 60;
+            Rectangle box(qlon-span, qlat-span, qlon+span, qlat+span);
+            Aggregate<1> expected;
+            for(int i=10000; i<50000; i++)
+                if(box.contains(pts[i].x, pts[i].y)) expected.add({(double)pts[i].civ.startYear});
+            Aggregate<1> got = atree.rangeAggregate(box).agg;
+            if(got.count != expected.count || got.fields[0].sum != expected.fields[0].sum ||
+               (got.count && (got.fields[0].min != expected.fields[0].min || got.fields[0].max != expected.fields[0].max)))
+                ok = false;
+        }
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: Range aggregate disagrees with brute force!\n";
+        } else {
+            cout << "  -> PASS: Count/sum/min/max matched after inserts and removes.\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 8. Fixed Fan-out R-Tree vs Runtime R-Tree
+    // ---------------------------------------------------------
+    cout << "\n[TEST 8] Fixed Fan-out R-Tree\n";
+    {
+        FixedRTree<Point, 8> ftree;
+        RTree rtree(8);
+        for(int i=0; i<50000; i++) {
+            Civilization c{i, "Fixed", lat_dis(gen), lon_dis(gen), 2000};
+            ftree.insert({c.longitude, c.latitude, c});
+            rtree.insert({c.longitude, c.latitude, c});
+        }
+
+        bool ok = ftree.size() == 50000;
+        for(int i=0; i<200 && ok; i++) {
+            double qlat = lat_dis(gen), qlon = lon_dis(gen);
+            Point fBest; Civilization rtBest;
+            double fDist, rtDist;
+            ftree.nearest(qlon, qlat, fBest, fDist);
+            rtree.nearestNeighbor({qlon, qlat, Civilization()}, rtBest, rtDist);
+            if (abs(fDist - rtDist) > 1e-6) ok = false;
+
+            Rectangle rect(qlon-5, qlat-5, qlon+5, qlat+5);
+            if (ftree.intersecting(rect).size() != rtree.search(rect).size()) ok = false;
+        }
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: Fixed fan-out tree disagrees with runtime R-Tree!\n";
+        } else {
+            cout << "  -> PASS: NN and range results matched (height " << ftree.getHeight() << ").\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 9. SpatialIndex Engines vs Brute Force
+    // ---------------------------------------------------------
+    cout << "\n[TEST 9] SpatialIndex Engines\n";
+    {
+        static_assert(isSpatialIndex<KDIndex<Civilization>>, "KDIndex must be a SpatialIndex");
+        static_assert(isSpatialIndex<RTree>, "RTree must be a SpatialIndex");
+
+        vector<Civilization> civs;
+        uniform_real_distribution<double> attr_dis(0.0, 100.0);
+        for(int i=0; i<20000; i++)
+            civs.push_back({i, "Index", lat_dis(gen), lon_dis(gen), 2000, 2100, "",
+                            attr_dis(gen), attr_dis(gen), attr_dis(gen)});
+        KDIndex<Civilization, ScoreSummary> kd;
+        RTree rtree(8);
+        kd.build(civs);
+        rtree.build(civs);
+
+        auto dist = [](const Civilization& c, double lat, double lon) {
+            return sqrt((c.latitude-lat)*(c.latitude-lat) + (c.longitude-lon)*(c.longitude-lon));
+        };
+
+        bool ok = kd.size() == civs.size() && rtree.size() == civs.size();
+        for(int q=0; q<200 && ok; q++) {
+            double qlat = lat_dis(gen), qlon = lon_dis(gen), span = 1 + q % 20;
+
+            vector<double> expected;
+            for (const auto& c : civs) expected.push_back(dist(c, qlat, qlon));
+            sort(expected.begin(), expected.end());
+
+            double kdDist, rtDist;
+            kd.nearest(qlat, qlon, kdDist);
+            rtree.nearest(qlat, qlon, rtDist);
+            if (abs(kdDist - expected[0]) > 1e-9 || abs(rtDist - expected[0]) > 1e-9) ok = false;
+
+            auto kdK = kd.kNearest(qlat, qlon, 10), rtK = rtree.kNearest(qlat, qlon, 10);
+            if (kdK.size() != 10 || rtK.size() != 10) ok = false;
+            for (size_t i = 0; ok && i < 10; i++)
+                if (abs(kdK[i].dist - expected[i]) > 1e-9 || abs(rtK[i].dist - expected[i]) > 1e-9) ok = false;
+
+            size_t inBox = 0, inRadius = 0;
+            for (const auto& c : civs) {
+                if (c.latitude >= qlat-span && c.latitude <= qlat+span &&
+                    c.longitude >= qlon-span && c.longitude <= qlon+span) inBox++;
+                if (dist(c, qlat, qlon) <= span) inRadius++;
+            }
+            size_t kdRange = 0, rtRange = 0, kdRadius = 0, rtRadius = 0;
+            kd.range(qlat-span, qlat+span, qlon-span, qlon+span, [&](const Civilization&) { kdRange++; });
+            rtree.range(qlat-span, qlat+span, qlon-span, qlon+span, [&](const Civilization&) { rtRange++; });
+            kd.radius(qlat, qlon, span, [&](const Civilization&) { kdRadius++; });
+            rtree.radius(qlat, qlon, span, [&](const Civilization&) { rtRadius++; });
+            if (kdRange != inBox || rtRange != inBox || kdRadius != inRadius || rtRadius != inRadius) ok = false;
+            if (kd.count(qlat-span, qlat+span, qlon-span, qlon+span) != inBox ||
+                rtree.count(qlat-span, qlat+span, qlon-span, qlon+span) != inBox) ok = false;
+
+            // Resumed in small steps, the cursor yields range()'s sequence
+            vector<const Civilization*> visited, resumed;
+            kd.range(qlat-span, qlat+span, qlon-span, qlon+span, [&](const Civilization& c) { visited.push_back(&c); });
+            auto cursor = kd.rangeCursor(qlat-span, qlat+span, qlon-span, qlon+span);
+            while (!cursor.done()) cursor.next(7, [&](const Civilization& c) { resumed.push_back(&c); });
+            if (resumed != visited) ok = false;
+
+            vector<double> scores;
+            for (const auto& c : civs)
+                if (c.latitude >= qlat-span*4 && c.latitude <= qlat+span*4 &&
+                    c.longitude >= qlon-span*4 && c.longitude <= qlon+span*4) scores.push_back(c.spatialScore());
+            sort(scores.rbegin(), scores.rend());
+            scores.resize(min<size_t>(scores.size(), 10));
+            auto kdTop = kd.topKInRange(qlat-span*4, qlat+span*4, qlon-span*4, qlon+span*4, 10,
+                                        [](const Civilization& c) { return c.spatialScore(); },
+                                        [](const ScoreSummary& s) { return s.maxScore; });
+            auto rtTop = rtree.topKInRange(qlat-span*4, qlat+span*4, qlon-span*4, qlon+span*4, 10);
+            if (kdTop.size() != scores.size() || rtTop.size() != scores.size()) ok = false;
+            for (size_t i = 0; ok && i < scores.size(); i++)
+                if (kdTop[i].score != scores[i] || rtTop[i].score != scores[i]) ok = false;
+
+            // Filtered overloads, as used to skip records edited since a base snapshot
+            auto keep = [](const Civilization& c) { return c.id % 3 != 0; };
+            double keptNearest = numeric_limits<double>::max(), keptMax = numeric_limits<double>::lowest();
+            vector<double> keptScores;
+            vector<pair<double, double>> holes;
+            for (const auto& c : civs) {
+                if (!keep(c)) { holes.push_back({c.latitude, c.longitude}); continue; }
+                keptNearest = min(keptNearest, dist(c, qlat, qlon));
+                if (c.latitude >= qlat-span*4 && c.latitude <= qlat+span*4 &&
+                    c.longitude >= qlon-span*4 && c.longitude <= qlon+span*4) {
+                    keptScores.push_back(c.spatialScore());
+                    keptMax = max(keptMax, c.spatialScore());
+                }
+            }
+            sort(keptScores.rbegin(), keptScores.rend());
+            keptScores.resize(min<size_t>(keptScores.size(), 10));
+            NoStats noStats;
+            const Civilization* kept = kd.nearest(qlat, qlon, kdDist, noStats, keep);
+            if (!kept || !keep(*kept) || abs(kdDist - keptNearest) > 1e-9) ok = false;
+            auto keptTop = kd.topKInRange(qlat-span*4, qlat+span*4, qlon-span*4, qlon+span*4, 10,
+                                          [](const Civilization& c) { return c.spatialScore(); },
+                                          [](const ScoreSummary& s) { return s.maxScore; }, keep);
+            if (keptTop.size() != keptScores.size()) ok = false;
+            for (size_t i = 0; ok && i < keptScores.size(); i++)
+                if (keptTop[i].score != keptScores[i]) ok = false;
+            if (kd.rangeAggregate(qlat-span*4, qlat+span*4, qlon-span*4, qlon+span*4, holes, keep).maxScore != keptMax)
+                ok = false;
+        }
+        double emptyDist;
+        if (KDIndex<Civilization, ScoreSummary>().nearest(0, 0, emptyDist) || RTree(8).nearest(0, 0, emptyDist)) ok = false;
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: KD / R-Tree engines disagree with brute force!\n";
+        } else {
+            cout << "  -> PASS: nearest, kNN, range, radius, count and top-k matched on both engines; KD cursor resumed in order; filtered KD queries matched.\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 10. Interval Tree vs Brute Force
+    // ---------------------------------------------------------
+    cout << "\n[TEST 10] Interval Tree\n";
+    {
+        uniform_int_distribution<int> start_dis(-3000, 2000), len_dis(0, 800);
+        vector<pair<int, int>> eras;
+        for(int i=0; i<50000; i++) {
+            int start = start_dis(gen);
+            eras.push_back({start, start + len_dis(gen)});
+        }
+        eras.push_back({100, 50}); // reversed: never reported
+        IntervalTree tree;
+        tree.build(eras);
+
+        bool ok = tree.size() == eras.size() - 1;
+        for(int q=0; q<300 && ok; q++) {
+            int from = start_dis(gen), to = from + (q % 3 == 0 ? 0 : len_dis(gen));
+            vector<uint32_t> expected, found;
+            for (uint32_t i = 0; i < eras.size(); i++)
+                if (eras[i].first <= eras[i].second && eras[i].first <= to && eras[i].second >= from) expected.push_back(i);
+            tree.overlapping(from, to, [&](uint32_t pos) { found.push_back(pos); });
+            sort(found.begin(), found.end());
+            if (found != expected) ok = false;
+        }
+        size_t stopped = 0;
+        tree.stab(0, [&](uint32_t) { return ++stopped == 3 ? Visit::Stop : Visit::Continue; });
+        if (stopped != 3) ok = false;
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: interval tree disagrees with brute force!\n";
+        } else {
+            cout << "  -> PASS: stabbing and overlap queries matched brute force.\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 11. DELAUNAY NEAREST vs KD-TREE
+    // ---------------------------------------------------------
+    cout << "\n[TEST 11] Delaunay Nearest vs KD-Tree\n";
+    {
+        // Random points plus a grid (cocircular everywhere), repeated
+        // points and a collinear run
+        vector<pair<double, double>> latLons;
+        for(int i=0; i<50000; i++) latLons.push_back({lat_dis(gen), lon_dis(gen)});
+        for(int i=0; i<40; i++)
+            for(int j=0; j<40; j++) latLons.push_back({20 + i*0.1, 40 + j*0.1});
+        for(int i=0; i<200; i++) latLons.push_back(latLons[gen() % latLons.size()]);
+        for(int i=0; i<100; i++) latLons.push_back({-60 + i*0.01, -120 + i*0.02});
+
+        KDNode* kdRoot = nullptr;
+        for(int i=0; i<(int)latLons.size(); i++)
+            kdRoot = insertKD(kdRoot, Civilization{i, "Voronoi", latLons[i].first, latLons[i].second, 2000}, 0);
+        Delaunay dt;
+        dt.build(latLons);
+
+        bool ok = dt.exact();
+        double kdUs = 0, dtUs = 0;
+        const int QUERIES = 2000;
+        for(int q=0; q<QUERIES && ok; q++) {
+            double qlat = lat_dis(gen), qlon = lon_dis(gen);
+            if (q % 2) { // map clicks land near a site, often right on it
+                const auto& p = latLons[gen() % latLons.size()];
+                qlat = p.first + (q % 4 == 1 ? 0.0 : 0.001);
+                qlon = p.second;
+            }
+            Civilization kdBest;
+            double kdDist = 1e9, dtDist;
+            auto t0 = high_resolution_clock::now();
+            nearestNeighbor(kdRoot, qlat, qlon, kdBest, kdDist, 0);
+            auto t1 = high_resolution_clock::now();
+            long pos = dt.nearest(qlat, qlon, dtDist);
+            auto t2 = high_resolution_clock::now();
+            kdUs += duration<double, micro>(t1 - t0).count();
+            dtUs += duration<double, micro>(t2 - t1).count();
+            if (pos < 0 || abs(kdDist - dtDist) > 1e-9 ||
+                abs(distance(qlat, qlon, latLons[pos].first, latLons[pos].second) - dtDist) > 1e-9) ok = false;
+        }
+
+        // Interior grid point: a 0.1-degree square cell with its four neighbours among the Voronoi neighbours
+        vector<pair<double, double>> cell;
+        size_t gridPos = 50000 + 20*40 + 20;
+        bool bounded = dt.cell((uint32_t)gridPos, cell);
+        if (!bounded || cell.size() != 4) ok = false;
+        for (const auto& v : cell)
+            if (abs(abs(v.first - latLons[gridPos].first) - 0.05) > 1e-9 ||
+                abs(abs(v.second - latLons[gridPos].second) - 0.05) > 1e-9) ok = false;
+        vector<uint32_t> nbrs = dt.neighbors((uint32_t)gridPos);
+        for (size_t side : {gridPos - 40, gridPos + 40, gridPos - 1, gridPos + 1})
+            if (find(nbrs.begin(), nbrs.end(), side) == nbrs.end()) ok = false;
+        deleteKDTree(kdRoot);
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: Delaunay walk disagrees with KD-Tree nearest!\n";
+        } else {
+            cout << "  -> PASS: " << QUERIES << " nearest queries matched (" << dt.size() << " sites, "
+                 << dt.triangleCount() << " triangles).\n";
+            cout << "     Avg KD " << kdUs / QUERIES << " us, Delaunay walk " << dtUs / QUERIES << " us\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 12. Civframe Round Trip
+    // ---------------------------------------------------------
+    cout << "\n[TEST 12] Civframe Round Trip\n";
+    {
+        auto rejects = [](const string& frame) {
+            try { CivFrameData::parse(frame); return false; }
+            catch (const runtime_error&) { return true; }
+        };
+
+        // Two float columns, unsigned and zigzag varints, dictionary strings
+        const uint32_t ROWS = 5000;
+        const string names[] = {"Sumer", "", "Nile \"Delta\"", "\xC3\x87" "atalh\xC3\xB6" "y\xC3\xBC" "k"};
+        uniform_int_distribution<int64_t> year_dis(-100000, 3000);
+        vector<double> lats, lons;
+        vector<uint64_t> ids;
+        vector<int64_t> years;
+        CivFrameBuilder b(2, 3);
+        b.reserve(ROWS);
+        for(uint32_t i=0; i<ROWS; i++) {
+            lats.push_back(lat_dis(gen));
+            lons.push_back(i == 0 ? -0.0 : lon_dis(gen));
+            ids.push_back(i == 1 ? numeric_limits<uint64_t>::max() : (uint64_t)i * 1000003);
+            years.push_back(i == 2 ? numeric_limits<int64_t>::min() : i == 3 ? numeric_limits<int64_t>::max() : year_dis(gen));
+            b.f64(0, lats.back());
+            b.f64(1, lons.back());
+            b.uvarint(0, ids.back());
+            b.svarint(1, years.back());
+            b.uvarint(2, b.intern(names[i % 4]));
+        }
+        string frame = b.finish(ROWS, CivFrame::FLAG_TRUNCATED);
+        CivFrameData d = CivFrameData::parse(frame);
+
+        bool ok = d.rows == ROWS && d.flags == CivFrame::FLAG_TRUNCATED &&
+                  d.f64.size() == 2 && d.varints.size() == 3 && d.dict.size() == 4;
+        for(uint32_t i=0; ok && i<ROWS; i++) {
+            if (memcmp(&d.f64[0][i], &lats[i], sizeof(double)) != 0 ||
+                memcmp(&d.f64[1][i], &lons[i], sizeof(double)) != 0 ||
+                d.varints[0][i] != ids[i] || CivFrame::unzigzag(d.varints[1][i]) != years[i] ||
+                d.varints[2][i] >= d.dict.size() || d.dict[d.varints[2][i]] != names[i % 4]) ok = false;
+        }
+
+        // No float columns, and no columns at all
+        CivFrameBuilder v(0, 1);
+        for (int64_t x : {-1, 0, 63, -64, 64}) v.svarint(0, x);
+        CivFrameData dv = CivFrameData::parse(v.finish(5));
+        if (dv.rows != 5 || !dv.f64.empty() || dv.varints.size() != 1 ||
+            CivFrame::unzigzag(dv.varints[0][0]) != -1 || CivFrame::unzigzag(dv.varints[0][3]) != -64 ||
+            CivFrame::unzigzag(dv.varints[0][4]) != 64) ok = false;
+        CivFrameData de = CivFrameData::parse(CivFrameBuilder(0, 0).finish(0));
+        if (de.rows != 0 || !de.f64.empty() || !de.varints.empty() || !de.dict.empty()) ok = false;
+
+        // Malformed: every truncation, a bad magic, and a forged row count
+        // that must be refused before anything is allocated
+        for (size_t n = 0; ok && n < frame.size(); n += 1 + n / 8)
+            if (!rejects(frame.substr(0, n))) ok = false;
+        string badMagic = frame;
+        badMagic[0] = 'X';
+        string forged = v.finish(0xFFFFFFFFu);
+        forged.resize(CivFrame::HEADER_SIZE + 8);
+        string forgedF64 = b.finish(0x40000000u).substr(0, CivFrame::HEADER_SIZE + 64);
+        if (!rejects(badMagic) || !rejects(forged) || !rejects(forgedF64)) ok = false;
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: Civframe did not round-trip or accepted a malformed frame!\n";
+        } else {
+            cout << "  -> PASS: " << ROWS << " rows round-tripped (" << frame.size() << " bytes); "
+                 << "varint-only and empty frames decoded; malformed frames rejected.\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 13. Cluster Pyramid vs Brute Force
+    // ---------------------------------------------------------
+    cout << "\n[TEST 13] Cluster Pyramid\n";
+    {
+        // Random points (many beyond the Mercator limit), a dense city, the
+        // antimeridian and repeated points
+        vector<pair<double, double>> latLons;
+        for(int i=0; i<20000; i++) latLons.push_back({lat_dis(gen), lon_dis(gen)});
+        uniform_real_distribution<double> city_dis(-0.01, 0.01);
+        for(int i=0; i<5000; i++) latLons.push_back({48.85 + city_dis(gen), 2.35 + city_dis(gen)});
+        for(int i=0; i<50; i++) latLons.push_back({lat_dis(gen), i % 2 ? 180.0 : -180.0});
+        for(int i=0; i<100; i++) latLons.push_back(latLons[gen() % latLons.size()]);
+
+        ClusterPyramid pyr;
+        pyr.build(latLons);
+        vector<uint64_t> codes;
+        for (const auto& p : latLons) codes.push_back(ClusterPyramid::cellCode(p.first, p.second));
+
+        bool ok = pyr.topZoom() >= 0;
+        size_t clusters = 0;
+        for(int z=0; ok && z<=pyr.topZoom(); z++) {
+            int shift = ClusterPyramid::cellShift(z);
+            map<uint64_t, uint32_t> expected; // zoom-z cell -> point count
+            set<pair<uint32_t, uint32_t>> tiles;
+            for(size_t i=0; i<latLons.size(); i++) {
+                expected[codes[i] >> shift]++;
+                tiles.insert(ClusterPyramid::tileOf(latLons[i].first, latLons[i].second, z));
+            }
+
+            // Every point lands in exactly one cluster of its own tile
+            size_t total = 0, seen = 0;
+            for (const auto& [x, y] : tiles) {
+                auto [first, last] = pyr.tile(z, x, y);
+                for (const TileCluster* c = first; c != last; ++c, ++seen) {
+                    const auto& p = latLons[c->first];
+                    TileBox box = ClusterPyramid::cellBounds(z, c->code);
+                    total += c->count;
+                    if (ClusterPyramid::tileOf(p.first, p.second, z) != make_pair(x, y) ||
+                        (codes[c->first] >> shift) != (c->code >> shift) ||
+                        expected[c->code >> shift] != c->count ||
+                        p.first < box.latMin - 1e-9 || p.first > box.latMax + 1e-9 ||
+                        p.second < box.lonMin - 1e-9 || p.second > box.lonMax + 1e-9) ok = false;
+                }
+            }
+            if (total != latLons.size() || seen != expected.size()) ok = false;
+            clusters += seen;
+        }
+        if (clusters != pyr.clusterCount() || pyr.tile(pyr.topZoom() + 1, 0, 0).first != nullptr) ok = false;
+
+        if(!ok) {
+            allTestsPass = false;
+            cout << "  -> FAIL: Cluster pyramid disagrees with brute-force grouping!\n";
+        } else {
+            cout << "  -> PASS: " << latLons.size() << " points counted once per zoom 0-" << pyr.topZoom()
+                 << " (" << clusters << " clusters).\n";
+        }
+    }
+
+    // ---------------------------------------------------------
+    // 14. SUMMARY
     // ---------------------------------------------------------
     cout << "\n======================================================\n";
     cout << "             VALIDATION SUMMARY               \n";
@@ -7,14 +7,62 @@
  *
  *   ENDPOINTS:
  *     GET /api/civilizations          → all civilizations as JSON
- *     GET /api/nearest?lat=&lon=      → KD-Tree nearest neighbor
- *     GET /api/range?latMin=&latMax=&lonMin=&lonMax=  → range query
- *     GET /api/compare?a=&b=          → compare two civilizations
- *     GET /api/rtree?lat=&lon=        → R-Tree region lookup
+ *     POST   /api/civilizations       → add one (JSON body), 201 + id
+ *     PUT    /api/civilizations/:id   → update the given fields
+ *     DELETE /api/civilizations/:id   → remove one
+ *     GET /api/nearest?lat=&lon=      → KD-Tree nearest neighbor (grid-cell cached)
+ *     GET /api/range?latMin=&latMax=&lonMin=&lonMax=[&limit=&offset=]  → range query
+ *         [&orderBy=score]            → top `limit` (default 10) by spatial score
+ *     GET /api/compare?a=&b=          → compare two civilizations (hashed name lookup)
+ *     GET /api/search?prefix=[&limit=] → names starting with prefix
+ *     GET /api/rtree?lat=&lon=        → R-Tree + point-in-polygon region lookup
+ *     GET /api/aggregate?latMin=&latMax=&lonMin=&lonMax=[&fields=a,b]
+ *                                     → count/sum/min/max/avg over the box
+ *     GET /api/active?year= | from=&to= | of=[&latMin=&latMax=&lonMin=&lonMax=]
+ *                                     → active in a year / overlapping a period /
+ *                                       contemporaries (interval tree), optionally
+ *                                       intersected with a spatial range by id
+ *     GET /api/voronoi/:id            → Voronoi neighbours and cell (Delaunay triangulation)
  *     GET /api/stats                  → complexity stats
+ *     GET /api/tiles/{z}/{x}/{y}      → marker clusters (count + centroid) of one
+ *                                       Web-Mercator map tile, cached per version
+ *     GET /api/cache                  → nearest/tile cache hit/miss counters
+ *     GET /api/metrics                → Prometheus metrics (latency, phases, sizes)
+ *     POST /api/admin/reload          → rebuild from the CSVs in the background
+ *                                       and swap it in (also on SIGHUP)
+ *
+ *   /api/civilizations and /api/range answer `Accept: application/x-civframe`
+ *   with a columnar binary frame (see utils/civframe.h) instead of JSON.
+ *   JSON /api/range results are streamed with chunked transfer encoding,
+ *   except pages of at most CIVMAP_COALESCE_MAX_ROWS rows (default 4096).
+ *   Identical /api/nearest and buffered /api/range requests in flight at
+ *   the same time are coalesced: one renders, the others reuse its body.
+ *   CIVMAP_NEAREST_INDEX=delaunay answers /api/nearest by an exact walk on
+ *   the Delaunay triangulation (robust predicates, verified after each
+ *   build) instead of the KD-tree.
+ *   /api/nearest and /api/range add the query's work counters (nodes
+ *   visited, distance evaluations, pruning) with ?explain=1.
+ *
+ *   /api/civilizations and /api/stats are served from a per-dataset-version
+ *   cache (identity/gzip/deflate) with ETag/Last-Modified revalidation.
+ *
+ *   Writes are batched (CIVMAP_WRITE_BATCH_MS, default 5) and published as a
+ *   new immutable dataset snapshot; reads never wait for them. A snapshot is
+ *   a shared base plus a small delta of edits, so a batch costs O(d log d)
+ *   in the delta size; the delta is merged into a new base in the background
+ *   once it reaches CIVMAP_MERGE_EDITS edits (default 4096) or writes pause
+ *   for CIVMAP_MERGE_IDLE_MS (default 1000).
+ *
+ *   Requests are served by CIVMAP_WORKERS threads behind a queue of at most
+ *   CIVMAP_MAX_QUEUE connections; beyond that they get 503 + Retry-After.
+ *   Each request has a CIVMAP_REQUEST_TIMEOUT_MS deadline (queue wait
+ *   included) that long traversals check to stop early.
+ *
+ *   Logging is asynchronous (utils/logger.h). CIVMAP_LOG_LEVEL sets the
+ *   threshold and CIVMAP_LOG_REQUESTS_PER_SEC (default 100) caps request lines.
  *
  *   COMPILE:
- *     g++ -std=c++17 -o server civilization_mapper.cpp -lpthread
+ *     make            (or see SRC in the Makefile for the file list)
  *
  *   RUN:
  *     ./server          (starts on http://localhost:8080)
@@ -24,302 +72,2113 @@
  * ============================================================
  */
 
+#include "core/civilization.h"
+#include "core/kd_index.h"
+#include "core/regions/region_index.h"
+#include "core/temporal/interval_tree.h"
+#include "core/tiles/cluster_pyramid.h"
+#include "core/voronoi/delaunay.h"
+#include "core/visit.h"
+#include "core/aggregate.h"
+#include "core/query_stats.h"
+#include "data/region_loader.h"
+#include "utils/json_writer.h"
+#include "utils/json_reader.h"
+#include "utils/civ_record.h"
+#include "utils/compress.h"
+#include "utils/sharded_lru.h"
+#include "utils/single_flight.h"
+#include "utils/civframe.h"
+#include "utils/metrics.h"
+#include "utils/logger.h"
+
+// wingdi.h (pulled in by winsock2.h) declares a Rectangle() function that
+// would shadow the spatial core's Rectangle struct.
+#ifdef _WIN32
+#define NOGDI
+#endif
 #include "httplib.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <cmath>
+#include <cstdint>
 #include <algorithm>
 #include <fstream>
 #include <sstream>
 #include <limits>
-#include <iomanip>
 #include <stdexcept>
+#include <array>
+#include <unordered_map>
+#include <atomic>
+#include <cstdlib>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <future>
+#include <optional>
+#include <chrono>
+#include <random>
+#ifndef _WIN32
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// ─────────────────────────────────────────────
+//  AGGREGATES
+// ─────────────────────────────────────────────
+
+// Attributes summarised per KD subtree, in CivAggregate field order
+const char* const AGG_FIELDS[] = {
+    "resource_density", "knowledge_density", "military_strength", "spatial_score"
+};
+const size_t AGG_FIELD_COUNT = 4;
+const size_t AGG_SCORE = 3; // spatial_score; its per-node max bounds top-k by score
+using CivAggregate = Aggregate<AGG_FIELD_COUNT>;
+
+array<double, AGG_FIELD_COUNT> aggValues(const Civilization& c) {
+    return {c.resourceDensity, c.knowledgeDensity, c.militaryStrength, c.spatialScore()};
+}
+
+// Per-node summary for the KD index (see core/kd_index.h)
+struct CivSummary : CivAggregate {
+    using CivAggregate::add;
+    void add(const Civilization& c) { add(aggValues(c)); }
+};
+
+// ─────────────────────────────────────────────
+//  KD-TREE (core/kd_index.h)
+// ─────────────────────────────────────────────
+
+using KDTree = KDIndex<CivRecord, CivSummary>;
+static_assert(isSpatialIndex<KDTree>, "KDTree must meet the SpatialIndex requirements");
+
+// ─────────────────────────────────────────────
+//  NAME INDEX
+// ─────────────────────────────────────────────
+
+// Lower-cases ASCII letters, trims, and collapses whitespace runs to one space
+string normalizeName(const string& s) {
+    string out;
+    out.reserve(s.size());
+    bool pendingSpace = false;
+    for (char ch : s) {
+        unsigned char c = (unsigned char)ch;
+        if (isspace(c)) { pendingSpace = !out.empty(); continue; }
+        if (pendingSpace) { out += ' '; pendingSpace = false; }
+        out += (char)tolower(c);
+    }
+    return out;
+}
+
+// Name → record position in the dataset. The hash map serves exact lookups in
+// one probe; the sorted array serves prefix lookups by binary search.
+// Lookups are case-insensitive and whitespace-normalised; on duplicate names
+// the first record added wins.
+class NameIndex {
+private:
+    unordered_map<string, size_t> exact;
+    vector<pair<string, size_t>>  sorted; // by normalised name
+
+public:
+    void clear() { exact.clear(); sorted.clear(); }
+
+    void build(const vector<CivRecord>& civs) {
+        clear();
+        exact.reserve(civs.size());
+        sorted.reserve(civs.size());
+        for (size_t i = 0; i < civs.size(); i++) {
+            string key = normalizeName(civs[i].name);
+            exact.emplace(key, i);
+            sorted.emplace_back(move(key), i);
+        }
+        stable_sort(sorted.begin(), sorted.end(),
+                    [](const pair<string, size_t>& a, const pair<string, size_t>& b) { return a.first < b.first; });
+    }
+
+    void add(const string& name, size_t idx) {
+        string key = normalizeName(name);
+        exact.emplace(key, idx);
+        auto pos = upper_bound(sorted.begin(), sorted.end(), key,
+                               [](const string& k, const pair<string, size_t>& e) { return k < e.first; });
+        sorted.insert(pos, {move(key), idx});
+    }
+
+    // Position of the record, or -1. Positions rejected by keep(pos) are
+    // skipped, falling back to the next record of the same name.
+    template <typename Keep = KeepAll>
+    long find(const string& name, Keep&& keep = Keep()) const {
+        string key = normalizeName(name);
+        auto it = exact.find(key);
+        if (it == exact.end()) return -1;
+        if (keep(it->second)) return (long)it->second;
+        auto first = lower_bound(sorted.begin(), sorted.end(), key,
+                                 [](const pair<string, size_t>& e, const string& k) { return e.first < k; });
+        for (; first != sorted.end() && first->first == key; ++first)
+            if (keep(first->second)) return (long)first->second;
+        return -1;
+    }
+
+    // Up to `limit` (normalised name, position) pairs whose name starts with
+    // `prefix`, in name order, skipping positions rejected by keep(pos)
+    template <typename Keep = KeepAll>
+    vector<pair<string, size_t>> withPrefix(const string& prefix, size_t limit, Keep&& keep = Keep()) const {
+        string key = normalizeName(prefix);
+        vector<pair<string, size_t>> out;
+        auto it = lower_bound(sorted.begin(), sorted.end(), key,
+                              [](const pair<string, size_t>& e, const string& k) { return e.first < k; });
+        for (; it != sorted.end() && out.size() < limit; ++it) {
+            if (it->first.compare(0, key.size(), key) != 0) break;
+            if (keep(it->second)) out.push_back(*it);
+        }
+        return out;
+    }
+};
+
+// ─────────────────────────────────────────────
+//  JSON HELPERS
+// ─────────────────────────────────────────────
+
+// Escape quotes, backslashes and control characters for JSON safety
+string jsonEscape(const string& s) {
+    string out;
+    JsonWriter::escapeTo(out, s);
+    return out;
+}
+
+// ?explain=1: the query's work counters instead of guessing from O(log n)
+bool wantsExplain(const httplib::Request& req) {
+    return req.get_param_value("explain") == "1";
+}
+
+void writeQueryStats(JsonWriter& w, const QueryStats& s) {
+    w.raw("{\"nodes_visited\":").number(s.nodesVisited)
+     .raw(",\"leaves_scanned\":").number(s.leavesScanned)
+     .raw(",\"distance_evals\":").number(s.distanceEvals)
+     .raw(",\"heap_pushes\":").number(s.heapPushes)
+     .raw(",\"subtrees_pruned\":").number(s.subtreesPruned)
+     .raw(",\"pruning_ratio\":").number(s.pruningRatio(), 4)
+     .raw('}');
+}
+
+// ─────────────────────────────────────────────
+//  BINARY FRAMES (application/x-civframe)
+// ─────────────────────────────────────────────
+
+const char* const CIVFRAME_TYPE = "application/x-civframe";
+
+// Column order of civilization frames
+enum CivF64Column    { COL_LAT, COL_LON, COL_RESOURCE, COL_KNOWLEDGE, COL_MILITARY, COL_SCORE, CIV_F64_COLS };
+enum CivVarintColumn { COL_ID, COL_START, COL_END, COL_NAME, COL_REGION, CIV_VARINT_COLS };
+
+CivFrameBuilder civFrameBuilder() { return CivFrameBuilder(CIV_F64_COLS, CIV_VARINT_COLS); }
+
+void appendCivRow(CivFrameBuilder& b, const CivRecord& c) {
+    b.f64(COL_LAT,       c.latitude);
+    b.f64(COL_LON,       c.longitude);
+    b.f64(COL_RESOURCE,  c.resourceDensity);
+    b.f64(COL_KNOWLEDGE, c.knowledgeDensity);
+    b.f64(COL_MILITARY,  c.militaryStrength);
+    b.f64(COL_SCORE,     c.spatialScore());
+    b.uvarint(COL_ID,     (uint64_t)c.id);
+    b.svarint(COL_START,  c.startYear);
+    b.svarint(COL_END,    c.endYear);
+    b.uvarint(COL_NAME,   b.intern(c.name));
+    b.uvarint(COL_REGION, b.intern(c.region));
+}
+
+bool wantsCivFrame(const httplib::Request& req) {
+    return req.get_header_value("Accept").find(CIVFRAME_TYPE) != string::npos;
+}
+
+// ─────────────────────────────────────────────
+//  CSV LOADER
+// ─────────────────────────────────────────────
+
+vector<CivRecord> loadFromCSV(const string& filename) {
+    vector<CivRecord> civs;
+    ifstream file(filename);
+    if (!file.is_open()) {
+        LOG_WARN("Could not open " << filename << " — using built-in data.");
+        return civs;
+    }
+    string line;
+    getline(file, line); // skip header
+    while (getline(file, line)) {
+        if (line.empty()) continue;
+        istringstream ss(line);
+        CivRecord c;
+        string tok;
+        getline(ss, c.name,   ',');
+        getline(ss, tok, ','); c.latitude         = stod(tok);
+        getline(ss, tok, ','); c.longitude        = stod(tok);
+        getline(ss, tok, ','); c.startYear        = stoi(tok);
+        getline(ss, tok, ','); c.endYear          = stoi(tok);
+        getline(ss, c.region, ',');
+        getline(ss, tok, ','); c.resourceDensity  = stod(tok);
+        getline(ss, tok, ','); c.knowledgeDensity = stod(tok);
+        getline(ss, tok, ','); c.militaryStrength = stod(tok);
+        civs.push_back(c);
+    }
+    return civs;
+}
+
+vector<CivRecord> getBuiltinData() {
+    const Civilization rows[] = {
+        {-1, "Indus Valley",    27.0,  68.0,-3300,-1300,"South Asia",   88,85,60},
+        {-1, "Ancient Egypt",   26.8,  30.8,-3100, -332,"North Africa", 80,78,81},
+        {-1, "Mesopotamia",     33.0,  44.4,-3500, -539,"Middle East",  78,80,75},
+        {-1, "Ancient Greece",  37.9,  23.7, -800, -146,"Mediterranean",70,95,72},
+        {-1, "Roman Empire",    41.9,  12.5,  -27,  476,"Mediterranean",80,70,88},
+        {-1, "Maurya Empire",   25.0,  83.0, -322, -185,"South Asia",   85,88,85},
+        {-1, "Han China",       35.0, 105.0, -206,  220,"East Asia",    88,90,85},
+        {-1, "Maya",            16.0, -89.0,  250,  900,"Mesoamerica",  70,88,65},
+        {-1, "Persian Empire",  32.0,  53.0, -550, -330,"Middle East",  85,75,90},
+        {-1, "Byzantine",       41.0,  29.0,  330, 1453,"Mediterranean",75,80,78},
+        {-1, "Vedic India",     28.0,  77.0,-1500, -600,"South Asia",   75,92,70},
+        {-1, "Aztec",           19.4, -99.1, 1300, 1521,"Mesoamerica",  72,80,85},
+        {-1, "Mongol Empire",   47.0, 106.0, 1206, 1368,"Central Asia", 65,60,98},
+        {-1, "Ottoman Empire",  39.9,  32.9, 1299, 1922,"Middle East",  80,72,88},
+        {-1, "Inca",           -13.5, -72.0, 1400, 1533,"South America",78,75,82},
+        {-1, "Gupta Empire",    24.5,  82.5,  320,  550,"South Asia",   85,95,78},
+        {-1, "Chola Dynasty",   10.8,  79.7,  300, 1279,"South India",  82,88,86},
+        {-1, "Vijayanagara",    15.3,  76.5, 1336, 1646,"South India",  80,85,84},
+        {-1, "Maratha Empire",  18.5,  73.8, 1674, 1818,"South Asia",   78,75,92},
+        {-1, "Delhi Sultanate", 28.6,  77.2, 1206, 1526,"South Asia",   76,72,88},
+        {-1, "Mughal Empire",   27.2,  78.0, 1526, 1857,"South Asia",   90,88,90},
+        {-1, "Pallava Dynasty", 12.8,  79.7,  275,  897,"South India",  78,87,80},
+        {-1, "Satavahana",      17.0,  79.5, -230,  220,"South Asia",   80,82,78},
+        {-1, "Kushana Empire",  34.0,  67.0,   30,  375,"Central Asia", 82,80,85},
+        {-1, "Rashtrakuta",     17.3,  76.8,  753,  982,"South India",  79,84,83},
+        {-1, "Pala Empire",     25.6,  85.1,  750, 1161,"South Asia",   77,90,76},
+        {-1, "Chera Kingdom",   10.5,  76.2, -300, 1102,"South India",  83,82,75},
+    };
+    return vector<CivRecord>(begin(rows), end(rows));
+}
+
+// ─────────────────────────────────────────────
+//  REGIONS (fallback when regions.csv is missing)
+// ─────────────────────────────────────────────
+
+vector<RegionBox> getBuiltinRegions() {
+    return {
+        {"South Asia",      5.0, 37.0,  60.0,  97.0},
+        {"Mediterranean",  30.0, 45.0,  -5.0,  42.0},
+        {"Middle East",    25.0, 40.0,  35.0,  60.0},
+        {"East Asia",      20.0, 50.0,  95.0, 135.0},
+        {"Mesoamerica",     5.0, 25.0,-110.0, -80.0},
+        {"North Africa",   15.0, 35.0,  15.0,  50.0},
+        {"Central Asia",   30.0, 55.0,  45.0, 120.0},
+        {"South America", -25.0,  0.0, -80.0, -60.0},
+    };
+}
+
+// ─────────────────────────────────────────────
+//  DATASET SNAPSHOTS (read-copy-update)
+// ─────────────────────────────────────────────
+
+// CIVMAP_NEAREST_INDEX=delaunay answers nearest queries by walking the
+// Delaunay triangulation instead of descending the KD-tree. It is rebuilt
+// when the writer merges edits, so it suits read-mostly data.
+bool nearestByDelaunay() {
+    static const bool on = [] {
+        const char* v = getenv("CIVMAP_NEAREST_INDEX");
+        return v && string(v) == "delaunay";
+    }();
+    return on;
+}
+
+// Civilizations with the KD-tree, name index and era index over them
+struct RecordSet {
+    vector<CivRecord> civs;      // ascending id
+    KDTree            kdTree;
+    NameIndex         nameIndex; // positions in civs
+    IntervalTree      eras;      // [start_year, end_year], positions in civs
+
+    // `records` must be in ascending id order with JSON prepared
+    void build(vector<CivRecord> records) {
+        kdTree.build(records);
+        nameIndex.build(records);
+        vector<pair<int, int>> years;
+        years.reserve(records.size());
+        for (const auto& c : records) years.push_back({c.startYear, c.endYear});
+        eras.build(years);
+        civs = move(records);
+    }
+
+    const CivRecord* byId(long id) const {
+        auto it = lower_bound(civs.begin(), civs.end(), id,
+                              [](const CivRecord& c, long v) { return c.id < v; });
+        return it != civs.end() && it->id == id ? &*it : nullptr;
+    }
+};
+
+// Delaunay triangulation (Voronoi diagram) of some records; its input
+// positions index `records`, which are in ascending id order
+struct VoronoiIndex {
+    vector<const CivRecord*> records;
+    Delaunay                 triangulation;
+
+    void build(vector<const CivRecord*> sites) {
+        vector<pair<double, double>> latLons;
+        latLons.reserve(sites.size());
+        for (const CivRecord* c : sites) latLons.push_back({c->latitude, c->longitude});
+        triangulation.build(latLons);
+        records = move(sites);
+    }
+
+    // Position of the record with `id`, or -1
+    long position(long id) const {
+        auto it = lower_bound(records.begin(), records.end(), id,
+                              [](const CivRecord* c, long v) { return c->id < v; });
+        return it != records.end() && (*it)->id == id ? (long)(it - records.begin()) : -1;
+    }
+};
+
+atomic<uint64_t> baseGenerations{0};
+
+// The civilizations as of the last merge, with every index over them.
+// Shared by all snapshots until the writer merges the edits made since.
+struct DatasetBase : RecordSet {
+    uint64_t generation = 0; // unique per base, so caches can outlive versions
+
+    // Marker clusters for /api/tiles (cluster.first is a position in civs).
+    // Built on first use, so merges that nobody maps don't pay for it.
+    const ClusterPyramid& pyramid() const {
+        call_once(pyramidOnce, [this] {
+            vector<pair<double, double>> latLons;
+            latLons.reserve(civs.size());
+            for (const auto& c : civs) latLons.push_back({c.latitude, c.longitude});
+            clusters.build(latLons);
+        });
+        return clusters;
+    }
+
+    // Built with the base in Delaunay nearest mode, else on first use
+    const VoronoiIndex& voronoi() const {
+        call_once(voronoiOnce, [this] {
+            vector<const CivRecord*> sites;
+            sites.reserve(civs.size());
+            for (const auto& c : civs) sites.push_back(&c);
+            triangulation.build(move(sites));
+        });
+        return triangulation;
+    }
+
+private:
+    mutable once_flag      pyramidOnce;
+    mutable ClusterPyramid clusters;
+    mutable once_flag      voronoiOnce;
+    mutable VoronoiIndex   triangulation;
+};
+
+// One immutable version of the civilizations: a shared base plus the edits
+// made since it was merged. `added` holds the records inserted or changed
+// since, `hidden` the base records they replace or that were deleted, so
+// queries run on the base skipping hidden ids and then on `added`, and a
+// write rebuilds only this small delta. Handlers take a snapshot with
+// dataset() and hold it for the whole request, so references into it stay
+// valid while writers publish newer versions.
+struct Dataset {
+    using value_type = CivRecord; // for rangePage()
+
+    uint64_t     version  = 0;
+    time_t       modified = 0;
+    shared_ptr<const DatasetBase> base;
+    RecordSet    added;      // inserted or changed since the base
+    vector<long> hiddenIds;  // base records deleted or changed since, ascending
+    vector<bool> hiddenMask; // by id
+    KDTree       hidden;     // copies of those base records
+    shared_ptr<const RegionIndex> rTree; // shared by versions until a reload
+
+    bool isHidden(long id) const { return (size_t)id < hiddenMask.size() && hiddenMask[id]; }
+
+    // Records in the delta, which the writer merges into a new base
+    size_t edits() const { return added.civs.size() + hiddenIds.size(); }
+
+    size_t size() const { return base->civs.size() - hiddenIds.size() + added.civs.size(); }
+
+    const CivRecord* byId(long id) const {
+        if (const CivRecord* c = added.byId(id)) return c;
+        return isHidden(id) ? nullptr : base->byId(id);
+    }
+
+    // f(record) for every civilization, in ascending id order
+    template <typename F>
+    void forEach(F&& f) const {
+        auto next = added.civs.begin();
+        for (const auto& c : base->civs) {
+            for (; next != added.civs.end() && next->id < c.id; ++next) f(*next);
+            if (!isHidden(c.id)) f(c);
+        }
+        for (; next != added.civs.end(); ++next) f(*next);
+    }
+
+    // Nearest civilization and its distance (degrees) in one traversal
+    template <typename Stats = NoStats>
+    const CivRecord& nearest(double lat, double lon, double& dist, Stats&& stats = Stats()) const {
+        auto keep = [this](const CivRecord& c) { return !isHidden(c.id); };
+        const CivRecord* best = nullptr;
+        if (nearestByDelaunay() && base->voronoi().triangulation.exact()) {
+            // Exact among the base; if that site is hidden, the KD-tree finds the next one
+            const VoronoiIndex& v = base->voronoi();
+            long pos = v.triangulation.nearest(lat, lon, dist, stats);
+            if (pos >= 0 && keep(*v.records[pos])) best = v.records[pos];
+        }
+        if (!best) best = base->kdTree.nearest(lat, lon, dist, stats, keep);
+        double editedDist;
+        const CivRecord* edited = added.kdTree.nearest(lat, lon, editedDist, stats);
+        if (edited && (!best || editedDist < dist)) { best = edited; dist = editedDist; }
+        if (!best) throw runtime_error("Tree is empty");
+        return *best;
+    }
+
+    const char* nearestAlgorithm() const {
+        return nearestByDelaunay() && base->voronoi().triangulation.exact()
+            ? "Delaunay walk from a grid seed (exact Voronoi point location)"
+            : "KD-Tree O(log n) with branch pruning";
+    }
+
+    template <typename F, typename Stats>
+    bool range(double latMin, double latMax, double lonMin, double lonMax, F&& onHit, Stats& stats) const {
+        bool complete = base->kdTree.range(latMin, latMax, lonMin, lonMax, [&](const CivRecord& c) {
+            return isHidden(c.id) ? Visit::Continue : invokeVisitor(onHit, c);
+        }, stats);
+        return complete && added.kdTree.range(latMin, latMax, lonMin, lonMax, onHit, stats);
+    }
+
+    template <typename F>
+    bool range(double latMin, double latMax, double lonMin, double lonMax, F&& onHit) const {
+        NoStats none;
+        return range(latMin, latMax, lonMin, lonMax, onHit, none);
+    }
+
+    size_t count(double latMin, double latMax, double lonMin, double lonMax) const {
+        return base->kdTree.count(latMin, latMax, lonMin, lonMax) - hidden.count(latMin, latMax, lonMin, lonMax) +
+               added.kdTree.count(latMin, latMax, lonMin, lonMax);
+    }
+
+    // True if an edit since the base touches the box
+    bool editedIn(double latMin, double latMax, double lonMin, double lonMax) const {
+        return hidden.count(latMin, latMax, lonMin, lonMax) + added.kdTree.count(latMin, latMax, lonMin, lonMax) > 0;
+    }
+
+    CivSummary rangeAggregate(double latMin, double latMax, double lonMin, double lonMax) const {
+        vector<pair<double, double>> holes;
+        hidden.range(latMin, latMax, lonMin, lonMax,
+                     [&](const CivRecord& c) { holes.push_back({c.latitude, c.longitude}); });
+        CivSummary out = holes.empty()
+            ? base->kdTree.rangeAggregate(latMin, latMax, lonMin, lonMax)
+            : base->kdTree.rangeAggregate(latMin, latMax, lonMin, lonMax, holes,
+                                          [this](const CivRecord& c) { return !isHidden(c.id); });
+        out.merge(added.kdTree.rangeAggregate(latMin, latMax, lonMin, lonMax));
+        return out;
+    }
+
+    // The k civilizations in the box with the highest spatial score, best first
+    vector<Ranked<CivRecord>> topByScore(double latMin, double latMax, double lonMin, double lonMax, size_t k) const {
+        auto score = [](const CivRecord& c) { return c.spatialScore(); };
+        auto bound = [](const CivSummary& s) { return s.fields[AGG_SCORE].max; };
+        auto top = base->kdTree.topKInRange(latMin, latMax, lonMin, lonMax, k, score, bound,
+                                            [this](const CivRecord& c) { return !isHidden(c.id); });
+        if (added.civs.empty()) return top;
+        auto edited = added.kdTree.topKInRange(latMin, latMax, lonMin, lonMax, k, score, bound);
+        vector<Ranked<CivRecord>> out;
+        merge(top.begin(), top.end(), edited.begin(), edited.end(), back_inserter(out),
+              [](const Ranked<CivRecord>& a, const Ranked<CivRecord>& b) { return a.score > b.score; });
+        if (out.size() > k) out.resize(k);
+        return out;
+    }
+
+    // KDTree::RangeCursor over the base, skipping hidden records, then over `added`
+    class RangeCursor {
+    public:
+        RangeCursor(const Dataset& ds, double latMin, double latMax, double lonMin, double lonMax)
+            : ds(&ds), inBase(ds.base->kdTree.rangeCursor(latMin, latMax, lonMin, lonMax)),
+              inAdded(ds.added.kdTree.rangeCursor(latMin, latMax, lonMin, lonMax)) {}
+
+        bool done() const { return inBase.done() && inAdded.done(); }
+
+        template <typename F, typename Stats>
+        size_t next(size_t max, F&& emit, Stats& stats) {
+            size_t n = 0;
+            while (n < max && !inBase.done())
+                inBase.next(max - n, [&](const CivRecord& c) {
+                    if (ds->isHidden(c.id)) return;
+                    emit(c);
+                    n++;
+                }, stats);
+            if (n < max) n += inAdded.next(max - n, emit, stats);
+            return n;
+        }
+
+    private:
+        const Dataset* ds;
+        KDTree::RangeCursor inBase, inAdded;
+    };
+
+    RangeCursor rangeCursor(double latMin, double latMax, double lonMin, double lonMax) const {
+        return RangeCursor(*this, latMin, latMax, lonMin, lonMax);
+    }
+
+    // onHit(record) for every civilization active in some year of [from, to];
+    // may return Visit::Stop. Returns false if the visitor stopped.
+    template <typename F>
+    bool overlapping(int from, int to, F&& onHit) const {
+        bool complete = base->eras.overlapping(from, to, [&](uint32_t pos) {
+            const CivRecord& c = base->civs[pos];
+            return isHidden(c.id) ? Visit::Continue : invokeVisitor(onHit, c);
+        });
+        return complete && added.eras.overlapping(from, to, [&](uint32_t pos) {
+            return invokeVisitor(onHit, added.civs[pos]);
+        });
+    }
+
+    // Civilization with this (normalised) name, or nullptr; on duplicate
+    // names the lowest id wins
+    const CivRecord* findName(const string& name) const {
+        long b = base->nameIndex.find(name, [this](size_t pos) { return !isHidden(base->civs[pos].id); });
+        long a = added.nameIndex.find(name);
+        const CivRecord* inBase  = b >= 0 ? &base->civs[b] : nullptr;
+        const CivRecord* inAdded = a >= 0 ? &added.civs[a] : nullptr;
+        if (!inBase || !inAdded) return inBase ? inBase : inAdded;
+        return inBase->id < inAdded->id ? inBase : inAdded;
+    }
+
+    // Up to `limit` civilizations whose name starts with `prefix`, in name order
+    vector<const CivRecord*> withPrefix(const string& prefix, size_t limit) const {
+        auto inBase  = base->nameIndex.withPrefix(prefix, limit,
+                                                  [this](size_t pos) { return !isHidden(base->civs[pos].id); });
+        auto inAdded = added.nameIndex.withPrefix(prefix, limit);
+        vector<const CivRecord*> out;
+        size_t i = 0, j = 0;
+        while (out.size() < limit && (i < inBase.size() || j < inAdded.size())) {
+            const CivRecord* b = i < inBase.size()  ? &base->civs[inBase[i].second]   : nullptr;
+            const CivRecord* a = j < inAdded.size() ? &added.civs[inAdded[j].second] : nullptr;
+            bool fromBase = !a || (b && (inBase[i].first != inAdded[j].first ? inBase[i].first < inAdded[j].first
+                                                                            : b->id < a->id));
+            if (fromBase) { out.push_back(b); i++; }
+            else          { out.push_back(a); j++; }
+        }
+        return out;
+    }
+
+    // Delaunay triangulation of the current civilizations: the base's
+    // while nothing is edited, else this snapshot's own, built on first use
+    const VoronoiIndex& voronoi() const {
+        if (!edits()) return base->voronoi();
+        call_once(voronoiOnce, [this] {
+            vector<const CivRecord*> sites;
+            sites.reserve(size());
+            forEach([&](const CivRecord& c) { sites.push_back(&c); });
+            triangulation.build(move(sites));
+        });
+        return triangulation;
+    }
+
+private:
+    mutable once_flag    voronoiOnce;
+    mutable VoronoiIndex triangulation;
+};
+
+shared_ptr<const Dataset> currentDataset; // accessed via atomic_load/store
+mutex                     publishMutex;
+
+// Mirrors dataset()->version, for metrics
+atomic<uint64_t> datasetVersion{0};
+
+shared_ptr<const Dataset> dataset() { return atomic_load(&currentDataset); }
+
+// `civs` must be in ascending id order with JSON prepared
+shared_ptr<DatasetBase> buildBase(vector<CivRecord> civs) {
+    auto base = make_shared<DatasetBase>();
+    base->generation = ++baseGenerations;
+    base->build(move(civs));
+    if (nearestByDelaunay()) base->voronoi();
+    return base;
+}
+
+// Snapshot of `base` where `added` (ascending id) replaces or extends it and
+// the base records in `hiddenIds` (ascending) are hidden
+shared_ptr<Dataset> makeDataset(shared_ptr<const DatasetBase> base, vector<CivRecord> added,
+                                vector<long> hiddenIds, shared_ptr<const RegionIndex> rTree) {
+    auto ds = make_shared<Dataset>();
+    vector<CivRecord> hiddenCivs;
+    hiddenCivs.reserve(hiddenIds.size());
+    if (!hiddenIds.empty()) ds->hiddenMask.resize(hiddenIds.back() + 1);
+    for (long id : hiddenIds) {
+        ds->hiddenMask[id] = true;
+        hiddenCivs.push_back(*base->byId(id));
+    }
+    ds->hidden.build(move(hiddenCivs));
+    ds->added.build(move(added));
+    ds->hiddenIds = move(hiddenIds);
+    ds->base  = move(base);
+    ds->rTree = move(rTree);
+    return ds;
+}
+
+// `civs` must be in ascending id order with JSON prepared
+shared_ptr<Dataset> buildDataset(vector<CivRecord> civs, shared_ptr<const RegionIndex> rTree) {
+    return makeDataset(buildBase(move(civs)), {}, {}, move(rTree));
+}
+
+// `source` with `edits` applied (id → new record, or nullopt to delete): the
+// same base under a new delta, in time proportional to the delta
+shared_ptr<Dataset> applyEdits(const Dataset& source, const map<long, optional<CivRecord>>& edits) {
+    vector<CivRecord> added;
+    added.reserve(source.added.civs.size() + edits.size());
+    auto e = edits.begin();
+    for (const auto& c : source.added.civs) {
+        for (; e != edits.end() && e->first < c.id; ++e)
+            if (e->second) added.push_back(*e->second);
+        if (e != edits.end() && e->first == c.id) {
+            if (e->second) added.push_back(*e->second);
+            ++e;
+        } else {
+            added.push_back(c);
+        }
+    }
+    for (; e != edits.end(); ++e)
+        if (e->second) added.push_back(*e->second);
+
+    vector<long> edited, hiddenIds;
+    for (const auto& entry : edits)
+        if (source.base->byId(entry.first)) edited.push_back(entry.first);
+    set_union(source.hiddenIds.begin(), source.hiddenIds.end(), edited.begin(), edited.end(),
+              back_inserter(hiddenIds));
+    return makeDataset(source.base, move(added), move(hiddenIds), source.rTree);
+}
+
+// Swaps in `ds` with one atomic store and returns the snapshot it replaced.
+// Requests already holding the old one finish on it undisturbed.
+shared_ptr<const Dataset> publishDataset(shared_ptr<Dataset> ds) {
+    lock_guard<mutex> lock(publishMutex);
+    ds->version  = datasetVersion.load() + 1;
+    ds->modified = time(nullptr);
+    uint64_t version = ds->version;
+    auto previous = atomic_exchange(&currentDataset, shared_ptr<const Dataset>(move(ds)));
+    datasetVersion.store(version, memory_order_release);
+    return previous;
+}
+
+// ─────────────────────────────────────────────
+//  CORS HELPER
+// ─────────────────────────────────────────────
+
+void addCORS(httplib::Response& res) {
+    res.set_header("Access-Control-Allow-Origin",  "*");
+    res.set_header("Access-Control-Allow-Methods", "GET, POST, PUT, DELETE, OPTIONS");
+    res.set_header("Access-Control-Allow-Headers", "Content-Type");
+}
+
+void sendJSON(httplib::Response& res, const string& json) {
+    addCORS(res);
+    res.set_content(json, "application/json");
+}
+
+void sendJSON(httplib::Response& res, const JsonWriter& w) {
+    addCORS(res);
+    res.set_content(w.data(), w.size(), "application/json");
+}
+
+void sendError(httplib::Response& res, const string& msg, int code=400) {
+    addCORS(res);
+    res.status = code;
+    res.set_content("{\"error\":\"" + jsonEscape(msg) + "\"}", "application/json");
+}
+
+// ─────────────────────────────────────────────
+//  RESPONSE CACHE
+// ─────────────────────────────────────────────
+
+string httpDate(time_t t) {
+    tm g{};
+#ifdef _WIN32
+    gmtime_s(&g, &t);
+#else
+    gmtime_r(&t, &g);
+#endif
+    char buf[32];
+    strftime(buf, sizeof(buf), "%a, %d %b %Y %H:%M:%S GMT", &g);
+    return buf;
+}
+
+// One encoding of a cached body. Each encoding is a distinct representation,
+// so each gets its own strong ETag.
+struct EncodedBody {
+    string encoding; // empty for identity
+    string body;
+    string etag;
+};
+
+// Serialized once per dataset version (a body built for an older snapshot
+// is rebuilt on its next request), stored in every encoding we serve
+// (preferred first, identity last) so a hit is just a copy into the response.
+struct CachedBody {
+    uint64_t version = 0;
+    vector<EncodedBody> variants;
+    string lastModified;
+};
+
+// Stores `identity` in every encoding we serve, tagged with its content hash
+shared_ptr<CachedBody> encodeBody(string identity, const Dataset& ds) {
+    // FNV-1a of the identity body: unchanged content keeps its ETag
+    // across versions, so clients don't refetch after a no-op reload
+    uint64_t h = 1469598103934665603ull;
+    for (unsigned char c : identity) { h ^= c; h *= 1099511628211ull; }
+    char hash[20];
+    snprintf(hash, sizeof(hash), "%016llx", (unsigned long long)h);
+
+    auto fresh = make_shared<CachedBody>();
+    fresh->version = ds.version;
+    fresh->lastModified = httpDate(ds.modified);
+    string encoded;
+    if (Compress::gzip(identity, encoded))
+        fresh->variants.push_back({"gzip", move(encoded), "\"" + string(hash) + "-gzip\""});
+    if (Compress::deflate(identity, encoded))
+        fresh->variants.push_back({"deflate", move(encoded), "\"" + string(hash) + "-deflate\""});
+    fresh->variants.push_back({"", move(identity), "\"" + string(hash) + "\""});
+    return fresh;
+}
+
+class ResponseCache {
+private:
+    string contentType;
+    function<string(const Dataset&)> render;
+    shared_ptr<const CachedBody> current; // accessed via atomic_load/store
+    mutex rebuildMutex;
+
+public:
+    ResponseCache(string type, function<string(const Dataset&)> r) : contentType(move(type)), render(move(r)) {}
+
+    const string& type() const { return contentType; }
+
+    shared_ptr<const CachedBody> get() {
+        auto ds = dataset();
+        auto body = atomic_load(&current);
+        if (body && body->version == ds->version) return body;
+
+        lock_guard<mutex> lock(rebuildMutex);
+        body = atomic_load(&current);
+        if (body && body->version >= ds->version) return body;
+
+        body = encodeBody(render(*ds), *ds);
+        atomic_store(&current, body);
+        return body;
+    }
+};
+
+// True if `encoding` appears in Accept-Encoding without q=0
+bool acceptsEncoding(const string& header, const string& encoding) {
+    istringstream list(header);
+    string tok;
+    while (getline(list, tok, ',')) {
+        size_t semi = tok.find(';');
+        string name = tok.substr(0, semi);
+        name.erase(0, name.find_first_not_of(" \t"));
+        name.erase(name.find_last_not_of(" \t") + 1);
+        if (name.size() != encoding.size() ||
+            !equal(name.begin(), name.end(), encoding.begin(),
+                   [](char a, char b) { return tolower((unsigned char)a) == tolower((unsigned char)b); }))
+            continue;
+        size_t q = semi == string::npos ? string::npos : tok.find("q=", semi);
+        return q == string::npos || atof(tok.c_str() + q + 2) > 0;
+    }
+    return false;
+}
+
+// If-None-Match uses weak comparison: W/ prefixes are ignored
+bool etagMatches(const string& header, const string& etag) {
+    istringstream list(header);
+    string tok;
+    while (getline(list, tok, ',')) {
+        tok.erase(0, tok.find_first_not_of(" \t"));
+        tok.erase(tok.find_last_not_of(" \t") + 1);
+        if (tok.compare(0, 2, "W/") == 0) tok.erase(0, 2);
+        if (tok == "*" || tok == etag) return true;
+    }
+    return false;
+}
+
+void sendCachedBody(const httplib::Request& req, httplib::Response& res,
+                    const CachedBody& cached, const string& type) {
+    const string accept = req.get_header_value("Accept-Encoding");
+    const EncodedBody* chosen = &cached.variants.back();
+    for (const auto& v : cached.variants) {
+        if (v.encoding.empty() || acceptsEncoding(accept, v.encoding)) { chosen = &v; break; }
+    }
+
+    addCORS(res);
+    res.set_header("ETag", chosen->etag);
+    res.set_header("Last-Modified", cached.lastModified);
+    res.set_header("Cache-Control", "no-cache"); // always revalidate, usually a 304
+    res.set_header("Vary", "Accept, Accept-Encoding");
+
+    // If-None-Match takes precedence; If-Modified-Since is matched against
+    // the exact Last-Modified value we sent, which is what browsers echo back
+    bool notModified = req.has_header("If-None-Match")
+        ? etagMatches(req.get_header_value("If-None-Match"), chosen->etag)
+        : req.get_header_value("If-Modified-Since") == cached.lastModified;
+    if (notModified) {
+        res.status = 304;
+        return;
+    }
+    if (!chosen->encoding.empty()) res.set_header("Content-Encoding", chosen->encoding);
+    res.set_content(chosen->body, type);
+}
+
+void sendCached(const httplib::Request& req, httplib::Response& res, ResponseCache& cache) {
+    sendCachedBody(req, res, *cache.get(), cache.type());
+}
+
+const int STATS_SAMPLE_QUERIES = 256;
+
+// kdtree_ops is the measured average number of nodes a nearest query visits,
+// over map-click-like queries within a degree of random civilizations
+void writeStats(JsonWriter& w, const Dataset& ds) {
+    int n = (int)ds.size();
+    const vector<CivRecord>& around = ds.base->civs; // query sites; edits move few
+    QueryStats sample;
+    int queries = n && !around.empty() ? STATS_SAMPLE_QUERIES : 0;
+    mt19937 gen(42); // same sample for the same data
+    uniform_real_distribution<double> jitter(-1.0, 1.0);
+    for (int i = 0; i < queries; i++) {
+        const CivRecord& c = around[gen() % around.size()];
+        double dist;
+        ds.nearest(c.latitude + jitter(gen), c.longitude + jitter(gen), dist, sample);
+    }
+    int ops = queries ? max(1, (int)ceil((double)sample.nodesVisited / queries)) : 1;
+    w.raw("{\"total_civilizations\":").number(n)
+     .raw(",\"kdtree_nodes\":").number(ds.base->kdTree.size() + ds.added.kdTree.size())
+     .raw(",\"rtree_regions\":").number(ds.rTree->size())
+     .raw(",\"linear_ops\":").number(n)
+     .raw(",\"kdtree_ops\":").number(ops)
+     .raw(",\"speedup\":").number(n / ops)
+     .raw(",\"kdtree_nearest_sample\":{\"queries\":").number(queries)
+     .raw(",\"totals\":");
+    writeQueryStats(w, sample);
+    w.raw("}}");
+}
+
+template <typename F>
+string renderJSON(F&& write) {
+    JsonWriter& w = threadJsonWriter();
+    write(w);
+    return w.str();
+}
+
+void writeCivArray(JsonWriter& w, const Dataset& ds) {
+    w.raw('[');
+    bool first = true;
+    ds.forEach([&](const CivRecord& c) {
+        if (!first) w.raw(',');
+        first = false;
+        c.writeJSON(w);
+    });
+    w.raw(']');
+}
+
+string civFrame(const Dataset& ds) {
+    CivFrameBuilder b = civFrameBuilder();
+    b.reserve(ds.size());
+    ds.forEach([&](const CivRecord& c) { appendCivRow(b, c); });
+    return b.finish((uint32_t)ds.size());
+}
+
+ResponseCache civilizationsCache("application/json",
+    [](const Dataset& ds) { return renderJSON([&](JsonWriter& w) { writeCivArray(w, ds); }); });
+ResponseCache civilizationsFrameCache(CIVFRAME_TYPE, [](const Dataset& ds) { return civFrame(ds); });
+ResponseCache statsCache("application/json",
+    [](const Dataset& ds) { return renderJSON([&](JsonWriter& w) { writeStats(w, ds); }); });
+
+// ─────────────────────────────────────────────
+//  NEAREST CACHE (map clicks)
+// ─────────────────────────────────────────────
+
+// Memoizes /api/nearest per grid cell of `cellDeg` degrees. A cell is only
+// cached when its four corners share one nearest site: Voronoi cells are
+// convex, so that site is then the nearest for every point in the cell.
+// Cells straddling a Voronoi edge are remembered as uncacheable so their
+// corners are not probed again.
+//
+// Cells belong to a dataset base rather than a version, so they survive
+// writes: every record edited since the base is in the snapshot's delta, so
+// a cell's site still holds unless it was edited itself or an added record
+// is closer to the query, which the small delta KD-tree answers.
+class NearestCache {
+private:
+    struct Cell {
+        uint64_t generation; // of the dataset base
+        int64_t iy, ix; // the key is a hash of these, so a hit compares them
+        bool cacheable;
+        CivRecord civ;
+    };
+
+    double cellDeg;
+    ShardedLRU<uint64_t, Cell> lru;
+
+    static bool sameSite(const CivRecord& a, const CivRecord& b) {
+        return a.latitude == b.latitude && a.longitude == b.longitude && a.name == b.name;
+    }
+
+public:
+    atomic<uint64_t> hits{0}, misses{0}, uncacheable{0};
+
+    NearestCache(double cell, size_t capacity) : cellDeg(cell > 0 ? cell : 0.05), lru(capacity) {}
+
+    double cellSize() const { return cellDeg; }
+    size_t entries() const { return lru.size(); }
+
+    // `status` is set to "hit", "miss" or "uncacheable". lat/lon must be
+    // finite and within [-90, 90] / [-180, 180] (checked by the handler).
+    CivRecord lookup(const Dataset& ds, double lat, double lon, double& dist, const char*& status) {
+        int64_t iy = (int64_t)floor(lat / cellDeg), ix = (int64_t)floor(lon / cellDeg);
+        uint64_t key = (uint64_t)iy * 0x9E3779B97F4A7C15ull ^ (uint64_t)ix;
+        uint64_t generation = ds.base->generation;
+
+        Cell cell;
+        if (lru.get(key, cell) && cell.generation == generation && cell.iy == iy && cell.ix == ix) {
+            if (!cell.cacheable) {
+                uncacheable++;
+                status = "uncacheable";
+                return ds.nearest(lat, lon, dist);
+            }
+            const CivRecord* site = ds.edits() ? ds.byId(cell.civ.id) : &cell.civ;
+            if (site && sameSite(*site, cell.civ)) {
+                hits++;
+                status = "hit";
+                double dl = lat - site->latitude, dn = lon - site->longitude;
+                dist = sqrt(dl*dl + dn*dn);
+                double editedDist;
+                const CivRecord* edited = ds.added.kdTree.nearest(lat, lon, editedDist);
+                if (edited && editedDist < dist) { dist = editedDist; return *edited; }
+                return *site;
+            }
+        }
+
+        misses++;
+        status = "miss";
+        CivRecord best = ds.nearest(lat, lon, dist);
+        double lat0 = iy * cellDeg, lon0 = ix * cellDeg, cornerDist;
+        bool cacheable =
+            sameSite(ds.nearest(lat0,           lon0,           cornerDist), best) &&
+            sameSite(ds.nearest(lat0 + cellDeg, lon0,           cornerDist), best) &&
+            sameSite(ds.nearest(lat0,           lon0 + cellDeg, cornerDist), best) &&
+            sameSite(ds.nearest(lat0 + cellDeg, lon0 + cellDeg, cornerDist), best);
+        lru.put(key, {generation, iy, ix, cacheable, cacheable ? best : CivRecord{}});
+        return best;
+    }
+};
+
+// CIVMAP_NEAREST_CELL_DEG / CIVMAP_NEAREST_CACHE_SIZE override the defaults
+double envOr(const char* name, double fallback) {
+    const char* v = getenv(name);
+    return v && *v ? atof(v) : fallback;
+}
+
+NearestCache nearestCache(envOr("CIVMAP_NEAREST_CELL_DEG", 0.05),
+                          (size_t)envOr("CIVMAP_NEAREST_CACHE_SIZE", 65536));
+
+// ─────────────────────────────────────────────
+//  MAP TILES (/api/tiles/{z}/{x}/{y})
+// ─────────────────────────────────────────────
+
+void writeTilePoint(JsonWriter& w, const CivRecord& c) {
+    w.raw("{\"lat\":").number(c.latitude, 4)
+     .raw(",\"lon\":").number(c.longitude, 4)
+     .raw(",\"count\":1,\"id\":").number((long long)c.id)
+     .raw(",\"name\":\"").raw(c.nameJSON).raw("\"}");
+}
+
+// Box of tile z/x/y; points beyond the Mercator limit belong to the edge rows
+TileBox tileBox(int z, uint32_t x, uint32_t y) {
+    TileBox box = ClusterPyramid::tileBounds(z, x, y);
+    if (y == 0) box.latMax = 90;
+    if (y == (1u << z) - 1) box.latMin = -90;
+    return box;
+}
+
+// A cluster of a tile and, when it holds one record, that record
+struct TileEntry {
+    TileCluster cluster;
+    const CivRecord* only;
+};
+
+// Clusters of tile z/x/y (z within the pyramid). The pyramid covers the
+// base records, so the snapshot's hidden records are taken out of their
+// clusters and its added ones put in; a cluster left with one member finds
+// it with a range query over the cluster cell.
+vector<TileEntry> tileClusters(const Dataset& ds, int z, uint32_t x, uint32_t y) {
+    auto [first, last] = ds.base->pyramid().tile(z, x, y);
+    vector<TileEntry> out;
+    out.reserve(last - first);
+    for (const TileCluster* c = first; c != last; ++c)
+        out.push_back({*c, c->count == 1 ? &ds.base->civs[c->first] : nullptr});
+    TileBox box = tileBox(z, x, y);
+    if (!ds.editedIn(box.latMin, box.latMax, box.lonMin, box.lonMax)) return out;
+
+    int shift = ClusterPyramid::cellShift(z);
+    auto cellOf = [&](const CivRecord& c) { return ClusterPyramid::cellCode(c.latitude, c.longitude) >> shift; };
+    auto inTile = [&](const CivRecord& c) { return ClusterPyramid::tileOf(c.latitude, c.longitude, z) == make_pair(x, y); };
+    auto find = [&](uint64_t cell) {
+        return lower_bound(out.begin(), out.end(), cell,
+                           [shift](const TileEntry& e, uint64_t v) { return (e.cluster.code >> shift) < v; });
+    };
+    ds.hidden.range(box.latMin, box.latMax, box.lonMin, box.lonMax, [&](const CivRecord& c) {
+        if (!inTile(c)) return;
+        uint64_t cell = cellOf(c);
+        auto it = find(cell); // a base record, so its cluster exists
+        if (it == out.end() || (it->cluster.code >> shift) != cell) return;
+        it->cluster.count--;
+        it->cluster.latSum -= c.latitude;
+        it->cluster.lonSum -= c.longitude;
+        it->only = nullptr;
+    });
+    ds.added.kdTree.range(box.latMin, box.latMax, box.lonMin, box.lonMax, [&](const CivRecord& c) {
+        if (!inTile(c)) return;
+        uint64_t cell = cellOf(c);
+        auto it = find(cell);
+        if (it == out.end() || (it->cluster.code >> shift) != cell) {
+            out.insert(it, {{ClusterPyramid::cellCode(c.latitude, c.longitude), 1, 0, c.latitude, c.longitude}, &c});
+            return;
+        }
+        it->cluster.count++;
+        it->cluster.latSum += c.latitude;
+        it->cluster.lonSum += c.longitude;
+        it->only = nullptr;
+    });
+    out.erase(remove_if(out.begin(), out.end(), [](const TileEntry& e) { return e.cluster.count == 0; }), out.end());
+    for (auto& e : out) {
+        if (e.cluster.count != 1 || e.only) continue;
+        const double pad = 1e-9; // the projection rounds differently at cell edges
+        uint64_t cell = e.cluster.code >> shift;
+        TileBox cb = ClusterPyramid::cellBounds(z, e.cluster.code);
+        ds.range(cb.latMin - pad, cb.latMax + pad, cb.lonMin - pad, cb.lonMax + pad, [&](const CivRecord& c) {
+            if (cellOf(c) != cell || !inTile(c)) return Visit::Continue;
+            e.only = &c;
+            return Visit::Stop;
+        });
+    }
+    return out;
+}
+
+// Clusters of one Web-Mercator tile. Zooms covered by the pyramid get one
+// entry per non-empty cluster cell (count + centroid, or the record itself
+// when alone); deeper tiles list their points from a KD-tree range query.
+void writeTile(JsonWriter& w, const Dataset& ds, int z, uint32_t x, uint32_t y) {
+    bool clustered = z <= ds.base->pyramid().topZoom();
+    size_t total = 0, n = 0;
+    w.raw("{\"z\":").number(z).raw(",\"x\":").number((size_t)x).raw(",\"y\":").number((size_t)y)
+     .raw(",\"clusters\":[");
+    if (clustered) {
+        for (const TileEntry& e : tileClusters(ds, z, x, y)) {
+            const TileCluster* c = &e.cluster;
+            if (n++) w.raw(',');
+            total += c->count;
+            if (e.only) { writeTilePoint(w, *e.only); continue; }
+            w.raw("{\"lat\":").number(c->lat(), 4)
+             .raw(",\"lon\":").number(c->lon(), 4)
+             .raw(",\"count\":").number((size_t)c->count).raw('}');
+        }
+    } else {
+        TileBox box = tileBox(z, x, y);
+        ds.range(box.latMin, box.latMax, box.lonMin, box.lonMax, [&](const CivRecord& c) {
+            if (ClusterPyramid::tileOf(c.latitude, c.longitude, z) != make_pair(x, y)) return; // shared edge
+            if (n++) w.raw(',');
+            total++;
+            writeTilePoint(w, c);
+        });
+    }
+    w.raw("],\"count\":").number(total)
+     .raw(",\"clustered\":").boolean(clustered).raw('}');
+}
+
+// Encoded tile bodies by z/x/y, valid for the dataset version they were
+// rendered from; a tile from an older version is re-rendered on request.
+// Unless both versions share a base and neither has an edit in the tile:
+// the tile then shows only base records, the same in both.
+class TileCache {
+private:
+    struct Entry {
+        uint64_t version = 0;
+        uint64_t generation = 0; // of the dataset base
+        bool     unedited = false; // no edit of that version in the tile
+        shared_ptr<const CachedBody> body;
+    };
+    ShardedLRU<uint64_t, Entry> lru;
+
+public:
+    atomic<uint64_t> hits{0}, misses{0};
+
+    explicit TileCache(size_t capacity) : lru(capacity) {}
+
+    size_t entries() const { return lru.size(); }
+
+    shared_ptr<const CachedBody> get(const Dataset& ds, int z, uint32_t x, uint32_t y) {
+        uint64_t key = (uint64_t)z << 48 | (uint64_t)x << 24 | y;
+        TileBox box = tileBox(z, x, y);
+        bool unedited = !ds.editedIn(box.latMin, box.latMax, box.lonMin, box.lonMax);
+        Entry e;
+        if (lru.get(key, e) && (e.version == ds.version ||
+                                (e.generation == ds.base->generation && e.unedited && unedited))) {
+            hits++;
+            return e.body;
+        }
+        misses++;
+        e.version = ds.version;
+        e.generation = ds.base->generation;
+        e.unedited = unedited;
+        e.body = encodeBody(renderJSON([&](JsonWriter& w) { writeTile(w, ds, z, x, y); }), ds);
+        lru.put(key, e);
+        return e.body;
+    }
+};
+
+// CIVMAP_TILE_CACHE_SIZE overrides the default
+TileCache tileCache((size_t)envOr("CIVMAP_TILE_CACHE_SIZE", 16384));
+
+// ─────────────────────────────────────────────
+//  ADMISSION CONTROL
+// ─────────────────────────────────────────────
+
+// Deadline of the request being served on this thread. Long traversals
+// poll cancelled() from their visitors (the clock is read every
+// CHECK_EVERY polls) and stop early once it has passed.
+class RequestDeadline {
+public:
+    static constexpr int CHECK_EVERY = 256;
+
+    void start(chrono::steady_clock::time_point from, chrono::milliseconds budget) {
+        at = from + budget;
+        countdown = CHECK_EVERY;
+        expired = false;
+    }
+
+    bool cancelled() {
+        if (expired || --countdown > 0) return expired;
+        countdown = CHECK_EVERY;
+        return passed();
+    }
+
+    // Reads the clock now
+    bool passed() {
+        return expired = expired || chrono::steady_clock::now() >= at;
+    }
+
+    chrono::steady_clock::time_point deadline() const { return at; }
+
+private:
+    chrono::steady_clock::time_point at = chrono::steady_clock::time_point::max();
+    int countdown = CHECK_EVERY;
+    bool expired = false;
+};
+
+thread_local RequestDeadline requestDeadline;
+
+// CIVMAP_WORKERS, CIVMAP_MAX_QUEUE, CIVMAP_REQUEST_TIMEOUT_MS and
+// CIVMAP_RETRY_AFTER_SEC override the defaults
+struct Admission {
+    size_t workers   = (size_t)envOr("CIVMAP_WORKERS", max(8u, thread::hardware_concurrency()));
+    size_t maxQueued = (size_t)envOr("CIVMAP_MAX_QUEUE", 256);
+    chrono::milliseconds timeout{(long)envOr("CIVMAP_REQUEST_TIMEOUT_MS", 5000)};
+    int retryAfterSec = (int)envOr("CIVMAP_RETRY_AFTER_SEC", 1);
+    size_t maxShedQueued = 1024; // backlog of the shed lane, whose 503s are cheap
+
+    atomic<size_t>   queued{0};      // connections waiting for a worker
+    atomic<uint64_t> shedQueueFull{0}; // requests answered 503 from the shed lane
+    atomic<uint64_t> shedDeadline{0};  // requests whose deadline passed while queued
+    atomic<uint64_t> dropped{0};       // connections closed unanswered (shed lane full too)
+    atomic<uint64_t> cancelled{0};     // traversals stopped by their deadline
+} admission;
+
+// Connection being served on this thread, as seen by admitRequest()
+struct ConnectionState {
+    bool shedLane = false;
+    bool firstRequest = false;
+    chrono::steady_clock::time_point enqueued;
+};
+
+thread_local ConnectionState currentConnection;
+
+// Fixed worker pool behind a bounded queue, in place of httplib's default
+// pool whose queue is unbounded. A connection that finds the queue full is
+// handed to a single shed thread that answers 503 + Retry-After (see
+// admitRequest()) and closes, so a burst costs the excess clients one quick
+// round trip instead of making every request slower. Only when the shed
+// backlog is full as well is a connection closed unanswered.
+class AdmissionQueue : public httplib::TaskQueue {
+public:
+    AdmissionQueue() {
+        for (size_t i = 0; i < admission.workers; i++) threads.emplace_back([this] { run(work, false); });
+        threads.emplace_back([this] { run(shed, true); });
+    }
+
+    bool enqueue(function<void()> fn) override {
+        lock_guard<mutex> lock(m);
+        if (stopping) return false;
+        bool full = work.jobs.size() >= admission.maxQueued;
+        if (full && shed.jobs.size() >= admission.maxShedQueued) {
+            admission.dropped++;
+            return false; // httplib closes the socket
+        }
+        Lane& lane = full ? shed : work;
+        lane.jobs.push_back({move(fn), chrono::steady_clock::now()});
+        if (!full) admission.queued = work.jobs.size();
+        lane.ready.notify_one();
+        return true;
+    }
 
-using namespace std;
+    // Lets the workers drain what is queued, then joins them
+    void shutdown() override {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        work.ready.notify_all();
+        shed.ready.notify_all();
+        for (auto& t : threads) t.join();
+    }
 
-// ─────────────────────────────────────────────
-//  DATA MODEL
-// ─────────────────────────────────────────────
-
-struct Civilization {
-    string name;
-    double latitude;
-    double longitude;
-    int    start_year;
-    int    end_year;
-    string region;
-    double resource_density;
-    double knowledge_density;
-    double military_strength;
-
-    double spatialScore() const {
-        return (resource_density + knowledge_density + military_strength) / 3.0;
-    }
-
-    // Serialize to JSON string
-    string toJSON() const {
-        ostringstream j;
-        j << fixed << setprecision(4);
-        j << "{"
-          << "\"name\":\""              << name              << "\","
-          << "\"latitude\":"            << latitude          << ","
-          << "\"longitude\":"           << longitude         << ","
-          << "\"start_year\":"          << start_year        << ","
-          << "\"end_year\":"            << end_year          << ","
-          << "\"region\":\""            << region            << "\","
-          << "\"resource_density\":"    << resource_density  << ","
-          << "\"knowledge_density\":"   << knowledge_density << ","
-          << "\"military_strength\":"   << military_strength << ","
-          << "\"spatial_score\":"       << setprecision(2) << spatialScore()
-          << "}";
-        return j.str();
+private:
+    struct Job {
+        function<void()> fn;
+        chrono::steady_clock::time_point enqueued;
+    };
+    struct Lane {
+        deque<Job> jobs;
+        condition_variable ready;
+    };
+
+    mutex m;
+    Lane work, shed;
+    bool stopping = false;
+    vector<thread> threads;
+
+    void run(Lane& lane, bool shedLane) {
+        currentConnection.shedLane = shedLane;
+        while (true) {
+            Job job;
+            {
+                unique_lock<mutex> lock(m);
+                lane.ready.wait(lock, [&] { return stopping || !lane.jobs.empty(); });
+                if (lane.jobs.empty()) return;
+                job = move(lane.jobs.front());
+                lane.jobs.pop_front();
+                if (!shedLane) admission.queued = work.jobs.size();
+            }
+            currentConnection.firstRequest = true;
+            currentConnection.enqueued = job.enqueued;
+            job.fn(); // serves the connection, keep-alive requests included
+        }
     }
 };
 
+void sendOverloaded(httplib::Response& res, const string& why) {
+    sendError(res, why, 503);
+    res.set_header("Retry-After", to_string(admission.retryAfterSec));
+}
+
+// Pre-routing check for every request. Starts its deadline, counted from
+// when the connection was queued for its first request and from now for
+// keep-alive follow-ups, and returns false if it must be shed instead.
+bool admitRequest(httplib::Response& res) {
+    ConnectionState& cur = currentConnection;
+    if (cur.shedLane) {
+        admission.shedQueueFull++;
+        sendOverloaded(res, "Server overloaded, retry later");
+        return false;
+    }
+    requestDeadline.start(cur.firstRequest ? cur.enqueued : chrono::steady_clock::now(), admission.timeout);
+    cur.firstRequest = false;
+    if (requestDeadline.passed()) {
+        admission.shedDeadline++;
+        sendOverloaded(res, "Request waited past its deadline, retry later");
+        return false;
+    }
+    return true;
+}
+
 // ─────────────────────────────────────────────
-//  KD-TREE
+//  SINGLE-FLIGHT (identical concurrent queries)
 // ─────────────────────────────────────────────
 
-struct KDNode {
-    Civilization civ;
-    KDNode* left  = nullptr;
-    KDNode* right = nullptr;
-    int depth     = 0;
-    KDNode(Civilization c, int d) : civ(c), depth(d) {}
-};
+// A popular map view makes many clients send the same query at once. The
+// first one renders the response; identical requests arriving while it
+// runs wait for it and send the same serialized body.
+SingleFlight<string> nearestFlight, rangeFlight;
 
-class KDTree {
-private:
-    KDNode* root = nullptr;
-    int     nodeCount = 0;
-
-    double dist(const Civilization& a, const Civilization& b) const {
-        double dl = a.latitude  - b.latitude;
-        double dn = a.longitude - b.longitude;
-        return sqrt(dl*dl + dn*dn);
-    }
-
-    KDNode* insert(KDNode* node, Civilization civ, int depth) {
-        if (!node) { nodeCount++; return new KDNode(civ, depth); }
-        int axis = depth % 2;
-        double nv = axis==0 ? node->civ.latitude  : node->civ.longitude;
-        double cv = axis==0 ? civ.latitude        : civ.longitude;
-        if (cv < nv) node->left  = insert(node->left,  civ, depth+1);
-        else         node->right = insert(node->right, civ, depth+1);
-        return node;
-    }
-
-    void nearestSearch(KDNode* node, const Civilization& q,
-                       KDNode*& best, double& bestDist, int depth) const {
-        if (!node) return;
-        double d = dist(node->civ, q);
-        if (d < bestDist) { bestDist = d; best = node; }
-        int axis = depth % 2;
-        double nv = axis==0 ? node->civ.latitude  : node->civ.longitude;
-        double qv = axis==0 ? q.latitude          : q.longitude;
-        KDNode* first  = qv < nv ? node->left  : node->right;
-        KDNode* second = qv < nv ? node->right : node->left;
-        nearestSearch(first,  q, best, bestDist, depth+1);
-        if (abs(qv - nv) < bestDist)
-            nearestSearch(second, q, best, bestDist, depth+1);
-    }
-
-    void rangeSearch(KDNode* node,
-                     double latMin, double latMax,
-                     double lonMin, double lonMax,
-                     vector<Civilization>& res, int depth) const {
-        if (!node) return;
-        double lat = node->civ.latitude, lon = node->civ.longitude;
-        if (lat>=latMin && lat<=latMax && lon>=lonMin && lon<=lonMax)
-            res.push_back(node->civ);
-        int axis = depth % 2;
-        double nv   = axis==0 ? lat    : lon;
-        double minV = axis==0 ? latMin : lonMin;
-        double maxV = axis==0 ? latMax : lonMax;
-        if (minV <= nv) rangeSearch(node->left,  latMin, latMax, lonMin, lonMax, res, depth+1);
-        if (maxV >= nv) rangeSearch(node->right, latMin, latMax, lonMin, lonMax, res, depth+1);
-    }
-
-    void deleteTree(KDNode* n) {
-        if (!n) return;
-        deleteTree(n->left); deleteTree(n->right); delete n;
+// Key from the parsed parameter values, so spelling ("10" vs "10.0") and
+// parameter order don't split a herd. The dataset version is part of it: a
+// request that already sees a newer snapshot must not reuse an older result.
+template <typename... T>
+string flightKey(const Dataset& ds, const T&... parts) {
+    string key;
+    key.reserve(sizeof(ds.version) + (sizeof(parts) + ...));
+    key.append(reinterpret_cast<const char*>(&ds.version), sizeof(ds.version));
+    (key.append(reinterpret_cast<const char*>(&parts), sizeof(parts)), ...);
+    return key;
+}
+
+// Sends the body for `key`, rendering it with render() unless an identical
+// request is already doing so. A follower still waiting at its deadline
+// gets a 503.
+template <typename F>
+void sendCoalesced(httplib::Response& res, SingleFlight<string>& flight, const string& key,
+                   const char* type, F&& render) {
+    auto body = flight.run(key, requestDeadline.deadline(), forward<F>(render));
+    if (!body) {
+        admission.cancelled++;
+        sendOverloaded(res, "Deadline exceeded, retry later");
+        return;
     }
+    addCORS(res);
+    res.set_content(*body, type);
+}
 
-public:
-    ~KDTree() { deleteTree(root); }
+// ─────────────────────────────────────────────
+//  RANGE RESULTS (/api/range)
+// ─────────────────────────────────────────────
 
-    void insert(Civilization civ) { root = insert(root, civ, 0); }
+const size_t DEFAULT_TOP_K = 10;
 
-    Civilization nearestNeighbor(double lat, double lon) const {
-        if (!root) throw runtime_error("Tree is empty");
-        Civilization q; q.latitude = lat; q.longitude = lon;
-        KDNode* best = nullptr; double bestDist = numeric_limits<double>::max();
-        nearestSearch(root, q, best, bestDist, 0);
-        return best->civ;
+// JSON pages of at most this many rows are rendered whole so identical
+// requests can share them; larger ones are streamed per request.
+// CIVMAP_COALESCE_MAX_ROWS overrides the default.
+const size_t COALESCE_MAX_ROWS = (size_t)envOr("CIVMAP_COALESCE_MAX_ROWS", 4096);
+
+// ?orderBy=score: hits offset .. offset+limit-1 ranked by spatial score.
+// Best-first search on the per-node max score, so a huge box costs about
+// the same as a small one.
+string renderRangeByScore(bool frame, const Dataset& ds,
+                          double latMin, double latMax, double lonMin, double lonMax,
+                          size_t offset, size_t limit) {
+    vector<Ranked<CivRecord>> top;
+    size_t total;
+    {
+        Metrics::PhaseTimer t(Metrics::Phase::Index);
+        top = ds.topByScore(latMin, latMax, lonMin, lonMax, offset + min(limit, SIZE_MAX - offset));
+        total = ds.count(latMin, latMax, lonMin, lonMax);
+    }
+    size_t count = top.size() > offset ? top.size() - offset : 0;
+    bool truncated = total > offset + count;
+
+    Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+    string body;
+    if (frame) {
+        CivFrameBuilder b = civFrameBuilder();
+        b.reserve(count);
+        for (size_t i = offset; i < top.size(); i++) appendCivRow(b, *top[i].item);
+        body = b.finish((uint32_t)count, truncated ? CivFrame::FLAG_TRUNCATED : 0);
+    } else {
+        JsonWriter& w = threadJsonWriter();
+        w.raw("{\"query\":{\"latMin\":").number(latMin).raw(",\"latMax\":").number(latMax)
+         .raw(",\"lonMin\":").number(lonMin).raw(",\"lonMax\":").number(lonMax)
+         .raw(",\"order_by\":\"score\"},\"results\":[");
+        for (size_t i = offset; i < top.size(); i++) {
+            if (i > offset) w.raw(',');
+            top[i].item->writeJSON(w);
+        }
+        w.raw("],\"count\":").number(count)
+         .raw(",\"total\":").number(total)
+         .raw(",\"truncated\":").boolean(truncated)
+         .raw(",\"algorithm\":\"KD-Tree best-first top-k on per-node max score\"}");
+        body = w.str();
     }
+    t.stop();
+    LOG_REQUEST("[GET] /api/range?orderBy=score  → " << count << " of " << total << " results");
+    return body;
+}
+
+// One JSON /api/range body, produced a chunk at a time from a KD-tree range
+// cursor by httplib's chunked content provider. The provider is called
+// again only after the previous chunk was written to the socket, so a slow
+// client holds back the traversal and a request never buffers more than
+// about one chunk. Owns the dataset snapshot the cursor walks.
+class RangeStream {
+public:
+    static constexpr size_t CHUNK_BYTES = 64 * 1024;
+    static constexpr size_t BATCH = 64; // hits serialized between size checks
 
-    double nearestDist(double lat, double lon) const {
-        Civilization q; q.latitude = lat; q.longitude = lon;
-        KDNode* best = nullptr; double bestDist = numeric_limits<double>::max();
-        nearestSearch(root, q, best, bestDist, 0);
-        return bestDist;
+    RangeStream(shared_ptr<const Dataset> snapshot, double latMin, double latMax,
+                double lonMin, double lonMax, size_t offset, size_t limit, bool explain)
+        : ds(move(snapshot)), cursor(ds->rangeCursor(latMin, latMax, lonMin, lonMax)),
+          offset(offset), limit(limit), explain(explain) {
+        w.reserve(CHUNK_BYTES + 4096);
+        w.raw("{\"query\":{\"latMin\":").number(latMin).raw(",\"latMax\":").number(latMax)
+         .raw(",\"lonMin\":").number(lonMin).raw(",\"lonMax\":").number(lonMax)
+         .raw("},\"results\":[");
     }
 
-    vector<Civilization> rangeQuery(double latMin, double latMax,
-                                    double lonMin, double lonMax) const {
-        vector<Civilization> res;
-        rangeSearch(root, latMin, latMax, lonMin, lonMax, res, 0);
-        return res;
+    // Writes the next chunk, and the closing fields once the page is complete
+    bool pump(httplib::DataSink& sink) {
+        return explain ? pump(sink, stats) : pump(sink, none);
     }
 
-    int size() const { return nodeCount; }
+private:
+    shared_ptr<const Dataset> ds;
+    Dataset::RangeCursor cursor;
+    size_t offset, limit;
+    size_t skipped = 0, count = 0;
+    JsonWriter w;
+    bool explain;
+    QueryStats stats;
+    NoStats none;
+
+    // Past the request deadline the page is cut short and closed with
+    // "timed_out": the headers are already sent, so a 503 is no longer possible
+    template <typename Stats>
+    bool pump(httplib::DataSink& sink, Stats& st) {
+        auto skip = [](const CivRecord&) {};
+        bool timedOut = requestDeadline.passed();
+        while (!timedOut && skipped < offset && !cursor.done()) {
+            skipped += cursor.next(min(offset - skipped, CHUNK_BYTES), skip, st);
+            timedOut = requestDeadline.passed();
+        }
+        while (!timedOut && w.size() < CHUNK_BYTES && count < limit && !cursor.done())
+            cursor.next(min(limit - count, BATCH), [this](const CivRecord& c) {
+                if (count++) w.raw(',');
+                c.writeJSON(w);
+            }, st);
+
+        bool finished = timedOut || count == limit || cursor.done();
+        if (finished) {
+            bool truncated = timedOut || (count == limit && cursor.next(1, skip, st) > 0);
+            if (timedOut) admission.cancelled++;
+            w.raw("],\"count\":").number(count)
+             .raw(",\"truncated\":").boolean(truncated)
+             .raw(",\"timed_out\":").boolean(timedOut)
+             .raw(",\"algorithm\":\"KD-Tree O(log n + k) spatial pruning\"");
+            if (explain) writeQueryStats(w.raw(",\"explain\":"), stats);
+            w.raw('}');
+        }
+        if (w.size() && !sink.write(w.data(), w.size())) return false; // client went away
+        w.clear();
+        if (finished) {
+            sink.done();
+            LOG_REQUEST("[GET] /api/range  → " << count << " results (streamed)");
+        }
+        return true;
+    }
 };
 
+// A page small enough to share, as the same body RangeStream would send
+string renderRangePage(shared_ptr<const Dataset> ds, double latMin, double latMax,
+                       double lonMin, double lonMax, size_t offset, size_t limit) {
+    RangeStream stream(move(ds), latMin, latMax, lonMin, lonMax, offset, limit, false);
+    string body;
+    bool finished = false;
+    httplib::DataSink sink;
+    sink.write = [&](const char* data, size_t n) { body.append(data, n); return true; };
+    sink.done = [&] { finished = true; };
+    while (!finished) stream.pump(sink);
+    return body;
+}
+
 // ─────────────────────────────────────────────
-//  R-TREE
+//  WRITES (batched, published read-copy-update)
 // ─────────────────────────────────────────────
 
-struct BoundingBox {
-    string label;
-    double latMin, latMax, lonMin, lonMax;
-    bool contains(double lat, double lon) const {
-        return lat>=latMin && lat<=latMax && lon>=lonMin && lon<=lonMax;
+// Fields of a POST/PUT body; absent fields are left unchanged
+struct CivPatch {
+    optional<string> name, region;
+    optional<double> latitude, longitude;
+    optional<int>    startYear, endYear;
+    optional<double> resourceDensity, knowledgeDensity, militaryStrength;
+
+    void applyTo(CivRecord& c) const {
+        if (name)              c.name              = *name;
+        if (region)            c.region            = *region;
+        if (latitude)          c.latitude          = *latitude;
+        if (longitude)         c.longitude         = *longitude;
+        if (startYear)         c.startYear         = *startYear;
+        if (endYear)           c.endYear           = *endYear;
+        if (resourceDensity)   c.resourceDensity   = *resourceDensity;
+        if (knowledgeDensity)  c.knowledgeDensity  = *knowledgeDensity;
+        if (militaryStrength)  c.militaryStrength  = *militaryStrength;
+    }
+};
+
+// Parses a JSON object of civilization fields. "id" and "spatial_score" are
+// ignored so a record fetched from the API can be sent back as is. Throws
+// on unknown fields, wrong types and out-of-range values.
+CivPatch parseCivPatch(const string& body) {
+    CivPatch p;
+    for (const auto& [key, v] : JsonReader::parseObject(body)) {
+        auto number = [&](double lo, double hi) {
+            if (v.kind != JsonReader::Value::Number || v.number < lo || v.number > hi)
+                throw invalid_argument("Field " + key + " must be a number in [" +
+                                       to_string((long)lo) + ", " + to_string((long)hi) + "]");
+            return v.number;
+        };
+        auto year = [&]() {
+            double y = number(-100000, 100000);
+            if (y != floor(y)) throw invalid_argument("Field " + key + " must be an integer");
+            return (int)y;
+        };
+        auto text = [&]() {
+            if (v.kind != JsonReader::Value::String) throw invalid_argument("Field " + key + " must be a string");
+            return v.text;
+        };
+
+        if      (key == "name")              { p.name = text(); if (normalizeName(*p.name).empty()) throw invalid_argument("Field name must not be blank"); }
+        else if (key == "region")            p.region            = text();
+        else if (key == "latitude")          p.latitude          = number(-90, 90);
+        else if (key == "longitude")         p.longitude         = number(-180, 180);
+        else if (key == "start_year")        p.startYear         = year();
+        else if (key == "end_year")          p.endYear           = year();
+        else if (key == "resource_density")  p.resourceDensity   = number(0, 100);
+        else if (key == "knowledge_density") p.knowledgeDensity  = number(0, 100);
+        else if (key == "military_strength") p.militaryStrength  = number(0, 100);
+        else if (key != "id" && key != "spatial_score") throw invalid_argument("Unknown field: " + key);
     }
+    return p;
+}
+
+struct WriteResult {
+    int      status  = 200;
+    long     id      = -1;
+    uint64_t version = 0;  // dataset version that contains the write
+    string   error;
+};
+
+struct Mutation {
+    enum Kind { Insert, Update, Delete, Replace } kind;
+    long     id = -1;                 // Update/Delete target
+    CivPatch patch;                   // Insert/Update
+    shared_ptr<Dataset> replacement;  // Replace: fully built, ids are positions
+    promise<WriteResult> done;
+
+    explicit Mutation(Kind k) : kind(k) {}
 };
 
-class RTree {
-    vector<BoundingBox> regions;
+// Owns every change to the dataset. Requests queue mutations and wait for
+// the batch that applies them: once a write arrives the writer collects for
+// one `window`, then publishes the whole batch with one atomic store as a
+// snapshot that shares the current base under a new delta (see Dataset).
+// Readers never lock, and a batch costs O(d log d) for the d records edited
+// since the last merge rather than a rebuild of every index.
+//
+// Once the delta reaches CIVMAP_MERGE_EDITS records (default 4096), or
+// writes pause for CIVMAP_MERGE_IDLE_MS (default 1000) with edits pending, a
+// merge thread builds a new base from the latest snapshot while batches keep
+// being published. The writer then re-applies the edits made meanwhile on
+// top of it and publishes that; a reload in between discards the merge.
+//
+// Replaced snapshots are parked until no request holds them and freed here,
+// so tearing down a large index never lands on a request thread.
+class DatasetWriter {
+private:
+    mutex                m;
+    condition_variable   wake;
+    vector<Mutation>     pending;
+    bool                 stopping = false;
+    chrono::milliseconds window{5};
+    long                 nextId = 0;
+    thread               worker;
+    vector<shared_ptr<const Dataset>> retired;
+    chrono::steady_clock::time_point lastBatch;
+
+    // Merging. `merged` and `mergeDone` are handed over by the merge thread
+    // under m; the rest belongs to the writer thread.
+    size_t                  mergeEdits = (size_t)envOr("CIVMAP_MERGE_EDITS", 4096);
+    chrono::milliseconds    mergeIdle{(long)envOr("CIVMAP_MERGE_IDLE_MS", 1000)};
+    thread                  merger;
+    bool                    merging = false, mergeStale = false, mergeDone = false;
+    shared_ptr<DatasetBase> merged;
+    vector<long>            touched; // ids edited since the merged snapshot
+
+    void run() {
+        unique_lock<mutex> lock(m);
+        auto ready = [this] { return stopping || !pending.empty() || mergeDone; };
+        while (true) {
+            // Poll while retired snapshots are still draining or edits wait for an idle merge
+            if (retired.empty() && (merging || !dataset()->edits())) wake.wait(lock, ready);
+            else wake.wait_for(lock, chrono::milliseconds(100), ready);
+            if (stopping && pending.empty()) break;
+            if (mergeDone) {
+                mergeDone = false;
+                shared_ptr<DatasetBase> base = move(merged);
+                lock.unlock();
+                adopt(move(base));
+                lock.lock();
+            }
+            if (!pending.empty()) {
+                wake.wait_for(lock, window, [this] { return stopping; });
+                vector<Mutation> batch;
+                batch.swap(pending);
+                lock.unlock();
+                applyBatch(batch);
+                lock.lock();
+            }
+            lock.unlock();
+            startMerge();
+            reclaim();
+            lock.lock();
+        }
+        lock.unlock();
+        if (merger.joinable()) merger.join();
+    }
+
+    // A retired snapshot can't be handed out again, so once we hold the
+    // only reference no request can still be using it
+    void reclaim() {
+        vector<shared_ptr<const Dataset>> drained; // destroyed outside the lock
+        lock_guard<mutex> lock(m);
+        auto busy = partition(retired.begin(), retired.end(),
+                              [](const shared_ptr<const Dataset>& d) { return d.use_count() > 1; });
+        move(busy, retired.end(), back_inserter(drained));
+        retired.erase(busy, retired.end());
+    }
+
+    void publish(shared_ptr<Dataset> ds) {
+        auto previous = publishDataset(move(ds));
+        lock_guard<mutex> lock(m);
+        if (previous) retired.push_back(move(previous));
+    }
+
+    // Merges the current snapshot into a new base on the merge thread, once
+    // its delta is large enough or writes have paused
+    void startMerge() {
+        if (merging) return;
+        auto source = dataset();
+        size_t edits = source->edits();
+        if (edits == 0 || (edits < mergeEdits && chrono::steady_clock::now() - lastBatch < mergeIdle)) return;
+        if (merger.joinable()) merger.join();
+        merging = true;
+        mergeStale = false;
+        touched.clear();
+        merger = thread([this, source] {
+            shared_ptr<DatasetBase> base;
+            try {
+                vector<CivRecord> civs;
+                civs.reserve(source->size());
+                source->forEach([&](const CivRecord& c) { civs.push_back(c); });
+                base = buildBase(move(civs));
+            } catch (exception& e) {
+                LOG_ERROR("Merge failed, edits stay in the delta: " << e.what());
+            }
+            lock_guard<mutex> lock(m);
+            merged = move(base);
+            mergeDone = true;
+            wake.notify_one();
+        });
+    }
+
+    // Publishes a finished merge with the edits made since re-applied
+    void adopt(shared_ptr<DatasetBase> base) {
+        merging = false;
+        if (!base || mergeStale) return;
+        auto current = dataset();
+        sort(touched.begin(), touched.end());
+        touched.erase(unique(touched.begin(), touched.end()), touched.end());
+        vector<CivRecord> added;
+        vector<long> hiddenIds;
+        for (long id : touched) {
+            if (const CivRecord* c = current->byId(id)) added.push_back(*c);
+            if (base->byId(id)) hiddenIds.push_back(id);
+        }
+        touched.clear();
+        try {
+            publish(makeDataset(move(base), move(added), move(hiddenIds), current->rTree));
+            merges++;
+        } catch (exception& e) {
+            LOG_ERROR("Merge failed, edits stay in the delta: " << e.what());
+        }
+    }
+
+    // Region from the R-tree for records submitted without one
+    static void fillRegion(CivRecord& c, const RegionIndex& regions) {
+        if (!c.region.empty()) return;
+        auto labels = regions.queryPoint(c.latitude, c.longitude);
+        if (!labels.empty()) c.region = labels.front();
+    }
+
+    void applyBatch(vector<Mutation>& batch) {
+        auto start = chrono::steady_clock::now();
+
+        // Edits collect on top of `source`. A Replace swaps the source; if
+        // nothing edits it afterwards it is published as it is.
+        shared_ptr<const Dataset> source = dataset();
+        shared_ptr<Dataset> replacement;
+        map<long, optional<CivRecord>> edits; // id → new record, or nullopt once deleted
+        unordered_map<string, long> names;    // normalised name → owner id (-1: free), where this batch changed it
+        auto current = [&](long id) -> const CivRecord* {
+            auto e = edits.find(id);
+            if (e != edits.end()) return e->second ? &*e->second : nullptr;
+            return source->byId(id);
+        };
+        auto owner = [&](const string& key) -> long {
+            auto n = names.find(key);
+            if (n != names.end()) return n->second;
+            const CivRecord* c = source->findName(key);
+            return c ? c->id : -1;
+        };
+
+        vector<WriteResult> results(batch.size());
+        for (size_t i = 0; i < batch.size(); i++) {
+            Mutation& mu = batch[i];
+            WriteResult& r = results[i];
+            r.id = mu.id;
+
+            if (mu.kind == Mutation::Replace) {
+                source = replacement = mu.replacement;
+                edits.clear();
+                names.clear();
+                nextId = (long)source->size();
+                mergeStale = merging;
+                continue;
+            }
+
+            if (mu.kind == Mutation::Insert) {
+                CivRecord c{};
+                mu.patch.applyTo(c);
+                string key = normalizeName(c.name);
+                if (owner(key) >= 0) { r.status = 409; r.error = "Civilization already exists: " + c.name; continue; }
+                fillRegion(c, *source->rTree);
+                c.id = nextId++;
+                c.prepareJSON();
+                r.id = c.id;
+                r.status = 201;
+                names[key] = c.id;
+                edits[c.id] = move(c);
+                continue;
+            }
+
+            const CivRecord* target = current(mu.id);
+            if (!target) { r.status = 404; r.error = "No civilization with id " + to_string(mu.id); continue; }
+            string oldKey = normalizeName(target->name);
+
+            if (mu.kind == Mutation::Delete) {
+                if (owner(oldKey) == mu.id) names[oldKey] = -1;
+                edits[mu.id] = nullopt;
+                continue;
+            }
+
+            CivRecord c = *target;
+            mu.patch.applyTo(c);
+            string key = normalizeName(c.name);
+            if (key != oldKey) {
+                if (owner(key) >= 0) { r.status = 409; r.error = "Civilization already exists: " + c.name; continue; }
+                if (owner(oldKey) == c.id) names[oldKey] = -1;
+                names[key] = c.id;
+            }
+            fillRegion(c, *source->rTree);
+            c.prepareJSON();
+            edits[c.id] = move(c);
+        }
+
+        try {
+            if (!edits.empty()) {
+                publish(applyEdits(*source, edits));
+                if (merging)
+                    for (const auto& e : edits) touched.push_back(e.first);
+                batches++;
+            } else if (replacement) {
+                publish(replacement);
+                batches++;
+            }
+        } catch (exception& e) {
+            for (auto& r : results)
+                if (r.status < 400) { r.status = 500; r.error = e.what(); }
+        }
+        lastBatch = chrono::steady_clock::now();
+        lastBatchSeconds = chrono::duration<double>(lastBatch - start).count();
+        uint64_t version = dataset()->version;
+        for (size_t i = 0; i < batch.size(); i++) {
+            results[i].version = version;
+            batch[i].done.set_value(move(results[i]));
+        }
+    }
+
 public:
-    void addRegion(string label, double latMin, double latMax,
-                   double lonMin, double lonMax) {
-        regions.push_back({label, latMin, latMax, lonMin, lonMax});
+    atomic<uint64_t> batches{0}, merges{0};
+    atomic<double>   lastBatchSeconds{0};
+
+    ~DatasetWriter() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    // `firstId` is the id given to the next inserted record
+    void start(long firstId, chrono::milliseconds batchWindow) {
+        nextId = firstId;
+        window = batchWindow;
+        worker = thread([this] { run(); });
+    }
+
+    // Blocks until the batch holding the mutation has been published
+    WriteResult apply(Mutation mu) {
+        future<WriteResult> result = mu.done.get_future();
+        {
+            lock_guard<mutex> lock(m);
+            pending.push_back(move(mu));
+        }
+        wake.notify_one();
+        return result.get();
     }
-    vector<string> queryPoint(double lat, double lon) const {
-        vector<string> res;
-        for (const auto& r : regions)
-            if (r.contains(lat, lon)) res.push_back(r.label);
-        return res;
+
+    size_t retiredSnapshots() {
+        lock_guard<mutex> lock(m);
+        return retired.size();
     }
-    int size() const { return (int)regions.size(); }
 };
 
-// ─────────────────────────────────────────────
-//  JSON HELPERS
-// ─────────────────────────────────────────────
+DatasetWriter writer;
 
-// Escape quotes in strings for JSON safety
-string jsonEscape(const string& s) {
-    string out;
-    for (char c : s) {
-        if (c=='"') out += "\\\"";
-        else if (c=='\\') out += "\\\\";
-        else out += c;
+void sendWriteResult(httplib::Response& res, const WriteResult& r, bool withRecord) {
+    if (r.status >= 400) { sendError(res, r.error, r.status); return; }
+    auto ds = dataset();
+    const CivRecord* c = withRecord ? ds->byId(r.id) : nullptr;
+    JsonWriter& w = threadJsonWriter();
+    w.raw("{\"id\":").number((long long)r.id)
+     .raw(",\"version\":").number((long long)r.version);
+    if (c) {
+        w.raw(",\"civilization\":");
+        c->writeJSON(w);
     }
-    return out;
+    w.raw('}');
+    res.status = r.status;
+    sendJSON(res, w);
 }
 
-string vecsToJSON(const vector<Civilization>& civs) {
-    string json = "[";
-    for (size_t i = 0; i < civs.size(); i++) {
-        json += civs[i].toJSON();
-        if (i < civs.size()-1) json += ",";
-    }
-    json += "]";
-    return json;
+long pathNumber(const httplib::Request& req, const string& name) {
+    const string& text = req.path_params.at(name);
+    size_t used = 0;
+    long v = -1;
+    try { v = stol(text, &used); } catch (exception&) {}
+    if (used == 0 || used != text.size()) throw invalid_argument("Bad " + name + ": " + text);
+    return v;
 }
 
+long pathId(const httplib::Request& req) { return pathNumber(req, "id"); }
+
 // ─────────────────────────────────────────────
-//  CSV LOADER
+//  LOADING + HOT RELOAD
 // ─────────────────────────────────────────────
 
-vector<Civilization> loadFromCSV(const string& filename) {
-    vector<Civilization> civs;
-    ifstream file(filename);
-    if (!file.is_open()) {
-        cerr << "Could not open " << filename << " — using built-in data.\n";
-        return civs;
+// Reads the CSVs and builds a complete snapshot; ids are load positions
+shared_ptr<Dataset> loadDataset() {
+    // 1. Load data
+    vector<CivRecord> allCivs = loadFromCSV("civilizations.csv");
+    if (allCivs.empty()) allCivs = getBuiltinData();
+    LOG_INFO("✅ Loaded " << allCivs.size() << " civilizations.");
+
+    // 2. Build R-Tree regions: polygons if available, else boxes
+    auto rTree = make_shared<RegionIndex>();
+    auto polygons = loadRegionPolygons("region_polygons.csv");
+    if (!polygons.empty()) {
+        rTree->build(polygons);
+    } else {
+        auto regions = loadRegions("regions.csv");
+        if (regions.empty()) regions = getBuiltinRegions();
+        rTree->build(regions);
     }
-    string line;
-    getline(file, line); // skip header
-    while (getline(file, line)) {
-        if (line.empty()) continue;
-        istringstream ss(line);
-        Civilization c;
-        string tok;
-        getline(ss, c.name,   ',');
-        getline(ss, tok, ','); c.latitude          = stod(tok);
-        getline(ss, tok, ','); c.longitude         = stod(tok);
-        getline(ss, tok, ','); c.start_year        = stoi(tok);
-        getline(ss, tok, ','); c.end_year          = stoi(tok);
-        getline(ss, c.region, ',');
-        getline(ss, tok, ','); c.resource_density  = stod(tok);
-        getline(ss, tok, ','); c.knowledge_density = stod(tok);
-        getline(ss, tok, ','); c.military_strength = stod(tok);
-        civs.push_back(c);
+    LOG_INFO("✅ R-Tree built: " << rTree->size() << " regions, height " << rTree->height() << ".");
+
+    // 3. Fill in civilizations that arrived without a region
+    vector<pair<double,double>> unassigned;
+    vector<size_t> unassignedIdx;
+    for (size_t i = 0; i < allCivs.size(); i++) {
+        if (!allCivs[i].region.empty()) continue;
+        unassigned.push_back({allCivs[i].latitude, allCivs[i].longitude});
+        unassignedIdx.push_back(i);
     }
-    return civs;
-}
+    auto assigned = rTree->assignAll(unassigned);
+    for (size_t i = 0; i < assigned.size(); i++)
+        if (assigned[i] >= 0) allCivs[unassignedIdx[i]].region = rTree->label(assigned[i]);
+    for (size_t i = 0; i < allCivs.size(); i++) {
+        allCivs[i].id = (long)i;
+        allCivs[i].prepareJSON();
+    }
+    LOG_INFO("✅ Regions assigned to " << unassigned.size() << " unlabelled civilizations.");
 
-vector<Civilization> getBuiltinData() {
-    return {
-        {"Indus Valley",    27.0,  68.0,-3300,-1300,"South Asia",   88,85,60},
-        {"Ancient Egypt",   26.8,  30.8,-3100, -332,"North Africa", 80,78,81},
-        {"Mesopotamia",     33.0,  44.4,-3500, -539,"Middle East",  78,80,75},
-        {"Ancient Greece",  37.9,  23.7, -800, -146,"Mediterranean",70,95,72},
-        {"Roman Empire",    41.9,  12.5,  -27,  476,"Mediterranean",80,70,88},
-        {"Maurya Empire",   25.0,  83.0, -322, -185,"South Asia",   85,88,85},
-        {"Han China",       35.0, 105.0, -206,  220,"East Asia",    88,90,85},
-        {"Maya",            16.0, -89.0,  250,  900,"Mesoamerica",  70,88,65},
-        {"Persian Empire",  32.0,  53.0, -550, -330,"Middle East",  85,75,90},
-        {"Byzantine",       41.0,  29.0,  330, 1453,"Mediterranean",75,80,78},
-        {"Vedic India",     28.0,  77.0,-1500, -600,"South Asia",   75,92,70},
-        {"Aztec",           19.4, -99.1, 1300, 1521,"Mesoamerica",  72,80,85},
-        {"Mongol Empire",   47.0, 106.0, 1206, 1368,"Central Asia", 65,60,98},
-        {"Ottoman Empire",  39.9,  32.9, 1299, 1922,"Middle East",  80,72,88},
-        {"Inca",           -13.5, -72.0, 1400, 1533,"South America",78,75,82},
-        {"Gupta Empire",    24.5,  82.5,  320,  550,"South Asia",   85,95,78},
-        {"Chola Dynasty",   10.8,  79.7,  300, 1279,"South India",  82,88,86},
-        {"Vijayanagara",    15.3,  76.5, 1336, 1646,"South India",  80,85,84},
-        {"Maratha Empire",  18.5,  73.8, 1674, 1818,"South Asia",   78,75,92},
-        {"Delhi Sultanate", 28.6,  77.2, 1206, 1526,"South Asia",   76,72,88},
-        {"Mughal Empire",   27.2,  78.0, 1526, 1857,"South Asia",   90,88,90},
-        {"Pallava Dynasty", 12.8,  79.7,  275,  897,"South India",  78,87,80},
-        {"Satavahana",      17.0,  79.5, -230,  220,"South Asia",   80,82,78},
-        {"Kushana Empire",  34.0,  67.0,   30,  375,"Central Asia", 82,80,85},
-        {"Rashtrakuta",     17.3,  76.8,  753,  982,"South India",  79,84,83},
-        {"Pala Empire",     25.6,  85.1,  750, 1161,"South Asia",   77,90,76},
-        {"Chera Kingdom",   10.5,  76.2, -300, 1102,"South India",  83,82,75},
-    };
+    // 4. Build KD-Tree + name index
+    auto ds = buildDataset(move(allCivs), move(rTree));
+    LOG_INFO("✅ KD-Tree built: " << ds->base->kdTree.size() << " nodes; name index built.");
+    return ds;
 }
 
-// ─────────────────────────────────────────────
-//  GLOBAL STATE
-// ─────────────────────────────────────────────
+// Rebuilds the dataset from disk on its own thread, then hands the finished
+// snapshot to the writer, which publishes it in order with other writes
+// (records added over the API since the last load are replaced). Requests
+// are served from the current snapshot throughout. A reload requested while
+// one is running runs again afterwards, so the latest files always win.
+class Reloader {
+private:
+    mutex              m;
+    condition_variable wake;
+    bool               requested = false, running = false, stopping = false;
+    thread             worker;
+
+    void run() {
+        unique_lock<mutex> lock(m);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || requested; });
+            if (stopping) return;
+            requested = false;
+            running = true;
+            lock.unlock();
+            reloadOnce();
+            lock.lock();
+            running = false;
+        }
+    }
+
+    void reloadOnce() {
+        auto start = chrono::steady_clock::now();
+        try {
+            Mutation mu{Mutation::Replace};
+            mu.replacement = loadDataset();
+            WriteResult r = writer.apply(move(mu));
+            if (r.status >= 400) throw runtime_error(r.error);
+            lastSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+            completed++;
+            LOG_INFO("🔄 Reloaded dataset → version " << r.version << " in "
+                     << (long)(lastSeconds.load() * 1000) << " ms");
+        } catch (exception& e) {
+            failed++;
+            LOG_ERROR("Reload failed, still serving the previous dataset: " << e.what());
+        }
+    }
+
+public:
+    atomic<uint64_t> completed{0}, failed{0};
+    atomic<double>   lastSeconds{0};
+
+    ~Reloader() {
+        {
+            lock_guard<mutex> lock(m);
+            stopping = true;
+        }
+        wake.notify_one();
+        if (worker.joinable()) worker.join();
+    }
+
+    void start() { worker = thread([this] { run(); }); }
 
-vector<Civilization> allCivs;
-KDTree kdTree;
-RTree  rTree;
+    // "started", or "queued" behind a reload that is already running
+    const char* request() {
+        lock_guard<mutex> lock(m);
+        requested = true;
+        wake.notify_one();
+        return running ? "queued" : "started";
+    }
+};
+
+Reloader reloader;
+
+#ifndef _WIN32
+// SIGHUP is blocked in every thread and taken with sigwait() on a watcher
+// thread, so the reload starts from ordinary code rather than a signal
+// handler. Must run before any other thread is created.
+void watchSighup() {
+    sigset_t set;
+    sigemptyset(&set);
+    sigaddset(&set, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &set, nullptr);
+    thread([set] {
+        int sig;
+        while (sigwait(&set, &sig) == 0) {
+            LOG_INFO("SIGHUP: reload " << reloader.request());
+        }
+    }).detach();
+}
+#endif
 
 // ─────────────────────────────────────────────
-//  CORS HELPER
+//  METRICS
 // ─────────────────────────────────────────────
 
-void addCORS(httplib::Response& res) {
-    res.set_header("Access-Control-Allow-Origin",  "*");
-    res.set_header("Access-Control-Allow-Methods", "GET, POST, OPTIONS");
-    res.set_header("Access-Control-Allow-Headers", "Content-Type");
-}
+Metrics::Registry metrics;
 
-void sendJSON(httplib::Response& res, const string& json) {
-    addCORS(res);
-    res.set_content(json, "application/json");
+// Wraps a route handler with request count/latency/in-flight/error
+// recording. Routes are registered in the registry at startup, before
+// the server accepts requests.
+httplib::Server::Handler instrumented(const string& route, httplib::Server::Handler handler) {
+    Metrics::Route* m = &metrics.route(route);
+    return [m, handler](const httplib::Request& req, httplib::Response& res) {
+        Metrics::RequestScope scope(*m, res.status);
+        handler(req, res);
+    };
 }
 
-void sendError(httplib::Response& res, const string& msg, int code=400) {
-    addCORS(res);
-    res.status = code;
-    res.set_content("{\"error\":\"" + jsonEscape(msg) + "\"}", "application/json");
+void registerIndexGauges() {
+    metrics.gauge("civmap_index_entries", "Entries per index.", "index=\"kdtree\"",
+                  [] { auto ds = dataset(); return (double)(ds->base->kdTree.size() + ds->added.kdTree.size()); });
+    metrics.gauge("civmap_index_entries", "Entries per index.", "index=\"rtree_regions\"",
+                  [] { return (double)dataset()->rTree->size(); });
+    metrics.gauge("civmap_index_entries", "Entries per index.", "index=\"nearest_cache\"",
+                  [] { return (double)nearestCache.entries(); });
+    metrics.gauge("civmap_index_height", "Tree height per index.", "index=\"rtree_regions\"",
+                  [] { return (double)dataset()->rTree->height(); });
+    metrics.gauge("civmap_dataset_version", "Current dataset version.", "",
+                  [] { return (double)datasetVersion.load(); });
+    metrics.gauge("civmap_dataset_pending_edits", "Records edited since the dataset base was merged.", "",
+                  [] { return (double)dataset()->edits(); });
+    metrics.counter("civmap_dataset_merges_total", "Edit deltas merged into a new dataset base.", "",
+                    [] { return (double)writer.merges.load(); });
+    metrics.gauge("civmap_write_batch_last_seconds", "Duration of the last write batch, publish included.", "",
+                  [] { return writer.lastBatchSeconds.load(); });
+    metrics.gauge("civmap_retired_snapshots", "Replaced dataset snapshots still held by in-flight requests.", "",
+                  [] { return (double)writer.retiredSnapshots(); });
+    metrics.counter("civmap_reloads_total", "Dataset reloads by outcome.", "outcome=\"ok\"",
+                    [] { return (double)reloader.completed.load(); });
+    metrics.counter("civmap_reloads_total", "Dataset reloads by outcome.", "outcome=\"failed\"",
+                    [] { return (double)reloader.failed.load(); });
+    metrics.gauge("civmap_reload_last_seconds", "Duration of the last successful reload.", "",
+                  [] { return reloader.lastSeconds.load(); });
+    metrics.counter("civmap_log_lines_total", "Log lines by outcome.", "outcome=\"written\"",
+                    [] { return (double)Logger::stats().written; });
+    metrics.counter("civmap_log_lines_total", "Log lines by outcome.", "outcome=\"dropped\"",
+                    [] { return (double)Logger::stats().dropped; });
+    metrics.counter("civmap_log_lines_total", "Log lines by outcome.", "outcome=\"sampled_out\"",
+                    [] { return (double)Logger::stats().sampledOut; });
+    metrics.counter("civmap_nearest_cache_lookups_total", "Nearest-cache lookups by outcome.", "outcome=\"hit\"",
+                    [] { return (double)nearestCache.hits.load(); });
+    metrics.counter("civmap_nearest_cache_lookups_total", "Nearest-cache lookups by outcome.", "outcome=\"miss\"",
+                    [] { return (double)nearestCache.misses.load(); });
+    metrics.counter("civmap_nearest_cache_lookups_total", "Nearest-cache lookups by outcome.", "outcome=\"uncacheable\"",
+                    [] { return (double)nearestCache.uncacheable.load(); });
+    metrics.counter("civmap_tile_cache_lookups_total", "Tile-cache lookups by outcome.", "outcome=\"hit\"",
+                    [] { return (double)tileCache.hits.load(); });
+    metrics.counter("civmap_tile_cache_lookups_total", "Tile-cache lookups by outcome.", "outcome=\"miss\"",
+                    [] { return (double)tileCache.misses.load(); });
+    metrics.gauge("civmap_workers", "Request worker threads.", "",
+                  [] { return (double)admission.workers; });
+    metrics.gauge("civmap_queue_depth", "Connections waiting for a worker.", "",
+                  [] { return (double)admission.queued.load(); });
+    metrics.gauge("civmap_queue_limit", "Queue depth beyond which requests are shed.", "",
+                  [] { return (double)admission.maxQueued; });
+    metrics.counter("civmap_shed_total", "Requests refused under load by reason.", "reason=\"queue_full\"",
+                    [] { return (double)admission.shedQueueFull.load(); });
+    metrics.counter("civmap_shed_total", "Requests refused under load by reason.", "reason=\"deadline\"",
+                    [] { return (double)admission.shedDeadline.load(); });
+    metrics.counter("civmap_shed_total", "Requests refused under load by reason.", "reason=\"dropped\"",
+                    [] { return (double)admission.dropped.load(); });
+    metrics.counter("civmap_singleflight_requests_total", "Coalescable requests by role: leaders render, followers reuse their body.",
+                    "route=\"/api/nearest\",role=\"leader\"", [] { return (double)nearestFlight.leaders.load(); });
+    metrics.counter("civmap_singleflight_requests_total", "Coalescable requests by role: leaders render, followers reuse their body.",
+                    "route=\"/api/nearest\",role=\"follower\"", [] { return (double)nearestFlight.followers.load(); });
+    metrics.counter("civmap_singleflight_requests_total", "Coalescable requests by role: leaders render, followers reuse their body.",
+                    "route=\"/api/range\",role=\"leader\"", [] { return (double)rangeFlight.leaders.load(); });
+    metrics.counter("civmap_singleflight_requests_total", "Coalescable requests by role: leaders render, followers reuse their body.",
+                    "route=\"/api/range\",role=\"follower\"", [] { return (double)rangeFlight.followers.load(); });
+    metrics.gauge("civmap_singleflight_in_flight", "Distinct coalescable queries being rendered.", "",
+                  [] { return (double)(nearestFlight.inFlightCount() + rangeFlight.inFlightCount()); });
+    metrics.counter("civmap_deadline_cancels_total", "Queries stopped early by their request deadline.", "",
+                    [] { return (double)admission.cancelled.load(); });
 }
 
 // ─────────────────────────────────────────────
@@ -327,33 +2186,32 @@ void sendError(httplib::Response& res, const string& msg, int code=400) {
 // ─────────────────────────────────────────────
 
 int main() {
+#ifndef _WIN32
+    watchSighup(); // before any other thread starts
+#endif
     cout << "\n╔══════════════════════════════════════════════════════════╗\n";
     cout << "║     CIVILIZATION SPATIAL INTELLIGENCE MAPPER              ║\n";
     cout << "║     C++ REST API Server  |  KD-Tree + R-Tree              ║\n";
     cout << "╚══════════════════════════════════════════════════════════╝\n\n";
 
-    // 1. Load data
-    allCivs = loadFromCSV("civilizations.csv");
-    if (allCivs.empty()) allCivs = getBuiltinData();
-    cout << "✅ Loaded " << allCivs.size() << " civilizations.\n";
-
-    // 2. Build KD-Tree
-    for (const auto& c : allCivs) kdTree.insert(c);
-    cout << "✅ KD-Tree built: " << kdTree.size() << " nodes.\n";
-
-    // 3. Build R-Tree regions
-    rTree.addRegion("South Asia",      5.0, 37.0,  60.0,  97.0);
-    rTree.addRegion("Mediterranean",  30.0, 45.0,  -5.0,  42.0);
-    rTree.addRegion("Middle East",    25.0, 40.0,  35.0,  60.0);
-    rTree.addRegion("East Asia",      20.0, 50.0,  95.0, 135.0);
-    rTree.addRegion("Mesoamerica",     5.0, 25.0,-110.0, -80.0);
-    rTree.addRegion("North Africa",   15.0, 35.0,  15.0,  50.0);
-    rTree.addRegion("Central Asia",   30.0, 55.0,  45.0, 120.0);
-    rTree.addRegion("South America", -25.0,  0.0, -80.0, -60.0);
-    cout << "✅ R-Tree built: " << rTree.size() << " regions.\n\n";
-
-    // 4. HTTP Server
+    // CIVMAP_LOG_LEVEL=debug|info|warn|error|off; CIVMAP_LOG_REQUESTS_PER_SEC
+    // caps the per-request lines (0 = log every request)
+    const char* logLevel = getenv("CIVMAP_LOG_LEVEL");
+    if (logLevel) Logger::setLevel(Logger::parseLevel(logLevel));
+    Logger::setRequestRate((uint32_t)envOr("CIVMAP_LOG_REQUESTS_PER_SEC", 100));
+
+    // 1-4. Load data, build the R-Tree, KD-Tree and name index
+    publishDataset(loadDataset());
+    writer.start((long)dataset()->size(), chrono::milliseconds((long)envOr("CIVMAP_WRITE_BATCH_MS", 5)));
+    reloader.start();
+
+    // 5. HTTP Server: bounded worker queue, per-request deadlines
     httplib::Server svr;
+    svr.new_task_queue = [] { return new AdmissionQueue(); };
+    svr.set_pre_routing_handler([](const httplib::Request&, httplib::Response& res) {
+        return admitRequest(res) ? httplib::Server::HandlerResponse::Unhandled
+                                 : httplib::Server::HandlerResponse::Handled;
+    });
 
     // ── OPTIONS (CORS preflight) ─────────────────
     svr.Options(".*", [](const httplib::Request&, httplib::Response& res) {
@@ -362,39 +2220,108 @@ int main() {
     });
 
     // ── GET /api/civilizations ───────────────────
-    svr.Get("/api/civilizations", [](const httplib::Request&, httplib::Response& res) {
-        sendJSON(res, vecsToJSON(allCivs));
-        cout << "[GET] /api/civilizations  → " << allCivs.size() << " records\n";
-    });
+    svr.Get("/api/civilizations", instrumented("/api/civilizations", [](const httplib::Request& req, httplib::Response& res) {
+        sendCached(req, res, wantsCivFrame(req) ? civilizationsFrameCache : civilizationsCache);
+        LOG_REQUEST("[GET] /api/civilizations  → " << dataset()->size() << " records");
+    }));
+
+    // ── POST /api/civilizations ──────────────────
+    svr.Post("/api/civilizations", instrumented("POST /api/civilizations", [](const httplib::Request& req, httplib::Response& res) {
+        Mutation mu{Mutation::Insert};
+        try {
+            mu.patch = parseCivPatch(req.body);
+        } catch (exception& e) {
+            sendError(res, e.what()); return;
+        }
+        if (!mu.patch.name || !mu.patch.latitude || !mu.patch.longitude) {
+            sendError(res, "Missing required fields: name, latitude, longitude"); return;
+        }
+        WriteResult r = writer.apply(move(mu));
+        if (r.status == 201) res.set_header("Location", "/api/civilizations/" + to_string(r.id));
+        sendWriteResult(res, r, true);
+        LOG_REQUEST("[POST] /api/civilizations  → " << r.status << " id " << r.id << " v" << r.version);
+    }));
+
+    // ── PUT /api/civilizations/:id ───────────────
+    svr.Put("/api/civilizations/:id", instrumented("PUT /api/civilizations/:id", [](const httplib::Request& req, httplib::Response& res) {
+        Mutation mu{Mutation::Update};
+        try {
+            mu.id = pathId(req);
+            mu.patch = parseCivPatch(req.body);
+        } catch (exception& e) {
+            sendError(res, e.what()); return;
+        }
+        WriteResult r = writer.apply(move(mu));
+        sendWriteResult(res, r, true);
+        LOG_REQUEST("[PUT] /api/civilizations/" << r.id << "  → " << r.status << " v" << r.version);
+    }));
+
+    // ── DELETE /api/civilizations/:id ────────────
+    svr.Delete("/api/civilizations/:id", instrumented("DELETE /api/civilizations/:id", [](const httplib::Request& req, httplib::Response& res) {
+        Mutation mu{Mutation::Delete};
+        try {
+            mu.id = pathId(req);
+        } catch (exception& e) {
+            sendError(res, e.what()); return;
+        }
+        WriteResult r = writer.apply(move(mu));
+        sendWriteResult(res, r, false);
+        LOG_REQUEST("[DELETE] /api/civilizations/" << r.id << "  → " << r.status << " v" << r.version);
+    }));
 
     // ── GET /api/nearest?lat=&lon= ───────────────
-    svr.Get("/api/nearest", [](const httplib::Request& req, httplib::Response& res) {
+    svr.Get("/api/nearest", instrumented("/api/nearest", [](const httplib::Request& req, httplib::Response& res) {
         if (!req.has_param("lat") || !req.has_param("lon")) {
             sendError(res, "Missing required params: lat, lon"); return;
         }
         try {
             double lat = stod(req.get_param_value("lat"));
             double lon = stod(req.get_param_value("lon"));
-            Civilization nearest = kdTree.nearestNeighbor(lat, lon);
-            double dist = kdTree.nearestDist(lat, lon) * 111.0; // approx km
-            ostringstream j;
-            j << fixed << setprecision(2);
-            j << "{"
-              << "\"query\":{\"lat\":" << lat << ",\"lon\":" << lon << "},"
-              << "\"nearest\":"        << nearest.toJSON() << ","
-              << "\"distance_km\":"    << dist << ","
-              << "\"algorithm\":\"KD-Tree O(log n) with branch pruning\""
-              << "}";
-            sendJSON(res, j.str());
-            cout << "[GET] /api/nearest?lat=" << lat << "&lon=" << lon
-                 << "  → " << nearest.name << "\n";
+            // Also rejects nan/inf, which would reach the cache's cell index cast
+            if (!(lat >= -90 && lat <= 90) || !(lon >= -180 && lon <= 180)) {
+                sendError(res, "lat must be in [-90, 90] and lon in [-180, 180]"); return;
+            }
+            bool explain = wantsExplain(req);
+            auto ds = dataset();
+            string found = "(coalesced)";
+            auto render = [&] {
+                double dist;
+                const char* cacheStatus;
+                CivRecord nearest;
+                QueryStats stats;
+                {
+                    Metrics::PhaseTimer t(Metrics::Phase::Index);
+                    if (explain) {
+                        nearest = ds->nearest(lat, lon, dist, stats); // the cache would hide the work
+                        cacheStatus = "bypass";
+                    } else {
+                        nearest = nearestCache.lookup(*ds, lat, lon, dist, cacheStatus);
+                    }
+                }
+                dist *= 111.0; // approx km
+                Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+                JsonWriter& w = threadJsonWriter();
+                w.raw("{\"query\":{\"lat\":").number(lat, 2).raw(",\"lon\":").number(lon, 2)
+                 .raw("},\"nearest\":");
+                nearest.writeJSON(w);
+                w.raw(",\"distance_km\":").number(dist, 2)
+                 .raw(",\"cache\":\"").raw(cacheStatus)
+                 .raw("\",\"algorithm\":\"").raw(ds->nearestAlgorithm()).raw('"');
+                if (explain) writeQueryStats(w.raw(",\"explain\":"), stats);
+                w.raw('}');
+                found = nearest.name;
+                return w.str();
+            };
+            if (explain) sendJSON(res, render()); // per-request counters, never shared
+            else sendCoalesced(res, nearestFlight, flightKey(*ds, lat, lon), "application/json", render);
+            LOG_REQUEST("[GET] /api/nearest?lat=" << lat << "&lon=" << lon << "  → " << found);
         } catch (exception& e) {
             sendError(res, e.what());
         }
-    });
+    }));
 
     // ── GET /api/range?latMin=&latMax=&lonMin=&lonMax= ──
-    svr.Get("/api/range", [](const httplib::Request& req, httplib::Response& res) {
+    svr.Get("/api/range", instrumented("/api/range", [](const httplib::Request& req, httplib::Response& res) {
         if (!req.has_param("latMin") || !req.has_param("latMax") ||
             !req.has_param("lonMin") || !req.has_param("lonMax")) {
             sendError(res, "Missing params: latMin, latMax, lonMin, lonMax"); return;
@@ -404,101 +2331,399 @@ int main() {
             double latMax = stod(req.get_param_value("latMax"));
             double lonMin = stod(req.get_param_value("lonMin"));
             double lonMax = stod(req.get_param_value("lonMax"));
-            auto results  = kdTree.rangeQuery(latMin, latMax, lonMin, lonMax);
-            ostringstream j;
-            j << "{"
-              << "\"query\":{\"latMin\":" << latMin << ",\"latMax\":" << latMax
-              << ",\"lonMin\":" << lonMin << ",\"lonMax\":" << lonMax << "},"
-              << "\"count\":" << results.size() << ","
-              << "\"results\":" << vecsToJSON(results) << ","
-              << "\"algorithm\":\"KD-Tree O(log n + k) spatial pruning\""
-              << "}";
-            sendJSON(res, j.str());
-            cout << "[GET] /api/range  → " << results.size() << " results\n";
+            size_t limit  = req.has_param("limit")  ? stoul(req.get_param_value("limit"))  : SIZE_MAX;
+            size_t offset = req.has_param("offset") ? stoul(req.get_param_value("offset")) : 0;
+
+            auto ds = dataset();
+            bool frame = wantsCivFrame(req);
+            res.set_header("Vary", "Accept");
+            if (req.has_param("orderBy")) {
+                if (req.get_param_value("orderBy") != "score") {
+                    sendError(res, "Unsupported orderBy (only 'score')"); return;
+                }
+                size_t k = req.has_param("limit") ? limit : DEFAULT_TOP_K;
+                sendCoalesced(res, rangeFlight, flightKey(*ds, 's', frame, latMin, latMax, lonMin, lonMax, offset, k),
+                              frame ? CIVFRAME_TYPE : "application/json", [&] {
+                    return renderRangeByScore(frame, *ds, latMin, latMax, lonMin, lonMax, offset, k);
+                });
+                return;
+            }
+            string key = flightKey(*ds, 'r', frame, latMin, latMax, lonMin, lonMax, offset, limit);
+            if (!frame) {
+                size_t total = ds->count(latMin, latMax, lonMin, lonMax);
+                size_t rows = total > offset ? min(limit, total - offset) : 0;
+                if (rows <= COALESCE_MAX_ROWS && !wantsExplain(req)) {
+                    sendCoalesced(res, rangeFlight, key, "application/json", [&] {
+                        return renderRangePage(ds, latMin, latMax, lonMin, lonMax, offset, limit);
+                    });
+                    return;
+                }
+                // Larger pages are streamed, so memory per request is one
+                // chunk rather than the whole result. The latency metric
+                // covers only the handler; the traversal runs as the body
+                // is written.
+                auto stream = make_shared<RangeStream>(ds, latMin, latMax, lonMin, lonMax, offset, limit,
+                                                       wantsExplain(req));
+                addCORS(res);
+                res.set_chunked_content_provider("application/json",
+                    [stream](size_t, httplib::DataSink& sink) { return stream->pump(sink); });
+                return;
+            }
+
+            // The civframe header carries the row count, so that format
+            // collects the page first; the buffer is reused per thread and
+            // points into `ds`, which stays alive until we return
+            sendCoalesced(res, rangeFlight, key, CIVFRAME_TYPE, [&] {
+                static thread_local vector<const CivRecord*> hits;
+                hits.clear();
+                size_t count;
+                bool complete;
+                {
+                    Metrics::PhaseTimer t(Metrics::Phase::Index);
+                    complete = rangePage(*ds, latMin, latMax, lonMin, lonMax, offset, limit, count,
+                        [](const CivRecord& c) { hits.push_back(&c); });
+                }
+
+                Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+                CivFrameBuilder b = civFrameBuilder();
+                b.reserve(count);
+                for (const CivRecord* c : hits) appendCivRow(b, *c);
+                LOG_REQUEST("[GET] /api/range  → " << count << " results (civframe)");
+                return b.finish((uint32_t)count, complete ? 0 : CivFrame::FLAG_TRUNCATED);
+            });
         } catch (exception& e) {
             sendError(res, e.what());
         }
-    });
+    }));
 
     // ── GET /api/compare?a=&b= ───────────────────
-    svr.Get("/api/compare", [](const httplib::Request& req, httplib::Response& res) {
+    svr.Get("/api/compare", instrumented("/api/compare", [](const httplib::Request& req, httplib::Response& res) {
         if (!req.has_param("a") || !req.has_param("b")) {
             sendError(res, "Missing params: a, b (civilization names)"); return;
         }
         string nameA = req.get_param_value("a");
         string nameB = req.get_param_value("b");
-        Civilization* civA = nullptr;
-        Civilization* civB = nullptr;
-        for (auto& c : allCivs) {
-            if (c.name == nameA) civA = &c;
-            if (c.name == nameB) civB = &c;
+        auto ds = dataset();
+        const CivRecord *civA, *civB;
+        {
+            Metrics::PhaseTimer t(Metrics::Phase::Index);
+            civA = ds->findName(nameA);
+            civB = ds->findName(nameB);
         }
         if (!civA) { sendError(res, "Civilization not found: " + nameA); return; }
         if (!civB) { sendError(res, "Civilization not found: " + nameB); return; }
         double dlat = civA->latitude  - civB->latitude;
         double dlon = civA->longitude - civB->longitude;
         double dist = sqrt(dlat*dlat + dlon*dlon) * 111.0;
-        string winner = civA->spatialScore() > civB->spatialScore() ? nameA : nameB;
-        ostringstream j;
-        j << fixed << setprecision(2);
-        j << "{"
-          << "\"civilization_a\":"  << civA->toJSON() << ","
-          << "\"civilization_b\":"  << civB->toJSON() << ","
-          << "\"distance_km\":"     << dist << ","
-          << "\"winner\":\""        << jsonEscape(winner) << "\","
-          << "\"score_a\":"         << civA->spatialScore() << ","
-          << "\"score_b\":"         << civB->spatialScore()
-          << "}";
-        sendJSON(res, j.str());
-        cout << "[GET] /api/compare  " << nameA << " vs " << nameB << "\n";
-    });
+        const string& winner = civA->spatialScore() > civB->spatialScore() ? civA->name : civB->name;
+        Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+        JsonWriter& w = threadJsonWriter();
+        w.raw("{\"civilization_a\":");
+        civA->writeJSON(w);
+        w.raw(",\"civilization_b\":");
+        civB->writeJSON(w);
+        w.raw(",\"distance_km\":").number(dist, 2)
+         .raw(",\"winner\":").string(winner)
+         .raw(",\"score_a\":").number(civA->spatialScore(), 2)
+         .raw(",\"score_b\":").number(civB->spatialScore(), 2)
+         .raw('}');
+        sendJSON(res, w);
+        t.stop();
+        LOG_REQUEST("[GET] /api/compare  " << nameA << " vs " << nameB);
+    }));
+
+    // ── GET /api/search?prefix=&limit= ───────────
+    svr.Get("/api/search", instrumented("/api/search", [](const httplib::Request& req, httplib::Response& res) {
+        if (!req.has_param("prefix")) {
+            sendError(res, "Missing param: prefix"); return;
+        }
+        try {
+            size_t limit = req.has_param("limit") ? stoul(req.get_param_value("limit")) : 10;
+            auto ds = dataset();
+            vector<const CivRecord*> found;
+            {
+                Metrics::PhaseTimer t(Metrics::Phase::Index);
+                found = ds->withPrefix(req.get_param_value("prefix"), limit);
+            }
+            Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+            JsonWriter& w = threadJsonWriter();
+            w.raw("{\"names\":[");
+            for (size_t i = 0; i < found.size(); i++) {
+                if (i) w.raw(',');
+                w.raw('"').raw(found[i]->nameJSON).raw('"');
+            }
+            w.raw("],\"count\":").number(found.size()).raw('}');
+            sendJSON(res, w);
+            t.stop();
+        } catch (exception& e) {
+            sendError(res, e.what());
+        }
+    }));
 
     // ── GET /api/rtree?lat=&lon= ─────────────────
-    svr.Get("/api/rtree", [](const httplib::Request& req, httplib::Response& res) {
+    svr.Get("/api/rtree", instrumented("/api/rtree", [](const httplib::Request& req, httplib::Response& res) {
         if (!req.has_param("lat") || !req.has_param("lon")) {
             sendError(res, "Missing params: lat, lon"); return;
         }
         try {
             double lat = stod(req.get_param_value("lat"));
             double lon = stod(req.get_param_value("lon"));
-            auto   regions = rTree.queryPoint(lat, lon);
-            string regJSON = "[";
+            vector<string> regions;
+            {
+                Metrics::PhaseTimer t(Metrics::Phase::Index);
+                regions = dataset()->rTree->queryPoint(lat, lon);
+            }
+            Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+            JsonWriter& w = threadJsonWriter();
+            w.raw("{\"query\":{\"lat\":").number(lat).raw(",\"lon\":").number(lon)
+             .raw("},\"regions\":[");
             for (size_t i = 0; i < regions.size(); i++) {
-                regJSON += "\"" + regions[i] + "\"";
-                if (i < regions.size()-1) regJSON += ",";
+                if (i) w.raw(',');
+                w.string(regions[i]);
             }
-            regJSON += "]";
-            ostringstream j;
-            j << "{"
-              << "\"query\":{\"lat\":" << lat << ",\"lon\":" << lon << "},"
-              << "\"regions\":"        << regJSON << ","
-              << "\"count\":"          << regions.size() << ","
-              << "\"algorithm\":\"R-Tree bounding box overlap O(log n)\""
-              << "}";
-            sendJSON(res, j.str());
-            cout << "[GET] /api/rtree?lat=" << lat << "&lon=" << lon
-                 << "  → " << regions.size() << " region(s)\n";
+            w.raw("],\"count\":").number(regions.size())
+             .raw(",\"algorithm\":\"R-Tree MBR filter + point-in-polygon refine\"}");
+            sendJSON(res, w);
+            t.stop();
+            LOG_REQUEST("[GET] /api/rtree?lat=" << lat << "&lon=" << lon << "  → " << regions.size() << " region(s)");
         } catch (exception& e) {
             sendError(res, e.what());
         }
-    });
+    }));
+
+    // ── GET /api/aggregate?latMin=&latMax=&lonMin=&lonMax=&fields= ──
+    svr.Get("/api/aggregate", instrumented("/api/aggregate", [](const httplib::Request& req, httplib::Response& res) {
+        if (!req.has_param("latMin") || !req.has_param("latMax") ||
+            !req.has_param("lonMin") || !req.has_param("lonMax")) {
+            sendError(res, "Missing params: latMin, latMax, lonMin, lonMax"); return;
+        }
+        try {
+            double latMin = stod(req.get_param_value("latMin"));
+            double latMax = stod(req.get_param_value("latMax"));
+            double lonMin = stod(req.get_param_value("lonMin"));
+            double lonMax = stod(req.get_param_value("lonMax"));
+
+            // fields=a,b selects attributes; default is all of them
+            vector<size_t> fields;
+            if (req.has_param("fields")) {
+                istringstream fieldList(req.get_param_value("fields"));
+                string f;
+                while (getline(fieldList, f, ',')) {
+                    auto it = find(begin(AGG_FIELDS), end(AGG_FIELDS), f);
+                    if (it == end(AGG_FIELDS)) { sendError(res, "Unknown field: " + f); return; }
+                    fields.push_back(it - begin(AGG_FIELDS));
+                }
+            } else {
+                for (size_t i = 0; i < AGG_FIELD_COUNT; i++) fields.push_back(i);
+            }
+
+            CivAggregate agg;
+            {
+                Metrics::PhaseTimer t(Metrics::Phase::Index);
+                agg = dataset()->rangeAggregate(latMin, latMax, lonMin, lonMax);
+            }
+            Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+            JsonWriter& w = threadJsonWriter();
+            w.raw("{\"query\":{\"latMin\":").number(latMin, 4).raw(",\"latMax\":").number(latMax, 4)
+             .raw(",\"lonMin\":").number(lonMin, 4).raw(",\"lonMax\":").number(lonMax, 4)
+             .raw("},\"count\":").number(agg.count)
+             .raw(",\"fields\":{");
+            for (size_t i = 0; i < fields.size(); i++) {
+                const FieldStats& fs = agg.fields[fields[i]];
+                if (i) w.raw(',');
+                w.key(AGG_FIELDS[fields[i]]);
+                if (agg.count == 0) w.raw("null");
+                else w.raw("{\"sum\":").number(fs.sum, 4).raw(",\"min\":").number(fs.min, 4)
+                      .raw(",\"max\":").number(fs.max, 4).raw(",\"avg\":").number(agg.mean(fields[i]), 4)
+                      .raw('}');
+            }
+            w.raw("},\"algorithm\":\"Aggregate KD-Tree O(log n) contained-subtree merge\"}");
+            sendJSON(res, w);
+            t.stop();
+            LOG_REQUEST("[GET] /api/aggregate  → " << agg.count << " civilizations");
+        } catch (exception& e) {
+            sendError(res, e.what());
+        }
+    }));
+
+    // ── POST /api/admin/reload ───────────────────
+    svr.Post("/api/admin/reload", instrumented("POST /api/admin/reload", [](const httplib::Request&, httplib::Response& res) {
+        const char* state = reloader.request();
+        JsonWriter& w = threadJsonWriter();
+        w.raw("{\"reload\":\"").raw(state)
+         .raw("\",\"serving_version\":").number((long long)dataset()->version).raw('}');
+        res.status = 202;
+        sendJSON(res, w);
+        LOG_INFO("[POST] /api/admin/reload  → " << state);
+    }));
 
     // ── GET /api/stats ───────────────────────────
-    svr.Get("/api/stats", [](const httplib::Request&, httplib::Response& res) {
-        int n    = (int)allCivs.size();
-        int logN = (int)(log2(n) + 1);
-        ostringstream j;
-        j << "{"
-          << "\"total_civilizations\":"  << n    << ","
-          << "\"kdtree_nodes\":"         << kdTree.size() << ","
-          << "\"rtree_regions\":"        << rTree.size()  << ","
-          << "\"linear_ops\":"           << n    << ","
-          << "\"kdtree_ops\":"           << logN << ","
-          << "\"speedup\":"              << n / logN
-          << "}";
-        sendJSON(res, j.str());
-        cout << "[GET] /api/stats\n";
-    });
+    svr.Get("/api/stats", instrumented("/api/stats", [](const httplib::Request& req, httplib::Response& res) {
+        sendCached(req, res, statsCache);
+        LOG_REQUEST("[GET] /api/stats");
+    }));
+
+    // ── GET /api/active?year= | from=&to= | of= ──
+    // Civilizations active in a year, overlapping a period, or contemporary
+    // with a named one; with a box, intersected with the spatial range by id
+    svr.Get("/api/active", instrumented("/api/active", [](const httplib::Request& req, httplib::Response& res) {
+        try {
+            auto ds = dataset();
+            int from, to;
+            long self = -1;
+            if (req.has_param("year")) {
+                from = to = stoi(req.get_param_value("year"));
+            } else if (req.has_param("from") && req.has_param("to")) {
+                from = stoi(req.get_param_value("from"));
+                to   = stoi(req.get_param_value("to"));
+            } else if (req.has_param("of")) {
+                const CivRecord* of = ds->findName(req.get_param_value("of"));
+                if (!of) { sendError(res, "Not found: " + req.get_param_value("of"), 404); return; }
+                from = of->startYear;
+                to   = of->endYear;
+                self = of->id;
+            } else {
+                sendError(res, "Missing params: year, from and to, or of"); return;
+            }
+            bool boxed = req.has_param("latMin") && req.has_param("latMax") &&
+                         req.has_param("lonMin") && req.has_param("lonMax");
+            size_t limit = req.has_param("limit") ? stoul(req.get_param_value("limit")) : SIZE_MAX;
+
+            vector<long> ids;
+            {
+                Metrics::PhaseTimer t(Metrics::Phase::Index);
+                bool complete = ds->overlapping(from, to, [&](const CivRecord& c) {
+                    if (requestDeadline.cancelled()) return Visit::Stop;
+                    if (c.id != self) ids.push_back(c.id);
+                    return Visit::Continue;
+                });
+                sort(ids.begin(), ids.end());
+                if (complete && boxed) {
+                    vector<long> inBox;
+                    complete = ds->range(stod(req.get_param_value("latMin")), stod(req.get_param_value("latMax")),
+                                         stod(req.get_param_value("lonMin")), stod(req.get_param_value("lonMax")),
+                                         [&](const CivRecord& c) {
+                                             if (requestDeadline.cancelled()) return Visit::Stop;
+                                             inBox.push_back(c.id);
+                                             return Visit::Continue;
+                                         });
+                    sort(inBox.begin(), inBox.end());
+                    vector<long> both;
+                    set_intersection(ids.begin(), ids.end(), inBox.begin(), inBox.end(), back_inserter(both));
+                    ids.swap(both);
+                }
+                if (!complete) {
+                    admission.cancelled++;
+                    sendOverloaded(res, "Deadline exceeded, retry later");
+                    return;
+                }
+            }
+
+            Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+            size_t count = min(limit, ids.size());
+            JsonWriter& w = threadJsonWriter();
+            w.raw("{\"query\":{\"from\":").number(from).raw(",\"to\":").number(to)
+             .raw(",\"spatial\":").boolean(boxed).raw("},\"results\":[");
+            for (size_t i = 0; i < count; i++) {
+                if (i) w.raw(',');
+                ds->byId(ids[i])->writeJSON(w);
+            }
+            w.raw("],\"count\":").number(count)
+             .raw(",\"total\":").number(ids.size())
+             .raw(",\"algorithm\":\"Centered interval tree O(log n + k)\"}");
+            sendJSON(res, w);
+            t.stop();
+            LOG_REQUEST("[GET] /api/active " << from << ".." << to << "  → " << ids.size() << " results");
+        } catch (exception& e) {
+            sendError(res, e.what());
+        }
+    }));
+
+    // ── GET /api/voronoi/:id ─────────────────────
+    // Voronoi neighbours and cell polygon of one civilization
+    svr.Get("/api/voronoi/:id", instrumented("/api/voronoi/:id", [](const httplib::Request& req, httplib::Response& res) {
+        try {
+            auto ds = dataset();
+            long id = pathId(req);
+            const CivRecord* c = ds->byId(id);
+            if (!c) { sendError(res, "Not found: " + to_string(id), 404); return; }
+
+            const VoronoiIndex* voronoi;
+            vector<uint32_t> neighbors;
+            vector<pair<double, double>> cell;
+            bool bounded;
+            {
+                Metrics::PhaseTimer t(Metrics::Phase::Index);
+                voronoi = &ds->voronoi();
+                uint32_t pos = (uint32_t)voronoi->position(id);
+                neighbors = voronoi->triangulation.neighbors(pos);
+                bounded = voronoi->triangulation.cell(pos, cell);
+            }
+            Metrics::PhaseTimer t(Metrics::Phase::Serialize);
+            JsonWriter& w = threadJsonWriter();
+            w.raw("{\"id\":").number((long long)id).raw(",\"name\":\"").raw(c->nameJSON)
+             .raw("\",\"neighbors\":[");
+            for (size_t i = 0; i < neighbors.size(); i++) {
+                if (i) w.raw(',');
+                w.number((long long)voronoi->records[neighbors[i]]->id);
+            }
+            w.raw("],\"bounded\":").boolean(bounded).raw(",\"cell\":[");
+            for (size_t i = 0; i < cell.size(); i++) {
+                if (i) w.raw(',');
+                w.raw('[').number(cell[i].first, 4).raw(',').number(cell[i].second, 4).raw(']');
+            }
+            w.raw("]}");
+            sendJSON(res, w);
+            t.stop();
+            LOG_REQUEST("[GET] /api/voronoi/" << id << "  → " << neighbors.size() << " neighbours");
+        } catch (exception& e) {
+            sendError(res, e.what());
+        }
+    }));
+
+    // ── GET /api/tiles/:z/:x/:y ──────────────────
+    svr.Get("/api/tiles/:z/:x/:y", instrumented("/api/tiles", [](const httplib::Request& req, httplib::Response& res) {
+        long z, x, y;
+        try {
+            z = pathNumber(req, "z");
+            x = pathNumber(req, "x");
+            y = pathNumber(req, "y");
+        } catch (exception& e) {
+            sendError(res, e.what()); return;
+        }
+        if (z < 0 || x < 0 || y < 0 || !ClusterPyramid::validTile((int)z, (uint32_t)x, (uint32_t)y)) {
+            sendError(res, "Tile out of range (z 0-" + to_string(ClusterPyramid::MAX_ZOOM) + ", x/y below 2^z)");
+            return;
+        }
+        shared_ptr<const CachedBody> body;
+        {
+            Metrics::PhaseTimer t(Metrics::Phase::Index);
+            body = tileCache.get(*dataset(), (int)z, (uint32_t)x, (uint32_t)y);
+        }
+        sendCachedBody(req, res, *body, "application/json");
+        LOG_REQUEST("[GET] /api/tiles/" << z << '/' << x << '/' << y << "  → " << res.status);
+    }));
+
+    // ── GET /api/cache ───────────────────────────
+    svr.Get("/api/cache", instrumented("/api/cache", [](const httplib::Request&, httplib::Response& res) {
+        JsonWriter& w = threadJsonWriter();
+        w.raw("{\"nearest\":{\"cell_deg\":").number(nearestCache.cellSize())
+         .raw(",\"entries\":").number(nearestCache.entries())
+         .raw(",\"hits\":").number((size_t)nearestCache.hits.load())
+         .raw(",\"misses\":").number((size_t)nearestCache.misses.load())
+         .raw(",\"uncacheable\":").number((size_t)nearestCache.uncacheable.load())
+         .raw("},\"tiles\":{\"entries\":").number(tileCache.entries())
+         .raw(",\"hits\":").number((size_t)tileCache.hits.load())
+         .raw(",\"misses\":").number((size_t)tileCache.misses.load())
+         .raw("}}");
+        sendJSON(res, w);
+    }));
+
+    // ── GET /api/metrics ─────────────────────────
+    registerIndexGauges();
+    svr.Get("/api/metrics", instrumented("/api/metrics", [](const httplib::Request&, httplib::Response& res) {
+        res.set_content(metrics.renderPrometheus(), "text/plain; version=0.0.4");
+    }));
 
     // ── Health check ─────────────────────────────
     svr.Get("/", [](const httplib::Request&, httplib::Response& res) {
@@ -507,21 +2732,35 @@ int main() {
             "{\"status\":\"running\","
             "\"project\":\"Civilization Spatial Intelligence Mapper\","
             "\"endpoints\":[\"/api/civilizations\",\"/api/nearest\","
-            "\"/api/range\",\"/api/compare\",\"/api/rtree\",\"/api/stats\"]}",
+            "\"/api/range\",\"/api/compare\",\"/api/search\",\"/api/rtree\",\"/api/aggregate\",\"/api/active\",\"/api/voronoi\",\"/api/tiles\","
+            "\"/api/stats\",\"/api/cache\",\"/api/metrics\"]}",
             "application/json");
     });
 
     int PORT = 8080;
+    Logger::flush(); // keep the loading lines above the banner
     cout << "🚀 REST API Server running at http://localhost:" << PORT << "\n";
     cout << "   Open civilization_mapper_frontend.html in your browser\n\n";
     cout << "   Endpoints:\n";
-    cout << "     GET /api/civilizations\n";
+    cout << "     GET /api/civilizations   (POST to add, PUT/DELETE /api/civilizations/:id)\n";
     cout << "     GET /api/nearest?lat=28&lon=77\n";
     cout << "     GET /api/range?latMin=10&latMax=35&lonMin=60&lonMax=90\n";
     cout << "     GET /api/compare?a=Mughal+Empire&b=Chola+Dynasty\n";
+    cout << "     GET /api/search?prefix=ma\n";
     cout << "     GET /api/rtree?lat=20&lon=78\n";
-    cout << "     GET /api/stats\n\n";
-    cout << "Press Ctrl+C to stop.\n\n";
+    cout << "     GET /api/aggregate?latMin=5&latMax=37&lonMin=60&lonMax=97&fields=military_strength\n";
+    cout << "     GET /api/active?year=500\n";
+    cout << "     GET /api/voronoi/0\n";
+    cout << "     GET /api/tiles/4/11/6\n";
+    cout << "     GET /api/stats\n";
+    cout << "     GET /api/cache\n";
+    cout << "     GET /api/metrics\n";
+#ifndef _WIN32
+    cout << "     POST /api/admin/reload   (or kill -HUP " << getpid() << ")\n\n";
+#else
+    cout << "     POST /api/admin/reload\n\n";
+#endif
+    cout << "Press Ctrl+C to stop.\n\n" << flush;
 
     svr.listen("0.0.0.0", PORT);
     return 0;
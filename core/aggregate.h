@@ -0,0 +1,54 @@
+#ifndef AGGREGATE_H
+#define AGGREGATE_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <limits>
+
+// Default per-node summary for the trees: keeps nothing.
+struct NoSummary {
+    template <typename Entry> void add(const Entry&) {}
+    void merge(const NoSummary&) {}
+};
+
+// Running sum/min/max of one numeric attribute.
+struct FieldStats {
+    double sum = 0.0;
+    double min = std::numeric_limits<double>::max();
+    double max = std::numeric_limits<double>::lowest();
+
+    void add(double v) {
+        sum += v;
+        min = std::min(min, v);
+        max = std::max(max, v);
+    }
+
+    void merge(const FieldStats& other) {
+        sum += other.sum;
+        min = std::min(min, other.min);
+        max = std::max(max, other.max);
+    }
+};
+
+// Count plus per-attribute stats for N attributes. Stored per tree node so a
+// range aggregate can consume a fully contained subtree in O(1).
+template <size_t N>
+struct Aggregate {
+    size_t count = 0;
+    std::array<FieldStats, N> fields;
+
+    void add(const std::array<double, N>& values) {
+        count++;
+        for (size_t i = 0; i < N; i++) fields[i].add(values[i]);
+    }
+
+    void merge(const Aggregate& other) {
+        count += other.count;
+        for (size_t i = 0; i < N; i++) fields[i].merge(other.fields[i]);
+    }
+
+    double mean(size_t field) const { return count ? fields[field].sum / count : 0.0; }
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef CIVILIZATION_H
+#define CIVILIZATION_H
+
+#include <string>
+
+// One civilization record, shared by the CLI, the analytics and the REST
+// server. Loaders fill what their CSV provides; the rest stays zero/empty.
+struct Civilization {
+    long id = -1;
+    std::string name;
+    double latitude = 0.0;
+    double longitude = 0.0;
+    int startYear = 0;
+    int endYear = 0;
+    std::string region;
+    double resourceDensity = 0.0;
+    double knowledgeDensity = 0.0;
+    double militaryStrength = 0.0;
+
+    double spatialScore() const {
+        return (resourceDensity + knowledgeDensity + militaryStrength) / 3.0;
+    }
+};
+
+#endif
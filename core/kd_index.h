@@ -0,0 +1,418 @@
+#ifndef KD_INDEX_H
+#define KD_INDEX_H
+
+#include "aggregate.h"
+#include "query_stats.h"
+#include "spatial_index.h"
+#include "visit.h"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <utility>
+#include <vector>
+
+// 2-d tree over any record with `latitude` and `longitude` members; meets
+// the SpatialIndex requirements (spatial_index.h). Splits alternate
+// latitude/longitude by depth.
+//
+// Every node keeps its subtree's bounding box, size and Summary (same
+// requirements as BasicRTree's), so count() and rangeAggregate() take fully
+// contained subtrees whole, and radius()/kNearest() prune on the box.
+template <typename T, typename Summary = NoSummary>
+class KDIndex {
+public:
+    using value_type = T;
+
+private:
+    struct Node {
+        T item;
+        Node* left = nullptr;
+        Node* right = nullptr;
+        double latMin, latMax, lonMin, lonMax;
+        size_t count = 1;
+        Summary summary;
+
+        explicit Node(T v) : item(std::move(v)),
+            latMin(item.latitude), latMax(item.latitude), lonMin(item.longitude), lonMax(item.longitude) {
+            summary.add(item);
+        }
+
+        void absorb(const T& v) {
+            latMin = std::min(latMin, v.latitude);  latMax = std::max(latMax, v.latitude);
+            lonMin = std::min(lonMin, v.longitude); lonMax = std::max(lonMax, v.longitude);
+            count++;
+            summary.add(v);
+        }
+
+        void absorb(const Node& child) {
+            latMin = std::min(latMin, child.latMin); latMax = std::max(latMax, child.latMax);
+            lonMin = std::min(lonMin, child.lonMin); lonMax = std::max(lonMax, child.lonMax);
+            count += child.count;
+            summary.merge(child.summary);
+        }
+
+        bool disjoint(double qLatMin, double qLatMax, double qLonMin, double qLonMax) const {
+            return latMin > qLatMax || latMax < qLatMin || lonMin > qLonMax || lonMax < qLonMin;
+        }
+
+        bool inside(double qLatMin, double qLatMax, double qLonMin, double qLonMax) const {
+            return latMin >= qLatMin && latMax <= qLatMax && lonMin >= qLonMin && lonMax <= qLonMax;
+        }
+
+        // Distance from (lat, lon) to the subtree's bounding box
+        double boxDistance(double lat, double lon) const {
+            double dl = std::max({0.0, latMin - lat, lat - latMax});
+            double dn = std::max({0.0, lonMin - lon, lon - lonMax});
+            return std::sqrt(dl * dl + dn * dn);
+        }
+    };
+
+    Node* root = nullptr;
+    size_t nodeCount = 0;
+
+    static double dist(const T& item, double lat, double lon) {
+        double dl = item.latitude - lat;
+        double dn = item.longitude - lon;
+        return std::sqrt(dl * dl + dn * dn);
+    }
+
+    static bool inBox(const T& item, double latMin, double latMax, double lonMin, double lonMax) {
+        return item.latitude >= latMin && item.latitude <= latMax &&
+               item.longitude >= lonMin && item.longitude <= lonMax;
+    }
+
+    Node* insert(Node* node, T item, int depth) {
+        if (!node) { nodeCount++; return new Node(std::move(item)); }
+        node->absorb(item);
+        bool goLeft = depth % 2 == 0 ? item.latitude < node->item.latitude
+                                     : item.longitude < node->item.longitude;
+        if (goLeft) node->left  = insert(node->left,  std::move(item), depth + 1);
+        else        node->right = insert(node->right, std::move(item), depth + 1);
+        return node;
+    }
+
+    // Balanced build: the median on the split axis becomes the node
+    Node* build(std::vector<T>& items, size_t lo, size_t hi, int depth) {
+        if (lo >= hi) return nullptr;
+        size_t mid = lo + (hi - lo) / 2;
+        int axis = depth % 2;
+        std::nth_element(items.begin() + lo, items.begin() + mid, items.begin() + hi,
+                         [axis](const T& a, const T& b) {
+                             return axis == 0 ? a.latitude < b.latitude : a.longitude < b.longitude;
+                         });
+        Node* node = new Node(std::move(items[mid]));
+        nodeCount++;
+        node->left  = build(items, lo, mid, depth + 1);
+        node->right = build(items, mid + 1, hi, depth + 1);
+        if (node->left)  node->absorb(*node->left);
+        if (node->right) node->absorb(*node->right);
+        return node;
+    }
+
+    static void visited(const Node* node, QueryStats& stats) {
+        stats.node();
+        if (!node->left && !node->right) stats.leaf();
+    }
+    static void visited(const Node*, NoStats&) {}
+
+    template <typename Stats, typename Keep>
+    void nearestSearch(const Node* node, double lat, double lon,
+                       const Node*& best, double& bestDist, int depth, Stats& stats, Keep& keep) const {
+        if (!node) return;
+        visited(node, stats);
+        stats.distance();
+        double d = dist(node->item, lat, lon);
+        if (d < bestDist && keep(node->item)) { bestDist = d; best = node; }
+        double nv = depth % 2 == 0 ? node->item.latitude : node->item.longitude;
+        double qv = depth % 2 == 0 ? lat : lon;
+        const Node* first  = qv < nv ? node->left  : node->right;
+        const Node* second = qv < nv ? node->right : node->left;
+        nearestSearch(first, lat, lon, best, bestDist, depth + 1, stats, keep);
+        if (std::abs(qv - nv) < bestDist)
+            nearestSearch(second, lat, lon, best, bestDist, depth + 1, stats, keep);
+        else if (second)
+            stats.prune();
+    }
+
+    using HeapEntry = std::pair<double, const T*>; // max-heap on distance
+
+    template <typename Stats>
+    void kNearestSearch(const Node* node, double lat, double lon, size_t k,
+                        std::priority_queue<HeapEntry>& heap, int depth, Stats& stats) const {
+        if (!node) return;
+        if (heap.size() == k && node->boxDistance(lat, lon) >= heap.top().first) { stats.prune(); return; }
+        visited(node, stats);
+        stats.distance();
+        double d = dist(node->item, lat, lon);
+        if (heap.size() < k) { heap.push({d, &node->item}); stats.push(); }
+        else if (d < heap.top().first) { heap.pop(); heap.push({d, &node->item}); stats.push(); }
+        bool leftFirst = depth % 2 == 0 ? lat < node->item.latitude : lon < node->item.longitude;
+        kNearestSearch(leftFirst ? node->left : node->right, lat, lon, k, heap, depth + 1, stats);
+        kNearestSearch(leftFirst ? node->right : node->left, lat, lon, k, heap, depth + 1, stats);
+    }
+
+    template <typename F, typename Stats>
+    bool rangeVisit(const Node* node, double latMin, double latMax,
+                    double lonMin, double lonMax, F& onHit, int depth, Stats& stats) const {
+        if (!node) return true;
+        visited(node, stats);
+        if (inBox(node->item, latMin, latMax, lonMin, lonMax))
+            if (invokeVisitor(onHit, node->item) == Visit::Stop) return false;
+        double nv   = depth % 2 == 0 ? node->item.latitude : node->item.longitude;
+        double minV = depth % 2 == 0 ? latMin : lonMin;
+        double maxV = depth % 2 == 0 ? latMax : lonMax;
+        if (minV <= nv) {
+            if (!rangeVisit(node->left, latMin, latMax, lonMin, lonMax, onHit, depth + 1, stats)) return false;
+        } else if (node->left) {
+            stats.prune();
+        }
+        if (maxV >= nv) {
+            if (!rangeVisit(node->right, latMin, latMax, lonMin, lonMax, onHit, depth + 1, stats)) return false;
+        } else if (node->right) {
+            stats.prune();
+        }
+        return true;
+    }
+
+    template <typename F>
+    bool radiusVisit(const Node* node, double lat, double lon, double r, F& onHit) const {
+        if (!node || node->boxDistance(lat, lon) > r) return true;
+        if (dist(node->item, lat, lon) <= r && invokeVisitor(onHit, node->item) == Visit::Stop) return false;
+        return radiusVisit(node->left, lat, lon, r, onHit) && radiusVisit(node->right, lat, lon, r, onHit);
+    }
+
+    size_t countIn(const Node* node, double latMin, double latMax, double lonMin, double lonMax) const {
+        if (!node || node->disjoint(latMin, latMax, lonMin, lonMax)) return 0;
+        if (node->inside(latMin, latMax, lonMin, lonMax)) return node->count;
+        return (inBox(node->item, latMin, latMax, lonMin, lonMax) ? 1 : 0) +
+               countIn(node->left,  latMin, latMax, lonMin, lonMax) +
+               countIn(node->right, latMin, latMax, lonMin, lonMax);
+    }
+
+    void aggregate(const Node* node, double latMin, double latMax,
+                   double lonMin, double lonMax, Summary& out) const {
+        if (!node || node->disjoint(latMin, latMax, lonMin, lonMax)) return;
+        if (node->inside(latMin, latMax, lonMin, lonMax)) {
+            out.merge(node->summary); // Whole subtree inside the box
+            return;
+        }
+        if (inBox(node->item, latMin, latMax, lonMin, lonMax)) out.add(node->item);
+        aggregate(node->left,  latMin, latMax, lonMin, lonMax, out);
+        aggregate(node->right, latMin, latMax, lonMin, lonMax, out);
+    }
+
+    // As above, but subtrees whose box holds one of `holes` are split down
+    // to the items so keep() can drop them
+    template <typename Keep>
+    void aggregate(const Node* node, double latMin, double latMax, double lonMin, double lonMax,
+                   const std::vector<std::pair<double, double>>& holes, Keep& keep, Summary& out) const {
+        if (!node || node->disjoint(latMin, latMax, lonMin, lonMax)) return;
+        std::vector<std::pair<double, double>> inside;
+        for (const auto& h : holes)
+            if (!node->disjoint(h.first, h.first, h.second, h.second)) inside.push_back(h);
+        if (inside.empty()) { aggregate(node, latMin, latMax, lonMin, lonMax, out); return; }
+        if (inBox(node->item, latMin, latMax, lonMin, lonMax) && keep(node->item)) out.add(node->item);
+        aggregate(node->left,  latMin, latMax, lonMin, lonMax, inside, keep, out);
+        aggregate(node->right, latMin, latMax, lonMin, lonMax, inside, keep, out);
+    }
+
+    static void deleteTree(Node* node) {
+        if (!node) return;
+        deleteTree(node->left);
+        deleteTree(node->right);
+        delete node;
+    }
+
+public:
+    KDIndex() = default;
+    KDIndex(const KDIndex&) = delete;
+    KDIndex& operator=(const KDIndex&) = delete;
+    ~KDIndex() { deleteTree(root); }
+
+    // Replaces the contents with a balanced tree over `items`
+    void build(std::vector<T> items) {
+        deleteTree(root);
+        nodeCount = 0;
+        root = build(items, 0, items.size(), 0);
+    }
+
+    // Unbalanced insert; prefer build() for bulk loads
+    void insert(T item) { root = insert(root, std::move(item), 0); }
+
+    // The trailing `stats` overloads also count the work done (query_stats.h)
+    template <typename Stats>
+    const T* nearest(double lat, double lon, double& bestDist, Stats& stats) const {
+        return nearest(lat, lon, bestDist, stats, KeepAll());
+    }
+
+    // Nearest item for which keep(item) is true. Rejected items still bound
+    // the search, so keep() should reject few of them.
+    template <typename Stats, typename Keep>
+    const T* nearest(double lat, double lon, double& bestDist, Stats& stats, Keep&& keep) const {
+        const Node* best = nullptr;
+        bestDist = std::numeric_limits<double>::max();
+        nearestSearch(root, lat, lon, best, bestDist, 0, stats, keep);
+        return best ? &best->item : nullptr;
+    }
+
+    const T* nearest(double lat, double lon, double& bestDist) const {
+        NoStats none;
+        return nearest(lat, lon, bestDist, none);
+    }
+
+    template <typename Stats>
+    std::vector<Neighbor<T>> kNearest(double lat, double lon, size_t k, Stats& stats) const {
+        std::priority_queue<HeapEntry> heap;
+        if (k > 0) kNearestSearch(root, lat, lon, k, heap, 0, stats);
+        std::vector<Neighbor<T>> out(heap.size());
+        for (size_t i = out.size(); i-- > 0; heap.pop()) out[i] = {heap.top().second, heap.top().first};
+        return out;
+    }
+
+    std::vector<Neighbor<T>> kNearest(double lat, double lon, size_t k) const {
+        NoStats none;
+        return kNearest(lat, lon, k, none);
+    }
+
+    template <typename F, typename Stats>
+    bool range(double latMin, double latMax, double lonMin, double lonMax, F&& onHit, Stats& stats) const {
+        return rangeVisit(root, latMin, latMax, lonMin, lonMax, onHit, 0, stats);
+    }
+
+    template <typename F>
+    bool range(double latMin, double latMax, double lonMin, double lonMax, F&& onHit) const {
+        NoStats none;
+        return rangeVisit(root, latMin, latMax, lonMin, lonMax, onHit, 0, none);
+    }
+
+    template <typename F>
+    bool radius(double lat, double lon, double r, F&& onHit) const {
+        return radiusVisit(root, lat, lon, r, onHit);
+    }
+
+    size_t count(double latMin, double latMax, double lonMin, double lonMax) const {
+        return countIn(root, latMin, latMax, lonMin, lonMax);
+    }
+
+    // Summary of every item in the box
+    Summary rangeAggregate(double latMin, double latMax, double lonMin, double lonMax) const {
+        Summary out;
+        aggregate(root, latMin, latMax, lonMin, lonMax, out);
+        return out;
+    }
+
+    // Summary of the items in the box for which keep(item) is true. `holes`
+    // must include the position of every rejected item in the box: only
+    // subtrees holding none of them are taken whole.
+    template <typename Keep>
+    Summary rangeAggregate(double latMin, double latMax, double lonMin, double lonMax,
+                           const std::vector<std::pair<double, double>>& holes, Keep&& keep) const {
+        Summary out;
+        aggregate(root, latMin, latMax, lonMin, lonMax, holes, keep, out);
+        return out;
+    }
+
+    // The k items in the box with the highest score(item), best first.
+    // bound(summary) must be at least score() of every item in that subtree
+    // (e.g. a per-node max). Subtrees are expanded best bound first and the
+    // search stops once no pending bound beats the k-th score, so cost
+    // tracks k rather than the number of hits.
+    template <typename S, typename B>
+    std::vector<Ranked<T>> topKInRange(double latMin, double latMax, double lonMin, double lonMax,
+                                       size_t k, S&& score, B&& bound) const {
+        return topKInRange(latMin, latMax, lonMin, lonMax, k, score, bound, KeepAll());
+    }
+
+    // Same, among the items for which keep(item) is true
+    template <typename S, typename B, typename Keep>
+    std::vector<Ranked<T>> topKInRange(double latMin, double latMax, double lonMin, double lonMax,
+                                       size_t k, S&& score, B&& bound, Keep&& keep) const {
+        using Hit = std::pair<double, const T*>;      // min-heap: k-th score on top
+        using Pending = std::pair<double, const Node*>; // max-heap on bound
+        std::priority_queue<Hit, std::vector<Hit>, std::greater<Hit>> best;
+        std::priority_queue<Pending> pending;
+        auto push = [&](const Node* node) {
+            if (node && !node->disjoint(latMin, latMax, lonMin, lonMax))
+                pending.push({bound(node->summary), node});
+        };
+        if (k > 0) push(root);
+
+        while (!pending.empty()) {
+            auto [b, node] = pending.top();
+            if (best.size() == k && b <= best.top().first) break;
+            pending.pop();
+            if (inBox(node->item, latMin, latMax, lonMin, lonMax) && keep(node->item)) {
+                double s = score(node->item);
+                if (best.size() < k) best.push({s, &node->item});
+                else if (s > best.top().first) { best.pop(); best.push({s, &node->item}); }
+            }
+            push(node->left);
+            push(node->right);
+        }
+
+        std::vector<Ranked<T>> out(best.size());
+        for (size_t i = out.size(); i-- > 0; best.pop()) out[i] = {best.top().second, best.top().first};
+        return out;
+    }
+
+    size_t size() const { return nodeCount; }
+
+    // Resumable range query: each next() call passes up to `max` further
+    // hits to emit(item), in the same order as range(), and keeps only the
+    // pending subtrees (O(depth)) between calls. Used to stream large result
+    // sets a chunk at a time. The index must outlive the cursor and must not
+    // change while it is in use.
+    class RangeCursor {
+    public:
+        RangeCursor(const KDIndex& index, double latMin, double latMax, double lonMin, double lonMax)
+            : latMin(latMin), latMax(latMax), lonMin(lonMin), lonMax(lonMax) {
+            if (index.root) pending.push_back({index.root, 0});
+        }
+
+        bool done() const { return pending.empty(); }
+
+        // Returns how many hits were passed to emit
+        template <typename F, typename Stats>
+        size_t next(size_t max, F&& emit, Stats& stats) {
+            size_t n = 0;
+            while (n < max && !pending.empty()) {
+                auto [node, depth] = pending.back();
+                pending.pop_back();
+                visited(node, stats);
+                double nv   = depth % 2 == 0 ? node->item.latitude : node->item.longitude;
+                double minV = depth % 2 == 0 ? latMin : lonMin;
+                double maxV = depth % 2 == 0 ? latMax : lonMax;
+                // Right first so the left subtree is visited next, as in rangeVisit()
+                if (node->right) {
+                    if (maxV >= nv) pending.push_back({node->right, depth + 1});
+                    else stats.prune();
+                }
+                if (node->left) {
+                    if (minV <= nv) pending.push_back({node->left, depth + 1});
+                    else stats.prune();
+                }
+                if (inBox(node->item, latMin, latMax, lonMin, lonMax)) { emit(node->item); n++; }
+            }
+            return n;
+        }
+
+        template <typename F>
+        size_t next(size_t max, F&& emit) {
+            NoStats none;
+            return next(max, emit, none);
+        }
+
+    private:
+        double latMin, latMax, lonMin, lonMax;
+        std::vector<std::pair<const Node*, int>> pending;
+    };
+
+    RangeCursor rangeCursor(double latMin, double latMax, double lonMin, double lonMax) const {
+        return RangeCursor(*this, latMin, latMax, lonMin, lonMax);
+    }
+};
+
+#endif
@@ -43,36 +43,39 @@ void rangeSearch(
     int depth,
     std::vector<Civilization>& result
 ) {
-    if (!root) return;
-
-    if (root->civ.latitude >= latMin &&
-        root->civ.latitude <= latMax &&
-        root->civ.longitude >= lonMin &&
-        root->civ.longitude <= lonMax) {
-        result.push_back(root->civ);
-    }
-
-    int cd = depth % 2;
-
-    if ((cd == 0 && latMin < root->civ.latitude) ||
-        (cd == 1 && lonMin < root->civ.longitude))
-        rangeSearch(root->left, latMin, latMax, lonMin, lonMax, depth + 1, result);
+    rangeVisit(root, latMin, latMax, lonMin, lonMax, depth,
+               [&result](const Civilization& c) { result.push_back(c); });
+}
 
-    if ((cd == 0 && latMax >= root->civ.latitude) ||
-        (cd == 1 && lonMax >= root->civ.longitude))
-        rangeSearch(root->right, latMin, latMax, lonMin, lonMax, depth + 1, result);
+void rangeSearch(
+    KDNode* root,
+    double latMin,
+    double latMax,
+    double lonMin,
+    double lonMax,
+    int depth,
+    std::vector<Civilization>& result,
+    QueryStats& stats
+) {
+    rangeVisit(root, latMin, latMax, lonMin, lonMax, depth,
+               [&result](const Civilization& c) { result.push_back(c); }, stats);
 }
 
-void nearestNeighbor(
+template <typename Stats>
+static void nearestSearch(
     KDNode* root,
     double lat,
     double lon,
     Civilization& best,
     double& bestDist,
-    int depth
+    int depth,
+    Stats& stats
 ) {
     if (!root) return;
 
+    stats.node();
+    if (!root->left && !root->right) stats.leaf();
+    stats.distance();
     double d = distance(lat, lon, root->civ.latitude, root->civ.longitude);
     if (d < bestDist) {
         bestDist = d;
@@ -92,14 +95,40 @@ void nearestNeighbor(
         farBranch = root->left;
     }
 
-    nearestNeighbor(nearBranch, lat, lon, best, bestDist, depth + 1);
+    nearestSearch(nearBranch, lat, lon, best, bestDist, depth + 1, stats);
 
     double diff = (cd == 0)
                     ? abs(lat - root->civ.latitude)
                     : abs(lon - root->civ.longitude);
 
     if (diff < bestDist)
-        nearestNeighbor(farBranch, lat, lon, best, bestDist, depth + 1);
+        nearestSearch(farBranch, lat, lon, best, bestDist, depth + 1, stats);
+    else if (farBranch)
+        stats.prune();
+}
+
+void nearestNeighbor(
+    KDNode* root,
+    double lat,
+    double lon,
+    Civilization& best,
+    double& bestDist,
+    int depth
+) {
+    NoStats none;
+    nearestSearch(root, lat, lon, best, bestDist, depth, none);
+}
+
+void nearestNeighbor(
+    KDNode* root,
+    double lat,
+    double lon,
+    Civilization& best,
+    double& bestDist,
+    int depth,
+    QueryStats& stats
+) {
+    nearestSearch(root, lat, lon, best, bestDist, depth, stats);
 }
 
 void deleteKDTree(KDNode* root) {
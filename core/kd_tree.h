@@ -4,14 +4,9 @@
 #include <string>
 #include <vector>
 #include <cmath>
-
-struct Civilization {
-    int id;
-    std::string name;
-    double latitude;
-    double longitude;
-    int startYear;
-};
+#include "civilization.h"
+#include "query_stats.h"
+#include "visit.h"
 
 struct KDNode {
     Civilization civ;
@@ -36,6 +31,76 @@ void rangeSearch(
     std::vector<Civilization>& result
 );
 
+// Same, also counting the work done into `stats`
+void rangeSearch(
+    KDNode* root,
+    double latMin,
+    double latMax,
+    double lonMin,
+    double lonMax,
+    int depth,
+    std::vector<Civilization>& result,
+    QueryStats& stats
+);
+
+// Streaming range query: onHit(const Civilization&) runs for every point in the
+// box and may return Visit::Stop to abort. Returns false if the visitor stopped.
+template <typename F, typename Stats>
+bool rangeVisit(
+    KDNode* root,
+    double latMin,
+    double latMax,
+    double lonMin,
+    double lonMax,
+    int depth,
+    F&& onHit,
+    Stats& stats
+) {
+    if (!root) return true;
+
+    stats.node();
+    if (!root->left && !root->right) stats.leaf();
+
+    if (root->civ.latitude >= latMin &&
+        root->civ.latitude <= latMax &&
+        root->civ.longitude >= lonMin &&
+        root->civ.longitude <= lonMax) {
+        if (invokeVisitor(onHit, root->civ) == Visit::Stop) return false;
+    }
+
+    int cd = depth % 2;
+
+    if ((cd == 0 && latMin < root->civ.latitude) ||
+        (cd == 1 && lonMin < root->civ.longitude)) {
+        if (!rangeVisit(root->left, latMin, latMax, lonMin, lonMax, depth + 1, onHit, stats)) return false;
+    } else if (root->left) {
+        stats.prune();
+    }
+
+    if ((cd == 0 && latMax >= root->civ.latitude) ||
+        (cd == 1 && lonMax >= root->civ.longitude)) {
+        if (!rangeVisit(root->right, latMin, latMax, lonMin, lonMax, depth + 1, onHit, stats)) return false;
+    } else if (root->right) {
+        stats.prune();
+    }
+
+    return true;
+}
+
+template <typename F>
+bool rangeVisit(
+    KDNode* root,
+    double latMin,
+    double latMax,
+    double lonMin,
+    double lonMax,
+    int depth,
+    F&& onHit
+) {
+    NoStats none;
+    return rangeVisit(root, latMin, latMax, lonMin, lonMax, depth, onHit, none);
+}
+
 void nearestNeighbor(
     KDNode* root,
     double lat,
@@ -45,6 +110,17 @@ void nearestNeighbor(
     int depth
 );
 
+// Same, also counting the work done into `stats`
+void nearestNeighbor(
+    KDNode* root,
+    double lat,
+    double lon,
+    Civilization& best,
+    double& bestDist,
+    int depth,
+    QueryStats& stats
+);
+
 double distance(double lat1, double lon1, double lat2, double lon2);
 void deleteKDTree(KDNode* root);
 
@@ -0,0 +1,46 @@
+#ifndef QUERY_STATS_H
+#define QUERY_STATS_H
+
+#include <cstddef>
+
+// Work done by a query, to tell tree shape from data when one is slow.
+// Query functions take it as an optional trailing out-parameter; their
+// plain overloads pass NoStats, whose empty members compile away.
+struct QueryStats {
+    size_t nodesVisited = 0;   // tree nodes entered
+    size_t leavesScanned = 0;  // leaf nodes (KD: nodes without children)
+    size_t distanceEvals = 0;  // point distance computations
+    size_t heapPushes = 0;     // priority queue pushes (best-first searches)
+    size_t subtreesPruned = 0; // children skipped by a bound or box test
+
+    void node() { nodesVisited++; }
+    void leaf() { leavesScanned++; }
+    void distance(size_t n = 1) { distanceEvals += n; }
+    void push() { heapPushes++; }
+    void prune(size_t n = 1) { subtreesPruned += n; }
+
+    void merge(const QueryStats& other) {
+        nodesVisited += other.nodesVisited;
+        leavesScanned += other.leavesScanned;
+        distanceEvals += other.distanceEvals;
+        heapPushes += other.heapPushes;
+        subtreesPruned += other.subtreesPruned;
+    }
+
+    // Share of the subtrees met that were skipped whole
+    double pruningRatio() const {
+        size_t met = nodesVisited + subtreesPruned;
+        return met ? (double)subtreesPruned / met : 0.0;
+    }
+};
+
+// Default for the query functions: counts nothing.
+struct NoStats {
+    void node() {}
+    void leaf() {}
+    void distance(size_t = 1) {}
+    void push() {}
+    void prune(size_t = 1) {}
+};
+
+#endif
@@ -0,0 +1,156 @@
+#include "region_index.h"
+#include <bitset>
+#include <thread>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const int REGION_FANOUT = 16;
+
+Rectangle boxToRect(const RegionBox& region) {
+    return Rectangle(region.lonMin, region.latMin, region.lonMax, region.latMax);
+}
+
+PolygonEdges cacheEdges(const RegionPolygon& region) {
+    PolygonEdges e;
+    size_t n = std::min(region.lats.size(), region.lons.size());
+    for (size_t i = 0, j = n - 1; i < n; j = i++) {
+        double xi = region.lons[i], yi = region.lats[i];
+        double xj = region.lons[j], yj = region.lats[j];
+        e.x0.push_back(xi);
+        e.y0.push_back(yi);
+        e.y1.push_back(yj);
+        e.slope.push_back(yj != yi ? (xj - xi) / (yj - yi) : 0.0);
+    }
+    while (e.x0.size() % 4 != 0) {
+        e.x0.push_back(0.0);
+        e.y0.push_back(0.0);
+        e.y1.push_back(0.0);
+        e.slope.push_back(0.0);
+    }
+    return e;
+}
+
+Rectangle polygonMBR(const RegionPolygon& region) {
+    Rectangle mbr;
+    for (size_t i = 0; i < region.lats.size() && i < region.lons.size(); ++i) {
+        mbr.expand(Rectangle(region.lons[i], region.lats[i], region.lons[i], region.lats[i]));
+    }
+    return mbr;
+}
+
+// Crossing-number (even-odd) test of (px, py) against every cached edge.
+bool insidePolygon(const PolygonEdges& e, double px, double py) {
+    size_t n = e.x0.size();
+    int crossings = 0;
+
+#if defined(__AVX2__)
+    const __m256d vpx = _mm256_set1_pd(px);
+    const __m256d vpy = _mm256_set1_pd(py);
+    for (size_t i = 0; i < n; i += 4) {
+        __m256d y0 = _mm256_loadu_pd(&e.y0[i]);
+        __m256d y1 = _mm256_loadu_pd(&e.y1[i]);
+        __m256d straddles = _mm256_xor_pd(_mm256_cmp_pd(y0, vpy, _CMP_GT_OQ),
+                                          _mm256_cmp_pd(y1, vpy, _CMP_GT_OQ));
+        __m256d crossX = _mm256_add_pd(_mm256_loadu_pd(&e.x0[i]),
+                                       _mm256_mul_pd(_mm256_loadu_pd(&e.slope[i]), _mm256_sub_pd(vpy, y0)));
+        __m256d left = _mm256_cmp_pd(vpx, crossX, _CMP_LT_OQ);
+        crossings += (int)std::bitset<4>(_mm256_movemask_pd(_mm256_and_pd(straddles, left))).count();
+    }
+#else
+    // Branch-free so the compiler can vectorise it without AVX2 intrinsics
+    for (size_t i = 0; i < n; ++i) {
+        bool straddles = (e.y0[i] > py) != (e.y1[i] > py);
+        bool left = px < e.x0[i] + e.slope[i] * (py - e.y0[i]);
+        crossings += straddles & left;
+    }
+#endif
+    return (crossings & 1) != 0;
+}
+
+} // namespace
+
+RegionIndex::RegionIndex() : tree(REGION_FANOUT) {}
+
+int RegionIndex::addShape(const std::string& label, const Rectangle& mbr, PolygonEdges polygon) {
+    int id = (int)labels.size();
+    labels.push_back(label);
+    edges.push_back(std::move(polygon));
+    tree.insert({mbr, id});
+    return id;
+}
+
+void RegionIndex::build(const std::vector<RegionBox>& regions) {
+    labels.clear();
+    edges.clear();
+    std::vector<RegionEntry> entries;
+    entries.reserve(regions.size());
+    for (const auto& region : regions) {
+        entries.push_back({boxToRect(region), (int)labels.size()});
+        labels.push_back(region.label);
+        edges.emplace_back();
+    }
+    tree.bulkLoad(std::move(entries));
+}
+
+void RegionIndex::build(const std::vector<RegionPolygon>& regions) {
+    labels.clear();
+    edges.clear();
+    std::vector<RegionEntry> entries;
+    entries.reserve(regions.size());
+    for (const auto& region : regions) {
+        entries.push_back({polygonMBR(region), (int)labels.size()});
+        labels.push_back(region.label);
+        edges.push_back(cacheEdges(region));
+    }
+    tree.bulkLoad(std::move(entries));
+}
+
+int RegionIndex::addRegion(const RegionBox& region) {
+    return addShape(region.label, boxToRect(region), PolygonEdges());
+}
+
+int RegionIndex::addRegion(const RegionPolygon& region) {
+    return addShape(region.label, polygonMBR(region), cacheEdges(region));
+}
+
+std::vector<int> RegionIndex::locate(double lat, double lon) const {
+    std::vector<int> ids;
+    for (const auto& entry : tree.stab(lon, lat)) {
+        const PolygonEdges& polygon = edges[entry.regionId];
+        if (polygon.empty() || insidePolygon(polygon, lon, lat)) ids.push_back(entry.regionId);
+    }
+    std::sort(ids.begin(), ids.end()); // Stable, load-order output regardless of tree shape
+    return ids;
+}
+
+std::vector<std::string> RegionIndex::queryPoint(double lat, double lon) const {
+    std::vector<std::string> res;
+    for (int id : locate(lat, lon)) res.push_back(labels[id]);
+    return res;
+}
+
+std::vector<int> RegionIndex::assignAll(const std::vector<std::pair<double, double>>& latLons, unsigned threads) const {
+    std::vector<int> assigned(latLons.size(), -1);
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+
+    auto work = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            auto ids = locate(latLons[i].first, latLons[i].second);
+            if (!ids.empty()) assigned[i] = ids.front();
+        }
+    };
+
+    size_t chunk = (latLons.size() + threads - 1) / threads;
+    std::vector<std::thread> workers;
+    for (unsigned t = 1; t < threads && t * chunk < latLons.size(); ++t) {
+        workers.emplace_back(work, t * chunk, std::min(latLons.size(), (t + 1) * chunk));
+    }
+    work(0, std::min(latLons.size(), chunk));
+    for (auto& w : workers) w.join();
+
+    return assigned;
+}
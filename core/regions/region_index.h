@@ -0,0 +1,74 @@
+#ifndef REGION_INDEX_H
+#define REGION_INDEX_H
+
+#include "../rtree/basic_rtree.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+// Named geographic region given as a latitude/longitude box.
+struct RegionBox {
+    std::string label;
+    double latMin, latMax, lonMin, lonMax;
+};
+
+// Named geographic region given as a simple polygon ring (implicitly closed).
+struct RegionPolygon {
+    std::string label;
+    std::vector<double> lats;
+    std::vector<double> lons;
+};
+
+// R-Tree leaf entry: a region's MBR (x = longitude, y = latitude) and its id.
+struct RegionEntry {
+    Rectangle box;
+    int regionId;
+
+    Rectangle bounds() const { return box; }
+    bool operator==(const RegionEntry& other) const { return regionId == other.regionId; }
+};
+
+// Polygon edges cached in structure-of-arrays form for the crossing-number test.
+// Edge i starts at (x0[i], y0[i]) and ends at height y1[i]; slope[i] = dx/dy so
+// the edge crosses height py at x0 + slope * (py - y0). Padded to a multiple of
+// 4 with horizontal edges that can never straddle a query.
+struct PolygonEdges {
+    std::vector<double> x0, y0, y1, slope;
+
+    bool empty() const { return x0.empty(); }
+};
+
+// Stabbing-query index over named regions ("which regions contain this point?").
+// Filter step: region MBRs in an R-Tree. Refine step: crossing-number test over
+// the cached edge arrays, skipped for box regions whose MBR is exact.
+class RegionIndex {
+private:
+    std::vector<std::string> labels;
+    std::vector<PolygonEdges> edges; // empty for box regions
+    BasicRTree<RegionEntry> tree;
+
+    int addShape(const std::string& label, const Rectangle& mbr, PolygonEdges polygon);
+
+public:
+    RegionIndex();
+
+    // Replace the index contents, STR-packing the tree in one pass.
+    void build(const std::vector<RegionBox>& regions);
+    void build(const std::vector<RegionPolygon>& regions);
+
+    int addRegion(const RegionBox& region);
+    int addRegion(const RegionPolygon& region);
+
+    std::vector<int> locate(double lat, double lon) const;
+    std::vector<std::string> queryPoint(double lat, double lon) const;
+
+    // Lowest-id region containing each (lat, lon), or -1. Work is split across
+    // `threads` workers (0 = hardware concurrency) for large bulk loads.
+    std::vector<int> assignAll(const std::vector<std::pair<double, double>>& latLons, unsigned threads = 0) const;
+
+    const std::string& label(int regionId) const { return labels[regionId]; }
+    int size() const { return (int)labels.size(); }
+    int height() const { return tree.getHeight(); }
+};
+
+#endif
@@ -0,0 +1,588 @@
+#ifndef BASIC_RTREE_H
+#define BASIC_RTREE_H
+
+#include "rectangle.h"
+#include "child_boxes.h"
+#include "../aggregate.h"
+#include "../query_stats.h"
+#include "../visit.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <new>
+#include <vector>
+
+// Guttman R-Tree over arbitrary rectangle entries.
+//
+// Entry requirements:
+//   Rectangle bounds() const;                 // MBR of the entry (a point is a degenerate box)
+//   bool operator==(const Entry&) const;      // identity for remove()
+//
+// Summary requirements (optional, defaults to NoSummary):
+//   default constructible empty summary
+//   void add(const Entry&);                   // fold one leaf entry in
+//   void merge(const Summary&);               // fold a child subtree in
+// Every node keeps the summary of its subtree, refreshed with its MBR, so
+// rangeAggregate() can take a fully contained subtree without descending.
+// insert() folds the new entry straight into every ancestor with add(), so
+// adding an entry must match merging a subtree that holds it.
+//
+// Kept free of any data model so both the CLI point index and the server's
+// region index can instantiate it.
+
+template <typename Entry, typename Summary = NoSummary>
+class BasicRTreeNode {
+public:
+    bool isLeaf;
+    Rectangle mbr;
+    BasicRTreeNode* parent;
+
+    std::vector<std::unique_ptr<BasicRTreeNode>> children;
+    ChildBoxes childBoxes;      // SoA mirror of children[i]->mbr, one slot per child
+    std::vector<Entry> entries; // For leaf nodes only
+    Summary summary;            // Aggregate of the whole subtree
+    int maxChildren;
+
+    // Internal nodes keep the child box arrays right after the node in the
+    // same allocation, and leaves reserve their entries up front; both are
+    // sized for maxChildren + 1 (one overflow slot, split right after).
+    static std::unique_ptr<BasicRTreeNode> make(bool leaf, int max_children, BasicRTreeNode* parent_node = nullptr) {
+        size_t lanes = leaf ? 0 : ChildBoxes::lanesFor(max_children + 1);
+        void* mem = ::operator new(sizeof(BasicRTreeNode) + 4 * lanes * sizeof(double));
+        auto* node = new (mem) BasicRTreeNode(leaf, max_children, parent_node);
+        if (lanes) node->childBoxes.attach(reinterpret_cast<double*>(node + 1), lanes);
+        else node->entries.reserve(max_children + 1);
+        return std::unique_ptr<BasicRTreeNode>(node);
+    }
+    static void operator delete(void* p) { ::operator delete(p); }
+
+private:
+    BasicRTreeNode(bool leaf, int max_children, BasicRTreeNode* parent_node)
+        : isLeaf(leaf), parent(parent_node), maxChildren(max_children) {}
+};
+
+template <typename Entry, typename Summary = NoSummary>
+class BasicRTree {
+public:
+    using Node = BasicRTreeNode<Entry, Summary>;
+
+protected:
+    std::unique_ptr<Node> root;
+    int MAX_CHILDREN;
+    int MIN_CHILDREN;
+    size_t count = 0;
+
+    Node* chooseLeaf(Node* node, const Rectangle& r);
+    std::unique_ptr<Node> splitNode(Node* node);
+    void pickSeeds(Node* node, size_t& seed1, size_t& seed2);
+    void distributeQuadratic(Node* node, std::unique_ptr<Node>& newNode, size_t seed1, size_t seed2);
+    void updateMBR(Node* node);
+
+    // Copies children[i]'s MBR into the parent's SoA slot; called whenever
+    // that child is placed or its MBR changes
+    static void refreshBox(Node* parent, size_t i) { parent->childBoxes.set(i, parent->children[i]->mbr); }
+    static size_t childIndex(const Node* parent, const Node* child) {
+        size_t i = 0;
+        while (parent->children[i].get() != child) ++i;
+        return i;
+    }
+
+    void adjustTree(Node* node, std::unique_ptr<Node> splitNode, const Entry& entry);
+
+    Node* findLeaf(Node* node, const Entry& entry);
+    void condenseTree(Node* node, std::vector<std::unique_ptr<Node>>& orphanedNodes, std::vector<Entry>& orphanedEntries);
+    void insertEntry(const Entry& entry);
+
+    // Calls onHit(entry) for every entry whose bounds intersect `query`.
+    // Returns false once the visitor asks to stop.
+    template <typename F, typename Stats>
+    bool visitIntersecting(const Node* node, const Rectangle& query, F& onHit, Stats& stats) const {
+        if (!node || !node->mbr.intersects(query)) return true;
+        stats.node();
+        if (node->isLeaf) {
+            stats.leaf();
+            for (const auto& entry : node->entries) {
+                if (query.intersects(entry.bounds()) && invokeVisitor(onHit, entry) == Visit::Stop) return false;
+            }
+        } else {
+            for (size_t first = 0; first < node->children.size(); first += 64) {
+                uint64_t hits = node->childBoxes.intersectMask(query, node->children.size(), first);
+                size_t block = std::min<size_t>(64, node->children.size() - first);
+                stats.prune(block - __builtin_popcountll(hits));
+                while (hits) {
+                    int bit = __builtin_ctzll(hits);
+                    hits &= hits - 1;
+                    if (!visitIntersecting(node->children[first + bit].get(), query, onHit, stats)) return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void aggregateRec(const Node* node, const Rectangle& query, Summary& out) const {
+        if (!node->mbr.intersects(query)) return;
+        if (query.contains(node->mbr)) {
+            out.merge(node->summary); // Whole subtree inside the query
+            return;
+        }
+        if (node->isLeaf) {
+            for (const auto& entry : node->entries) {
+                if (query.contains(entry.bounds())) out.add(entry);
+            }
+        } else {
+            for (const auto& child : node->children) aggregateRec(child.get(), query, out);
+        }
+    }
+
+public:
+    explicit BasicRTree(int maxChildren);
+    virtual ~BasicRTree() = default;
+
+    void insert(const Entry& entry);
+    bool remove(const Entry& entry);
+
+    // Sort-Tile-Recursive packing: replaces the contents with `items` in one pass.
+    // Produces fuller, less overlapping nodes than repeated insert().
+    void bulkLoad(std::vector<Entry> items);
+
+    // Streaming query: onHit(const Entry&) runs for each hit, in tree order, and
+    // may return Visit::Stop to abort. Returns false if the visitor stopped.
+    // The callback is a template parameter, so it is inlined into the traversal.
+    template <typename F>
+    bool search(const Rectangle& query, F&& onHit) const {
+        NoStats none;
+        return visitIntersecting(root.get(), query, onHit, none);
+    }
+
+    // Same, also counting the work done (query_stats.h)
+    template <typename F, typename Stats>
+    bool search(const Rectangle& query, F&& onHit, Stats& stats) const {
+        return visitIntersecting(root.get(), query, onHit, stats);
+    }
+
+    std::vector<Entry> intersecting(const Rectangle& query) const;
+
+    // Summary of every entry fully inside `query`. Contained subtrees are
+    // merged whole, so cost tracks the query boundary rather than the hit count.
+    Summary rangeAggregate(const Rectangle& query) const {
+        Summary out;
+        aggregateRec(root.get(), query, out);
+        return out;
+    }
+    std::vector<Entry> stab(double x, double y) const { return intersecting(Rectangle(x, y, x, y)); }
+
+    void clear();
+    int getHeight() const;
+    size_t size() const { return count; }
+};
+
+// ----------------------------------------------------
+// Construction
+// ----------------------------------------------------
+template <typename Entry, typename Summary>
+BasicRTree<Entry, Summary>::BasicRTree(int maxChildren) : MAX_CHILDREN(maxChildren) {
+    MIN_CHILDREN = std::max(2, MAX_CHILDREN / 2);
+    root = Node::make(true, MAX_CHILDREN);
+}
+
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::clear() {
+    root = Node::make(true, MAX_CHILDREN);
+    count = 0;
+}
+
+// ----------------------------------------------------
+// Node MBR Update
+// ----------------------------------------------------
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::updateMBR(Node* node) {
+    if (!node) return;
+
+    node->mbr = Rectangle(); // Resets to inverted infinity boundaries
+    node->summary = Summary();
+    if (node->isLeaf) {
+        for (const auto& entry : node->entries) {
+            node->mbr.expand(entry.bounds());
+            node->summary.add(entry);
+        }
+    } else {
+        for (const auto& child : node->children) {
+            if (child) {
+                node->mbr.expand(child->mbr);
+                node->summary.merge(child->summary);
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------
+// Core Insert Algorithms
+// ----------------------------------------------------
+template <typename Entry, typename Summary>
+typename BasicRTree<Entry, Summary>::Node* BasicRTree<Entry, Summary>::chooseLeaf(Node* node, const Rectangle& r) {
+    if (node->isLeaf) return node;
+
+    double minEnlargement = std::numeric_limits<double>::max();
+    double minArea = std::numeric_limits<double>::max();
+    Node* bestChild = nullptr;
+
+    // Child MBRs come from the node's own box arrays, so only the chosen child is touched
+    for (size_t i = 0; i < node->children.size(); ++i) {
+        Rectangle mbr = node->childBoxes.box(i);
+        double enlargement = mbr.enlargement(r);
+        if (enlargement < minEnlargement) {
+            minEnlargement = enlargement;
+            bestChild = node->children[i].get();
+            minArea = mbr.area();
+        } else if (enlargement == minEnlargement) {
+            // Prune tied nodes by minimum original area
+            if (mbr.area() < minArea) {
+                minArea = mbr.area();
+                bestChild = node->children[i].get();
+            }
+        }
+    }
+
+    if (!bestChild) bestChild = node->children[0].get();
+    return chooseLeaf(bestChild, r);
+}
+
+// Picks furthest pair via maximizing rectangular inefficiency
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::pickSeeds(Node* node, size_t& seed1, size_t& seed2) {
+    double maxInefficiency = -std::numeric_limits<double>::max();
+    seed1 = 0;
+    seed2 = 1;
+
+    size_t n = node->isLeaf ? node->entries.size() : node->children.size();
+
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = i + 1; j < n; ++j) {
+            Rectangle rect1 = node->isLeaf ? node->entries[i].bounds() : node->childBoxes.box(i);
+            Rectangle rect2 = node->isLeaf ? node->entries[j].bounds() : node->childBoxes.box(j);
+
+            Rectangle combined = rect1.combine(rect2);
+            double inefficiency = combined.area() - rect1.area() - rect2.area();
+            if (inefficiency > maxInefficiency) {
+                maxInefficiency = inefficiency;
+                seed1 = i;
+                seed2 = j;
+            }
+        }
+    }
+}
+
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::distributeQuadratic(Node* node, std::unique_ptr<Node>& newNode, size_t seed1, size_t seed2) {
+    if (node->isLeaf) {
+        std::vector<Entry> original;
+        std::swap(node->entries, original);
+        node->entries.reserve(original.capacity());
+
+        node->entries.push_back(std::move(original[seed1]));
+        newNode->entries.push_back(std::move(original[seed2]));
+        updateMBR(node);
+        updateMBR(newNode.get());
+
+        for (size_t i = 0; i < original.size(); ++i) {
+            if (i == seed1 || i == seed2) continue;
+
+            Rectangle entryRect = original[i].bounds();
+            double enl1 = node->mbr.enlargement(entryRect);
+            double enl2 = newNode->mbr.enlargement(entryRect);
+
+            Node* into = enl1 < enl2 || (enl1 == enl2 && node->mbr.area() <= newNode->mbr.area()) ? node : newNode.get();
+            into->mbr.expand(entryRect);
+            into->summary.add(original[i]);
+            into->entries.push_back(std::move(original[i]));
+        }
+    } else {
+        std::vector<std::unique_ptr<Node>> original;
+        std::swap(node->children, original);
+        for (size_t i = 0; i < original.size(); ++i) node->childBoxes.clear(i);
+
+        node->children.push_back(std::move(original[seed1]));
+        newNode->children.push_back(std::move(original[seed2]));
+
+        node->children.back()->parent = node;
+        newNode->children.back()->parent = newNode.get();
+        refreshBox(node, 0);
+        refreshBox(newNode.get(), 0);
+        updateMBR(node);
+        updateMBR(newNode.get());
+
+        for (size_t i = 0; i < original.size(); ++i) {
+            if (i == seed1 || i == seed2 || !original[i]) continue;
+
+            Rectangle childMBR = original[i]->mbr;
+            double enl1 = node->mbr.enlargement(childMBR);
+            double enl2 = newNode->mbr.enlargement(childMBR);
+
+            Node* into = enl1 < enl2 || (enl1 == enl2 && node->mbr.area() <= newNode->mbr.area()) ? node : newNode.get();
+            original[i]->parent = into;
+            into->mbr.expand(childMBR);
+            into->summary.merge(original[i]->summary);
+            into->children.push_back(std::move(original[i]));
+            refreshBox(into, into->children.size() - 1);
+        }
+    }
+}
+
+template <typename Entry, typename Summary>
+std::unique_ptr<typename BasicRTree<Entry, Summary>::Node> BasicRTree<Entry, Summary>::splitNode(Node* node) {
+    auto newNode = Node::make(node->isLeaf, MAX_CHILDREN, node->parent);
+    size_t seed1, seed2;
+    pickSeeds(node, seed1, seed2);
+    distributeQuadratic(node, newNode, seed1, seed2);
+    return newNode;
+}
+
+// Resolves splits and expansions upwards using raw parent mappings sequentially (no stack tracking).
+// Each ancestor only gains `entry`, so its MBR and summary grow by it alone,
+// and only the box slots of the changed children are rewritten.
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::adjustTree(Node* node, std::unique_ptr<Node> splitNode, const Entry& entry) {
+    while (node != root.get()) {
+        Node* parent = node->parent;
+        refreshBox(parent, childIndex(parent, node));
+        parent->mbr.expand(entry.bounds());
+        parent->summary.add(entry);
+
+        if (splitNode) { // Sub-tree splitted, join the new leaf to the parent
+            splitNode->parent = parent;
+            parent->children.push_back(std::move(splitNode));
+            refreshBox(parent, parent->children.size() - 1);
+        }
+
+        if (parent->children.size() > static_cast<size_t>(MAX_CHILDREN)) {
+            splitNode = BasicRTree::splitNode(parent);
+        } else {
+            splitNode = nullptr;
+        }
+        node = parent;
+    }
+
+    // Expand root vertically
+    if (splitNode) {
+        auto newRoot = Node::make(false, MAX_CHILDREN, nullptr);
+        node->parent = newRoot.get();
+        splitNode->parent = newRoot.get();
+        newRoot->children.push_back(std::move(root));
+        newRoot->children.push_back(std::move(splitNode));
+        refreshBox(newRoot.get(), 0);
+        refreshBox(newRoot.get(), 1);
+        updateMBR(newRoot.get());
+        root = std::move(newRoot);
+    }
+}
+
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::insertEntry(const Entry& entry) {
+    Node* leaf = chooseLeaf(root.get(), entry.bounds());
+
+    leaf->entries.push_back(entry);
+    leaf->mbr.expand(entry.bounds());
+    leaf->summary.add(entry);
+
+    std::unique_ptr<Node> splitPhase = nullptr;
+    if (leaf->entries.size() > static_cast<size_t>(MAX_CHILDREN)) {
+        splitPhase = splitNode(leaf);
+    }
+
+    adjustTree(leaf, std::move(splitPhase), entry);
+}
+
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::insert(const Entry& entry) {
+    insertEntry(entry);
+    count++;
+}
+
+// ----------------------------------------------------
+// Bulk Loading (Sort-Tile-Recursive)
+// ----------------------------------------------------
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::bulkLoad(std::vector<Entry> items) {
+    clear();
+    if (items.empty()) return;
+    count = items.size();
+
+    const size_t cap = static_cast<size_t>(MAX_CHILDREN);
+
+    // Tiles `n` items into runs of at most `cap`: sort by x, cut into vertical
+    // slices, sort each slice by y. Returns [begin, end) ranges of the runs.
+    auto tile = [cap](auto& vec, auto centerX, auto centerY) {
+        using T = typename std::decay_t<decltype(vec)>::value_type;
+        size_t n = vec.size();
+        size_t groups = (n + cap - 1) / cap;
+        size_t slices = static_cast<size_t>(std::ceil(std::sqrt(static_cast<double>(groups))));
+        size_t sliceSize = slices * cap;
+
+        std::sort(vec.begin(), vec.end(), [&](const T& a, const T& b) { return centerX(a) < centerX(b); });
+        std::vector<std::pair<size_t, size_t>> runs;
+        for (size_t s = 0; s < n; s += sliceSize) {
+            size_t e = std::min(n, s + sliceSize);
+            std::sort(vec.begin() + s, vec.begin() + e, [&](const T& a, const T& b) { return centerY(a) < centerY(b); });
+            for (size_t r = s; r < e; r += cap) runs.push_back({r, std::min(e, r + cap)});
+        }
+        return runs;
+    };
+
+    std::vector<std::unique_ptr<Node>> level;
+    auto runs = tile(items,
+                     [](const Entry& e) { return e.bounds().centerX(); },
+                     [](const Entry& e) { return e.bounds().centerY(); });
+    for (const auto& run : runs) {
+        auto leaf = Node::make(true, MAX_CHILDREN);
+        leaf->entries.assign(items.begin() + run.first, items.begin() + run.second);
+        updateMBR(leaf.get());
+        level.push_back(std::move(leaf));
+    }
+
+    while (level.size() > 1) {
+        auto nodeRuns = tile(level,
+                             [](const std::unique_ptr<Node>& n) { return n->mbr.centerX(); },
+                             [](const std::unique_ptr<Node>& n) { return n->mbr.centerY(); });
+        std::vector<std::unique_ptr<Node>> next;
+        for (const auto& run : nodeRuns) {
+            auto parent = Node::make(false, MAX_CHILDREN);
+            for (size_t i = run.first; i < run.second; ++i) {
+                level[i]->parent = parent.get();
+                parent->children.push_back(std::move(level[i]));
+                refreshBox(parent.get(), parent->children.size() - 1);
+            }
+            updateMBR(parent.get());
+            next.push_back(std::move(parent));
+        }
+        level = std::move(next);
+    }
+
+    root = std::move(level[0]);
+    root->parent = nullptr;
+}
+
+// ----------------------------------------------------
+// FULL DELETE IMPLEMENTATION
+// ----------------------------------------------------
+template <typename Entry, typename Summary>
+typename BasicRTree<Entry, Summary>::Node* BasicRTree<Entry, Summary>::findLeaf(Node* node, const Entry& entry) {
+    if (!node || !node->mbr.contains(entry.bounds())) return nullptr;
+
+    if (node->isLeaf) {
+        for (const auto& e : node->entries) {
+            if (e == entry) return node;
+        }
+        return nullptr;
+    }
+
+    // Children are filtered on the parent's SoA boxes, so only those whose MBR
+    // contains the entry are visited
+    Rectangle bounds = entry.bounds();
+    for (size_t i = 0; i < node->children.size(); ++i) {
+        if (!node->childBoxes.contains(i, bounds)) continue;
+        Node* result = findLeaf(node->children[i].get(), entry);
+        if (result) return result;
+    }
+    return nullptr;
+}
+
+template <typename Entry, typename Summary>
+void BasicRTree<Entry, Summary>::condenseTree(Node* node, std::vector<std::unique_ptr<Node>>& orphanedNodes, std::vector<Entry>& orphanedEntries) {
+    while (node != root.get()) {
+        Node* parent = node->parent;
+
+        // Is node under threshold limits?
+        bool underflow = (node->isLeaf && node->entries.size() < static_cast<size_t>(MIN_CHILDREN)) ||
+                         (!node->isLeaf && node->children.size() < static_cast<size_t>(MIN_CHILDREN));
+
+        size_t slot = childIndex(parent, node);
+        if (underflow) {
+            if (node->isLeaf) {
+                for (const auto& e : node->entries) orphanedEntries.push_back(e);
+            } else {
+                for (auto& child : node->children) orphanedNodes.push_back(std::move(child));
+            }
+            parent->childBoxes.erase(slot, parent->children.size());
+            parent->children.erase(parent->children.begin() + slot); // Drop node!
+        } else {
+            refreshBox(parent, slot);
+        }
+
+        updateMBR(parent);
+        node = parent;
+    }
+}
+
+template <typename Entry, typename Summary>
+bool BasicRTree<Entry, Summary>::remove(const Entry& entry) {
+    Node* leaf = findLeaf(root.get(), entry);
+    if (!leaf) return false;
+
+    // Excise entry natively
+    auto it = std::find_if(leaf->entries.begin(), leaf->entries.end(),
+                           [&](const Entry& e) { return e == entry; });
+    if (it != leaf->entries.end()) {
+        leaf->entries.erase(it);
+    } else {
+        return false;
+    }
+    count--;
+
+    updateMBR(leaf);
+
+    std::vector<std::unique_ptr<Node>> orphanedNodes;
+    std::vector<Entry> orphanedEntries;
+
+    condenseTree(leaf, orphanedNodes, orphanedEntries);
+
+    // Fully de-construct sub-hierachies to avoid height imbalance issues recursively
+    auto extractEntriesRec = [&](Node* n, auto& extractRef) -> void {
+        if (n->isLeaf) {
+            for (const auto& e : n->entries) orphanedEntries.push_back(e);
+        } else {
+            for (auto& child : n->children) extractRef(child.get(), extractRef);
+        }
+    };
+
+    for (auto& node : orphanedNodes) {
+        if (node) extractEntriesRec(node.get(), extractEntriesRec);
+    }
+
+    // Top-down reinsertion to recover structure properly
+    for (const auto& e : orphanedEntries) {
+        insertEntry(e);
+    }
+
+    // Retract heights if singular internal route exists via condensing
+    if (!root->isLeaf && root->children.size() == 1) {
+        std::unique_ptr<Node> newRoot = std::move(root->children[0]);
+        newRoot->parent = nullptr;
+        root = std::move(newRoot);
+    }
+    return true;
+}
+
+// ----------------------------------------------------
+// QUERIES
+// ----------------------------------------------------
+template <typename Entry, typename Summary>
+std::vector<Entry> BasicRTree<Entry, Summary>::intersecting(const Rectangle& query) const {
+    std::vector<Entry> results;
+    search(query, [&results](const Entry& e) { results.push_back(e); });
+    return results;
+}
+
+template <typename Entry, typename Summary>
+int BasicRTree<Entry, Summary>::getHeight() const {
+    if (!root) return 0;
+    int height = 1;
+    const Node* curr = root.get();
+    while (curr && !curr->isLeaf) {
+        height++;
+        curr = curr->children.empty() ? nullptr : curr->children[0].get();
+    }
+    return height;
+}
+
+#endif
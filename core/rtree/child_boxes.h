@@ -0,0 +1,123 @@
+#ifndef CHILD_BOXES_H
+#define CHILD_BOXES_H
+
+#include "rectangle.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+// One-pass tests of a query against a run of boxes stored as four parallel
+// arrays. `n` must be a multiple of 4 (pad with inverted boxes); the AVX2
+// paths handle four boxes per instruction.
+
+// Bit i of the result is set when box (first + i) intersects `q`.
+// Covers boxes [first, min(n, first + 64)).
+inline uint64_t boxIntersectMask(const double* xmin, const double* ymin,
+                                 const double* xmax, const double* ymax,
+                                 size_t n, const Rectangle& q, size_t first = 0) {
+    uint64_t mask = 0;
+    size_t end = std::min(n, first + 64);
+#if defined(__AVX2__)
+    const __m256d qxmin = _mm256_set1_pd(q.xmin), qymin = _mm256_set1_pd(q.ymin);
+    const __m256d qxmax = _mm256_set1_pd(q.xmax), qymax = _mm256_set1_pd(q.ymax);
+    for (size_t i = first; i < end; i += 4) {
+        // !(xmin > q.xmax || xmax < q.xmin || ymin > q.ymax || ymax < q.ymin)
+        __m256d hit = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(xmin + i), qxmax, _CMP_LE_OQ),
+                          _mm256_cmp_pd(_mm256_loadu_pd(xmax + i), qxmin, _CMP_GE_OQ)),
+            _mm256_and_pd(_mm256_cmp_pd(_mm256_loadu_pd(ymin + i), qymax, _CMP_LE_OQ),
+                          _mm256_cmp_pd(_mm256_loadu_pd(ymax + i), qymin, _CMP_GE_OQ)));
+        mask |= static_cast<uint64_t>(_mm256_movemask_pd(hit)) << (i - first);
+    }
+#else
+    for (size_t i = first; i < end; ++i) {
+        bool hit = xmin[i] <= q.xmax && xmax[i] >= q.xmin && ymin[i] <= q.ymax && ymax[i] >= q.ymin;
+        mask |= static_cast<uint64_t>(hit) << (i - first);
+    }
+#endif
+    return mask;
+}
+
+// out[i] = Rectangle::distanceToPoint(px, py) for each of the `n` boxes.
+inline void boxMinDistances(const double* xmin, const double* ymin,
+                            const double* xmax, const double* ymax,
+                            size_t n, double px, double py, double* out) {
+#if defined(__AVX2__)
+    const __m256d vpx = _mm256_set1_pd(px), vpy = _mm256_set1_pd(py);
+    const __m256d zero = _mm256_setzero_pd();
+    for (size_t i = 0; i < n; i += 4) {
+        __m256d dx = _mm256_max_pd(zero, _mm256_max_pd(_mm256_sub_pd(_mm256_loadu_pd(xmin + i), vpx),
+                                                       _mm256_sub_pd(vpx, _mm256_loadu_pd(xmax + i))));
+        __m256d dy = _mm256_max_pd(zero, _mm256_max_pd(_mm256_sub_pd(_mm256_loadu_pd(ymin + i), vpy),
+                                                       _mm256_sub_pd(vpy, _mm256_loadu_pd(ymax + i))));
+        _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy))));
+    }
+#else
+    for (size_t i = 0; i < n; ++i) {
+        double dx = std::max(0.0, std::max(xmin[i] - px, px - xmax[i]));
+        double dy = std::max(0.0, std::max(ymin[i] - py, py - ymax[i]));
+        out[i] = std::sqrt(dx * dx + dy * dy);
+    }
+#endif
+}
+
+// Child MBRs of an internal R-Tree node in structure-of-arrays form, so all
+// children can be tested against a query in one pass.
+//
+// A view over storage the node provides (BasicRTreeNode keeps it in its own
+// allocation), sized once for the node's capacity rounded up to whole lanes.
+// Slot i mirrors child i and is written only when that child changes; slots
+// past the last child hold inverted boxes that never match.
+struct ChildBoxes {
+    static size_t lanesFor(size_t n) { return (n + 3) / 4 * 4; }
+
+    // `storage` holds 4 * lanes doubles: xmin | ymin | xmax | ymax
+    void attach(double* storage, size_t laneCount) {
+        boxes = storage;
+        lanes = laneCount;
+        for (size_t i = 0; i < lanes; ++i) clear(i);
+    }
+
+    void set(size_t i, const Rectangle& r) {
+        boxes[i] = r.xmin; boxes[lanes + i] = r.ymin; boxes[2 * lanes + i] = r.xmax; boxes[3 * lanes + i] = r.ymax;
+    }
+
+    void clear(size_t i) { set(i, Rectangle()); }
+
+    Rectangle box(size_t i) const {
+        return Rectangle(boxes[i], boxes[lanes + i], boxes[2 * lanes + i], boxes[3 * lanes + i]);
+    }
+
+    bool contains(size_t i, const Rectangle& r) const {
+        return boxes[i] <= r.xmin && boxes[lanes + i] <= r.ymin &&
+               boxes[2 * lanes + i] >= r.xmax && boxes[3 * lanes + i] >= r.ymax;
+    }
+
+    // Drops slot i of `n`, shifting the later slots down like vector::erase
+    void erase(size_t i, size_t n) {
+        for (double* b = boxes; b < boxes + 4 * lanes; b += lanes) std::copy(b + i + 1, b + n, b + i);
+        clear(n - 1);
+    }
+
+    // Bit i of the result is set when child (first + i) of `n` intersects `q`.
+    uint64_t intersectMask(const Rectangle& q, size_t n, size_t first = 0) const {
+        return boxIntersectMask(boxes, boxes + lanes, boxes + 2 * lanes, boxes + 3 * lanes, lanesFor(n), q, first);
+    }
+
+    // out[i] = Rectangle::distanceToPoint for the first `n` children; `out`
+    // must hold lanesFor(n) values.
+    void minDistances(double px, double py, size_t n, double* out) const {
+        boxMinDistances(boxes, boxes + lanes, boxes + 2 * lanes, boxes + 3 * lanes, lanesFor(n), px, py, out);
+    }
+
+private:
+    double* boxes = nullptr;
+    size_t lanes = 0;
+};
+
+#endif
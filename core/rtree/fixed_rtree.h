@@ -0,0 +1,323 @@
+#ifndef FIXED_RTREE_H
+#define FIXED_RTREE_H
+
+#include "rectangle.h"
+#include "child_boxes.h"
+#include "../visit.h"
+#include <array>
+#include <limits>
+#include <queue>
+#include <vector>
+
+// R-Tree with compile-time fan-out and inline node storage.
+//
+// Leaves and internal nodes are separate, cache-line aligned types holding
+// std::array storage plus a size counter, so a node is one allocation and
+// loops over its entries have a constant trip count the compiler can unroll.
+// Internal nodes keep their child MBRs inline in SoA form for the SIMD kernels.
+//
+// Entry requirements are the same as BasicRTree's: bounds() and operator==,
+// plus default construction for the inline arrays. BasicRTree remains the
+// runtime-configurable engine (remove, summaries) for experiments.
+template <typename Entry, int MaxChildren, int MinChildren = MaxChildren / 2>
+class FixedRTree {
+    static_assert(MaxChildren >= 4 && MaxChildren < 64, "fan-out must fit the 64-bit hit mask");
+    static_assert(MinChildren >= 1 && MinChildren <= MaxChildren / 2, "minimum fill must allow a split");
+
+    static constexpr int CAP = MaxChildren + 1;        // One overflow slot, split right after
+    static constexpr int LANES = (CAP + 3) / 4 * 4;    // SoA padded to whole AVX2 lanes
+
+    struct NodeBase {
+        bool isLeaf;
+        int count = 0;
+        Rectangle mbr;
+        explicit NodeBase(bool leaf) : isLeaf(leaf) {}
+    };
+
+    struct alignas(64) Leaf : NodeBase {
+        std::array<Entry, CAP> entries;
+        Leaf() : NodeBase(true) {}
+    };
+
+    struct alignas(64) Internal : NodeBase {
+        std::array<double, LANES> xmin, ymin, xmax, ymax;
+        std::array<NodeBase*, CAP> children;
+
+        Internal() : NodeBase(false) {
+            xmin.fill(std::numeric_limits<double>::max());
+            ymin.fill(std::numeric_limits<double>::max());
+            xmax.fill(std::numeric_limits<double>::lowest());
+            ymax.fill(std::numeric_limits<double>::lowest());
+        }
+
+        void setBox(int i, const Rectangle& r) {
+            xmin[i] = r.xmin; ymin[i] = r.ymin; xmax[i] = r.xmax; ymax[i] = r.ymax;
+        }
+
+        void clearBox(int i) { setBox(i, Rectangle()); }
+    };
+
+    NodeBase* root;
+    size_t entryCount = 0;
+
+    static Leaf* asLeaf(NodeBase* n) { return static_cast<Leaf*>(n); }
+    static Internal* asInternal(NodeBase* n) { return static_cast<Internal*>(n); }
+    static const Leaf* asLeaf(const NodeBase* n) { return static_cast<const Leaf*>(n); }
+    static const Internal* asInternal(const NodeBase* n) { return static_cast<const Internal*>(n); }
+
+    static void destroy(NodeBase* node) {
+        if (node->isLeaf) {
+            delete asLeaf(node);
+            return;
+        }
+        Internal* in = asInternal(node);
+        for (int i = 0; i < in->count; ++i) destroy(in->children[i]);
+        delete in;
+    }
+
+    static void refreshMBR(NodeBase* node) {
+        node->mbr = Rectangle();
+        if (node->isLeaf) {
+            const Leaf* leaf = asLeaf(node);
+            for (int i = 0; i < leaf->count; ++i) node->mbr.expand(leaf->entries[i].bounds());
+        } else {
+            Internal* in = asInternal(node);
+            for (int i = 0; i < in->count; ++i) node->mbr.expand(in->children[i]->mbr);
+        }
+    }
+
+    // Quadratic split partition over CAP rectangles: second[i] marks the
+    // entries that move to the new sibling. Honours the minimum fill.
+    static void partition(const std::array<Rectangle, CAP>& rects, std::array<bool, CAP>& second) {
+        int seed1 = 0, seed2 = 1;
+        double maxInefficiency = -std::numeric_limits<double>::max();
+        for (int i = 0; i < CAP; ++i) {
+            for (int j = i + 1; j < CAP; ++j) {
+                double inefficiency = rects[i].combine(rects[j]).area() - rects[i].area() - rects[j].area();
+                if (inefficiency > maxInefficiency) {
+                    maxInefficiency = inefficiency;
+                    seed1 = i;
+                    seed2 = j;
+                }
+            }
+        }
+
+        second.fill(false);
+        second[seed2] = true;
+        Rectangle mbr1 = rects[seed1], mbr2 = rects[seed2];
+        int count1 = 1, count2 = 1, remaining = CAP - 2;
+
+        for (int i = 0; i < CAP; ++i) {
+            if (i == seed1 || i == seed2) continue;
+            bool toSecond;
+            if (count1 + remaining <= MinChildren) {
+                toSecond = false;
+            } else if (count2 + remaining <= MinChildren) {
+                toSecond = true;
+            } else {
+                double enl1 = mbr1.enlargement(rects[i]);
+                double enl2 = mbr2.enlargement(rects[i]);
+                toSecond = !(enl1 < enl2 || (enl1 == enl2 && mbr1.area() <= mbr2.area()));
+            }
+            second[i] = toSecond;
+            if (toSecond) { mbr2.expand(rects[i]); count2++; }
+            else          { mbr1.expand(rects[i]); count1++; }
+            --remaining;
+        }
+    }
+
+    static Leaf* splitLeaf(Leaf* leaf) {
+        std::array<Rectangle, CAP> rects;
+        for (int i = 0; i < CAP; ++i) rects[i] = leaf->entries[i].bounds();
+        std::array<bool, CAP> second;
+        partition(rects, second);
+
+        Leaf* sibling = new Leaf();
+        int kept = 0;
+        for (int i = 0; i < CAP; ++i) {
+            if (second[i]) sibling->entries[sibling->count++] = leaf->entries[i];
+            else leaf->entries[kept++] = leaf->entries[i];
+        }
+        leaf->count = kept;
+        refreshMBR(leaf);
+        refreshMBR(sibling);
+        return sibling;
+    }
+
+    static Internal* splitInternal(Internal* in) {
+        std::array<Rectangle, CAP> rects;
+        for (int i = 0; i < CAP; ++i) rects[i] = in->children[i]->mbr;
+        std::array<bool, CAP> second;
+        partition(rects, second);
+
+        Internal* sibling = new Internal();
+        int kept = 0;
+        for (int i = 0; i < CAP; ++i) {
+            if (second[i]) {
+                sibling->setBox(sibling->count, rects[i]);
+                sibling->children[sibling->count++] = in->children[i];
+            } else {
+                in->setBox(kept, rects[i]);
+                in->children[kept++] = in->children[i];
+            }
+        }
+        for (int i = kept; i < CAP; ++i) in->clearBox(i);
+        in->count = kept;
+        refreshMBR(in);
+        refreshMBR(sibling);
+        return sibling;
+    }
+
+    // Inserts below `node`; returns the new sibling if `node` had to split.
+    static NodeBase* insertRec(NodeBase* node, const Entry& entry, const Rectangle& r) {
+        if (node->isLeaf) {
+            Leaf* leaf = asLeaf(node);
+            leaf->entries[leaf->count++] = entry;
+            if (leaf->count > MaxChildren) return splitLeaf(leaf);
+            leaf->mbr.expand(r);
+            return nullptr;
+        }
+
+        Internal* in = asInternal(node);
+        int best = 0;
+        double minEnlargement = std::numeric_limits<double>::max();
+        double minArea = std::numeric_limits<double>::max();
+        for (int i = 0; i < in->count; ++i) {
+            const Rectangle& mbr = in->children[i]->mbr;
+            double enlargement = mbr.enlargement(r);
+            if (enlargement < minEnlargement || (enlargement == minEnlargement && mbr.area() < minArea)) {
+                minEnlargement = enlargement;
+                minArea = mbr.area();
+                best = i;
+            }
+        }
+
+        NodeBase* sibling = insertRec(in->children[best], entry, r);
+        in->setBox(best, in->children[best]->mbr);
+        if (sibling) {
+            in->setBox(in->count, sibling->mbr);
+            in->children[in->count++] = sibling;
+            if (in->count > MaxChildren) return splitInternal(in);
+        }
+        in->mbr.expand(r);
+        return nullptr;
+    }
+
+    template <typename F>
+    static bool visitRec(const NodeBase* node, const Rectangle& query, F& onHit) {
+        if (node->isLeaf) {
+            const Leaf* leaf = asLeaf(node);
+            for (int i = 0; i < leaf->count; ++i) {
+                if (query.intersects(leaf->entries[i].bounds()) &&
+                    invokeVisitor(onHit, leaf->entries[i]) == Visit::Stop) return false;
+            }
+            return true;
+        }
+        const Internal* in = asInternal(node);
+        uint64_t hits = boxIntersectMask(in->xmin.data(), in->ymin.data(), in->xmax.data(), in->ymax.data(),
+                                         LANES, query);
+        while (hits) {
+            int bit = __builtin_ctzll(hits);
+            hits &= hits - 1;
+            if (!visitRec(in->children[bit], query, onHit)) return false;
+        }
+        return true;
+    }
+
+public:
+    FixedRTree() : root(new Leaf()) {}
+    ~FixedRTree() { destroy(root); }
+
+    FixedRTree(const FixedRTree&) = delete;
+    FixedRTree& operator=(const FixedRTree&) = delete;
+
+    void insert(const Entry& entry) {
+        Rectangle r = entry.bounds();
+        NodeBase* sibling = insertRec(root, entry, r);
+        if (sibling) { // Grow the tree vertically
+            Internal* newRoot = new Internal();
+            newRoot->setBox(0, root->mbr);
+            newRoot->setBox(1, sibling->mbr);
+            newRoot->children[0] = root;
+            newRoot->children[1] = sibling;
+            newRoot->count = 2;
+            refreshMBR(newRoot);
+            root = newRoot;
+        }
+        entryCount++;
+    }
+
+    // Streaming query, same contract as BasicRTree::search.
+    template <typename F>
+    bool search(const Rectangle& query, F&& onHit) const {
+        if (!root->mbr.intersects(query)) return true;
+        return visitRec(root, query, onHit);
+    }
+
+    std::vector<Entry> intersecting(const Rectangle& query) const {
+        std::vector<Entry> results;
+        search(query, [&results](const Entry& e) { results.push_back(e); });
+        return results;
+    }
+
+    // Best-first nearest entry by bounds distance to (x, y).
+    bool nearest(double x, double y, Entry& best, double& bestDist) const {
+        struct Candidate {
+            double dist;
+            const NodeBase* node;
+            bool operator>(const Candidate& other) const { return dist > other.dist; }
+        };
+
+        bestDist = std::numeric_limits<double>::max();
+        bool found = false;
+        std::array<double, LANES> childDist;
+
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> pq;
+        pq.push({root->mbr.distanceToPoint(x, y), root});
+        while (!pq.empty()) {
+            Candidate current = pq.top();
+            pq.pop();
+            if (current.dist >= bestDist) break;
+
+            if (current.node->isLeaf) {
+                const Leaf* leaf = asLeaf(current.node);
+                for (int i = 0; i < leaf->count; ++i) {
+                    double d = leaf->entries[i].bounds().distanceToPoint(x, y);
+                    if (d < bestDist) {
+                        bestDist = d;
+                        best = leaf->entries[i];
+                        found = true;
+                    }
+                }
+            } else {
+                const Internal* in = asInternal(current.node);
+                boxMinDistances(in->xmin.data(), in->ymin.data(), in->xmax.data(), in->ymax.data(),
+                                LANES, x, y, childDist.data());
+                for (int i = 0; i < in->count; ++i) {
+                    if (childDist[i] < bestDist) pq.push({childDist[i], in->children[i]});
+                }
+            }
+        }
+        return found;
+    }
+
+    void clear() {
+        destroy(root);
+        root = new Leaf();
+        entryCount = 0;
+    }
+
+    int getHeight() const {
+        int height = 1;
+        const NodeBase* curr = root;
+        while (!curr->isLeaf) {
+            height++;
+            curr = asInternal(curr)->children[0];
+        }
+        return height;
+    }
+
+    size_t size() const { return entryCount; }
+};
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef RECTANGLE_H
+#define RECTANGLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Axis-aligned bounding rectangle shared by every R-Tree variant.
+// x is longitude and y is latitude throughout the spatial core.
+struct Rectangle {
+    double xmin, ymin, xmax, ymax;
+
+    Rectangle() : xmin(std::numeric_limits<double>::max()), ymin(std::numeric_limits<double>::max()),
+                  xmax(std::numeric_limits<double>::lowest()), ymax(std::numeric_limits<double>::lowest()) {}
+
+    Rectangle(double x1, double y1, double x2, double y2) : xmin(x1), ymin(y1), xmax(x2), ymax(y2) {}
+
+    double area() const {
+        if (xmin > xmax || ymin > ymax) return 0.0;
+        return (xmax - xmin) * (ymax - ymin);
+    }
+
+    Rectangle combine(const Rectangle& other) const {
+        return Rectangle(
+            std::min(xmin, other.xmin),
+            std::min(ymin, other.ymin),
+            std::max(xmax, other.xmax),
+            std::max(ymax, other.ymax)
+        );
+    }
+
+    void expand(const Rectangle& other) {
+        xmin = std::min(xmin, other.xmin);
+        ymin = std::min(ymin, other.ymin);
+        xmax = std::max(xmax, other.xmax);
+        ymax = std::max(ymax, other.ymax);
+    }
+
+    bool intersects(const Rectangle& other) const {
+        return !(xmin > other.xmax || xmax < other.xmin ||
+                 ymin > other.ymax || ymax < other.ymin);
+    }
+
+    double enlargement(const Rectangle& other) const {
+        Rectangle combined = combine(other);
+        return combined.area() - area();
+    }
+
+    double distanceToPoint(double px, double py) const {
+        double dx = std::max({0.0, xmin - px, px - xmax});
+        double dy = std::max({0.0, ymin - py, py - ymax});
+        return std::sqrt(dx * dx + dy * dy);
+    }
+
+    bool contains(double px, double py) const {
+        return (px >= xmin && px <= xmax && py >= ymin && py <= ymax);
+    }
+
+    bool contains(const Rectangle& other) const {
+        return (other.xmin >= xmin && other.xmax <= xmax &&
+                other.ymin >= ymin && other.ymax <= ymax);
+    }
+
+    double centerX() const { return (xmin + xmax) / 2.0; }
+    double centerY() const { return (ymin + ymax) / 2.0; }
+};
+
+#endif
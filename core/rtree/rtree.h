@@ -2,6 +2,8 @@
 #define RTREE_H
 
 #include "../kd_tree.h" // For Civilization struct and distance function
+#include "../spatial_index.h"
+#include "basic_rtree.h"
 #include <vector>
 #include <algorithm>
 #include <cmath>
@@ -18,109 +20,73 @@ struct Point {
     bool operator==(const Point& other) const {
         return x == other.x && y == other.y && civ.id == other.civ.id;
     }
+
+    Rectangle bounds() const { return Rectangle(x, y, x, y); }
 };
 
-struct Rectangle {
-    double xmin, ymin, xmax, ymax;
+// Per-node point count, so count() takes contained subtrees whole, and the
+// best spatial score below, which bounds topKInRange().
+struct PointSummary {
+    size_t n = 0;
+    double maxScore = std::numeric_limits<double>::lowest();
+    void add(const Point& p) { n++; maxScore = std::max(maxScore, p.civ.spatialScore()); }
+    void merge(const PointSummary& other) { n += other.n; maxScore = std::max(maxScore, other.maxScore); }
+};
 
-    Rectangle() : xmin(std::numeric_limits<double>::max()), ymin(std::numeric_limits<double>::max()),
-                  xmax(std::numeric_limits<double>::lowest()), ymax(std::numeric_limits<double>::lowest()) {}
+using RTreeNode = BasicRTreeNode<Point, PointSummary>;
 
-    Rectangle(double x1, double y1, double x2, double y2) : xmin(x1), ymin(y1), xmax(x2), ymax(y2) {}
+// Point R-Tree over civilizations: the generic engine plus civilization-shaped
+// queries. Meets the SpatialIndex requirements (spatial_index.h).
+class RTree : public BasicRTree<Point, PointSummary> {
+public:
+    using value_type = Civilization;
 
-    double area() const {
-        if (xmin > xmax || ymin > ymax) return 0.0;
-        return (xmax - xmin) * (ymax - ymin);
-    }
+    RTree(int maxChildren);
+    ~RTree();
 
-    Rectangle combine(const Rectangle& other) const {
-        return Rectangle(
-            std::min(xmin, other.xmin),
-            std::min(ymin, other.ymin),
-            std::max(xmax, other.xmax),
-            std::max(ymax, other.ymax)
-        );
-    }
-    
-    void expand(const Rectangle& other) {
-        xmin = std::min(xmin, other.xmin);
-        ymin = std::min(ymin, other.ymin);
-        xmax = std::max(xmax, other.xmax);
-        ymax = std::max(ymax, other.ymax);
+    using BasicRTree<Point, PointSummary>::search; // Streaming visitor overloads
+    std::vector<Civilization> search(const Rectangle& query) const;
+    bool nearestNeighbor(const Point& point, Civilization& best, double& bestDist) const;
+    bool nearestNeighbor(const Point& point, Civilization& best, double& bestDist, QueryStats& stats) const;
+
+    // SpatialIndex operations
+    void build(std::vector<Civilization> civs); // STR bulk load
+    const Civilization* nearest(double lat, double lon, double& bestDist) const;
+    const Civilization* nearest(double lat, double lon, double& bestDist, QueryStats& stats) const;
+    std::vector<Neighbor<Civilization>> kNearest(double lat, double lon, size_t k) const;
+
+    template <typename F>
+    bool range(double latMin, double latMax, double lonMin, double lonMax, F&& onHit) const {
+        NoStats none;
+        return range(latMin, latMax, lonMin, lonMax, onHit, none);
     }
 
-    bool intersects(const Rectangle& other) const {
-        return !(xmin > other.xmax || xmax < other.xmin ||
-                 ymin > other.ymax || ymax < other.ymin);
+    template <typename F, typename Stats>
+    bool range(double latMin, double latMax, double lonMin, double lonMax, F&& onHit, Stats& stats) const {
+        return search(Rectangle(lonMin, latMin, lonMax, latMax),
+                      [&onHit](const Point& p) { return invokeVisitor(onHit, p.civ); }, stats);
     }
 
-    double enlargement(const Rectangle& other) const {
-        Rectangle combined = combine(other);
-        return combined.area() - area();
-    }
-    
-    double distanceToPoint(double px, double py) const {
-        double dx = std::max({0.0, xmin - px, px - xmax});
-        double dy = std::max({0.0, ymin - py, py - ymax});
-        return std::sqrt(dx * dx + dy * dy);
+    template <typename F>
+    bool radius(double lat, double lon, double r, F&& onHit) const {
+        return search(Rectangle(lon - r, lat - r, lon + r, lat + r), [&](const Point& p) {
+            if (distance(lat, lon, p.civ.latitude, p.civ.longitude) > r) return Visit::Continue;
+            return invokeVisitor(onHit, p.civ);
+        });
     }
-    
-    bool contains(const Point& p) const {
-        return (p.x >= xmin && p.x <= xmax && p.y >= ymin && p.y <= ymax);
-    }
-};
 
-class RTreeNode {
-public:
-    bool isLeaf;
-    Rectangle mbr;
-    RTreeNode* parent;
-    
-    // Replaced raw pointers with unique_ptr for strict modern C++17 memory safety
-    std::vector<std::unique_ptr<RTreeNode>> children;
-    std::vector<Point> points; // For leaf nodes only
-    int maxChildren;
-
-    // Default constructor taking parent non-owning raw pointer
-    RTreeNode(bool leaf, int max_children, RTreeNode* parent_node = nullptr) 
-        : isLeaf(leaf), parent(parent_node), maxChildren(max_children) {}
+    size_t count(double latMin, double latMax, double lonMin, double lonMax) const {
+        return rangeAggregate(Rectangle(lonMin, latMin, lonMax, latMax)).n;
+    }
 
-    // No need for explicit destructor, unique_ptr naturally cleans up all branches and stops memory leaks.
-};
+    // The k civilizations in the box with the highest spatialScore(), best
+    // first; nodes are expanded in order of their maxScore
+    std::vector<Ranked<Civilization>> topKInRange(double latMin, double latMax, double lonMin, double lonMax,
+                                                  size_t k) const;
 
-class RTree {
 private:
-    std::unique_ptr<RTreeNode> root;
-    int MAX_CHILDREN;
-    int MIN_CHILDREN;
-
-    RTreeNode* chooseLeaf(RTreeNode* node, const Rectangle& r);
-    std::unique_ptr<RTreeNode> splitNode(RTreeNode* node);
-    void pickSeeds(RTreeNode* node, int& seed1, int& seed2);
-    void distributeQuadratic(RTreeNode* node, std::unique_ptr<RTreeNode>& newNode, int seed1, int seed2);
-    
-    // Encapsulated MBR updating bounding functionality tightly
-    void updateMBR(RTreeNode* node);
-    
-    // Upward tree adjustment via parent pointers
-    void adjustTree(RTreeNode* node, std::unique_ptr<RTreeNode> splitNode);
-    
-    // Sub-routines for deletion maintaining R-Tree invariants
-    RTreeNode* findLeaf(RTreeNode* node, const Point& point);
-    void condenseTree(RTreeNode* node, std::vector<std::unique_ptr<RTreeNode>>& orphanedNodes, std::vector<Point>& orphanedPoints);
-    
-    void searchRec(RTreeNode* node, const Rectangle& query, std::vector<Civilization>& results) const;
-    
-public:
-    RTree(int maxChildren);
-    ~RTree();
-
-    void insert(const Point& point);
-    bool remove(const Point& point);
-    std::vector<Civilization> search(const Rectangle& query) const;
-    bool nearestNeighbor(const Point& point, Civilization& best, double& bestDist) const;
-    void clear();
-    int getHeight() const;
+    template <typename Stats>
+    const Civilization* nearestSearch(double lat, double lon, double& bestDist, Stats& stats) const;
 };
 
 #endif
@@ -0,0 +1,299 @@
+#include "snapshot_rtree.h"
+#include <queue>
+
+namespace {
+
+Rectangle boundsOf(const Point& p) { return p.bounds(); }
+Rectangle boundsOf(const SnapshotNodePtr& n) { return n->mbr; }
+
+void recomputeMBR(SnapshotNode& node) {
+    node.mbr = Rectangle();
+    if (node.isLeaf) {
+        for (const auto& pt : node.points) node.mbr.expand(boundsOf(pt));
+    } else {
+        for (const auto& child : node.children) node.mbr.expand(child->mbr);
+    }
+}
+
+void collectPoints(const SnapshotNode& node, std::vector<Point>& out) {
+    if (node.isLeaf) {
+        out.insert(out.end(), node.points.begin(), node.points.end());
+        return;
+    }
+    for (const auto& child : node.children) collectPoints(*child, out);
+}
+
+// Guttman quadratic split over either leaf points or child pointers.
+// Entries are redistributed between `keep` and `moved`, honouring the minimum fill.
+template <typename T>
+void quadraticSplit(std::vector<T>& keep, std::vector<T>& moved, size_t minFill) {
+    std::vector<T> original;
+    std::swap(keep, original);
+
+    size_t seed1 = 0, seed2 = 1;
+    double maxInefficiency = -std::numeric_limits<double>::max();
+    for (size_t i = 0; i < original.size(); ++i) {
+        for (size_t j = i + 1; j < original.size(); ++j) {
+            Rectangle r1 = boundsOf(original[i]), r2 = boundsOf(original[j]);
+            double inefficiency = r1.combine(r2).area() - r1.area() - r2.area();
+            if (inefficiency > maxInefficiency) {
+                maxInefficiency = inefficiency;
+                seed1 = i;
+                seed2 = j;
+            }
+        }
+    }
+
+    Rectangle mbr1 = boundsOf(original[seed1]);
+    Rectangle mbr2 = boundsOf(original[seed2]);
+    keep.push_back(std::move(original[seed1]));
+    moved.push_back(std::move(original[seed2]));
+
+    size_t remaining = original.size() - 2;
+    for (size_t i = 0; i < original.size(); ++i) {
+        if (i == seed1 || i == seed2) continue;
+
+        Rectangle r = boundsOf(original[i]);
+        bool toKeep;
+        if (keep.size() + remaining <= minFill) {
+            toKeep = true;
+        } else if (moved.size() + remaining <= minFill) {
+            toKeep = false;
+        } else {
+            double enl1 = mbr1.enlargement(r);
+            double enl2 = mbr2.enlargement(r);
+            toKeep = enl1 < enl2 || (enl1 == enl2 && mbr1.area() <= mbr2.area());
+        }
+
+        if (toKeep) {
+            mbr1.expand(r);
+            keep.push_back(std::move(original[i]));
+        } else {
+            mbr2.expand(r);
+            moved.push_back(std::move(original[i]));
+        }
+        --remaining;
+    }
+}
+
+} // namespace
+
+// ----------------------------------------------------
+// Snapshot (reader side)
+// ----------------------------------------------------
+
+void RTreeSnapshot::searchRec(const SnapshotNode* node, const Rectangle& query, std::vector<Civilization>& results) const {
+    if (!node->mbr.intersects(query)) return;
+
+    if (node->isLeaf) {
+        for (const auto& point : node->points) {
+            if (query.contains(point.x, point.y)) results.push_back(point.civ);
+        }
+    } else {
+        for (const auto& child : node->children) searchRec(child.get(), query, results);
+    }
+}
+
+std::vector<Civilization> RTreeSnapshot::search(const Rectangle& query) const {
+    std::vector<Civilization> results;
+    searchRec(root.get(), query, results);
+    return results;
+}
+
+bool RTreeSnapshot::nearestNeighbor(const Point& point, Civilization& best, double& bestDist) const {
+    struct Candidate {
+        double dist;
+        const SnapshotNode* node;
+        bool operator>(const Candidate& other) const { return dist > other.dist; }
+    };
+
+    bestDist = std::numeric_limits<double>::max();
+    bool found = false;
+
+    std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> pq;
+    pq.push({root->mbr.distanceToPoint(point.x, point.y), root.get()});
+
+    while (!pq.empty()) {
+        Candidate current = pq.top();
+        pq.pop();
+        if (current.dist >= bestDist) break;
+
+        const SnapshotNode* node = current.node;
+        if (node->isLeaf) {
+            for (const auto& pt : node->points) {
+                double d = distance(point.y, point.x, pt.civ.latitude, pt.civ.longitude);
+                if (d < bestDist) {
+                    bestDist = d;
+                    best = pt.civ;
+                    found = true;
+                }
+            }
+        } else {
+            for (const auto& child : node->children) {
+                double minDist = child->mbr.distanceToPoint(point.x, point.y);
+                if (minDist < bestDist) pq.push({minDist, child.get()});
+            }
+        }
+    }
+    return found;
+}
+
+int RTreeSnapshot::getHeight() const {
+    int height = 1;
+    const SnapshotNode* curr = root.get();
+    while (!curr->isLeaf && !curr->children.empty()) {
+        height++;
+        curr = curr->children[0].get();
+    }
+    return height;
+}
+
+// ----------------------------------------------------
+// Versioned tree (writer side)
+// ----------------------------------------------------
+
+SnapshotRTree::SnapshotRTree(int maxChildren) : MAX_CHILDREN(maxChildren) {
+    MIN_CHILDREN = std::max(2, MAX_CHILDREN / 2);
+    current = std::make_shared<const RTreeSnapshot>();
+}
+
+RTreeSnapshot SnapshotRTree::snapshot() const {
+    return *std::atomic_load(&current);
+}
+
+void SnapshotRTree::publish(SnapshotNodePtr root, size_t count) {
+    uint64_t version = current->getVersion() + 1; // only writers touch `current` non-atomically, under writeMutex
+    std::atomic_store(&current, std::make_shared<const RTreeSnapshot>(std::move(root), count, version));
+}
+
+std::shared_ptr<SnapshotNode> SnapshotRTree::splitNode(SnapshotNode& node) const {
+    auto newNode = std::make_shared<SnapshotNode>(node.isLeaf);
+    if (node.isLeaf) {
+        quadraticSplit(node.points, newNode->points, MIN_CHILDREN);
+    } else {
+        quadraticSplit(node.children, newNode->children, MIN_CHILDREN);
+    }
+    recomputeMBR(node);
+    recomputeMBR(*newNode);
+    return newNode;
+}
+
+// Copies `node` with `point` inserted below it. If the copy overflows it is split
+// and the second half returned through `split` for the caller to adopt.
+void SnapshotRTree::insertRec(const SnapshotNode& node, const Point& point,
+                              std::shared_ptr<SnapshotNode>& copy, std::shared_ptr<SnapshotNode>& split) const {
+    copy = std::make_shared<SnapshotNode>(node);
+    split = nullptr;
+
+    if (copy->isLeaf) {
+        copy->points.push_back(point);
+    } else {
+        Rectangle r = boundsOf(point);
+        size_t bestIdx = 0;
+        double minEnlargement = std::numeric_limits<double>::max();
+        double minArea = std::numeric_limits<double>::max();
+        for (size_t i = 0; i < copy->children.size(); ++i) {
+            const Rectangle& mbr = copy->children[i]->mbr;
+            double enlargement = mbr.enlargement(r);
+            if (enlargement < minEnlargement || (enlargement == minEnlargement && mbr.area() < minArea)) {
+                minEnlargement = enlargement;
+                minArea = mbr.area();
+                bestIdx = i;
+            }
+        }
+
+        std::shared_ptr<SnapshotNode> childCopy, childSplit;
+        insertRec(*copy->children[bestIdx], point, childCopy, childSplit);
+        copy->children[bestIdx] = std::move(childCopy);
+        if (childSplit) copy->children.push_back(std::move(childSplit));
+    }
+
+    size_t entries = copy->isLeaf ? copy->points.size() : copy->children.size();
+    if (entries > static_cast<size_t>(MAX_CHILDREN)) {
+        split = splitNode(*copy);
+    } else {
+        recomputeMBR(*copy);
+    }
+}
+
+SnapshotNodePtr SnapshotRTree::insertIntoRoot(const SnapshotNodePtr& root, const Point& point) const {
+    std::shared_ptr<SnapshotNode> copy, split;
+    insertRec(*root, point, copy, split);
+    if (!split) return copy;
+
+    // Grow the tree vertically
+    auto newRoot = std::make_shared<SnapshotNode>(false);
+    newRoot->children.push_back(std::move(copy));
+    newRoot->children.push_back(std::move(split));
+    recomputeMBR(*newRoot);
+    return newRoot;
+}
+
+void SnapshotRTree::insert(const Point& point) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    publish(insertIntoRoot(current->rootNode(), point), current->size() + 1);
+}
+
+void SnapshotRTree::insertBatch(const std::vector<Point>& points) {
+    if (points.empty()) return;
+    std::lock_guard<std::mutex> lock(writeMutex);
+    SnapshotNodePtr root = current->rootNode();
+    for (const auto& pt : points) root = insertIntoRoot(root, pt);
+    publish(std::move(root), current->size() + points.size());
+}
+
+// Copies the path down to the leaf holding `point`. Children that underflow are
+// dropped and their points handed back through `orphanedPoints` for reinsertion.
+bool SnapshotRTree::removeRec(const SnapshotNode& node, const Point& point,
+                              std::shared_ptr<SnapshotNode>& copy, std::vector<Point>& orphanedPoints) const {
+    if (!node.mbr.contains(point.x, point.y)) return false;
+
+    if (node.isLeaf) {
+        auto it = std::find(node.points.begin(), node.points.end(), point);
+        if (it == node.points.end()) return false;
+        copy = std::make_shared<SnapshotNode>(node);
+        copy->points.erase(copy->points.begin() + (it - node.points.begin()));
+        recomputeMBR(*copy);
+        return true;
+    }
+
+    for (size_t i = 0; i < node.children.size(); ++i) {
+        std::shared_ptr<SnapshotNode> childCopy;
+        if (!removeRec(*node.children[i], point, childCopy, orphanedPoints)) continue;
+
+        copy = std::make_shared<SnapshotNode>(node);
+        size_t entries = childCopy->isLeaf ? childCopy->points.size() : childCopy->children.size();
+        if (entries < static_cast<size_t>(MIN_CHILDREN)) {
+            collectPoints(*childCopy, orphanedPoints);
+            copy->children.erase(copy->children.begin() + i);
+        } else {
+            copy->children[i] = std::move(childCopy);
+        }
+        recomputeMBR(*copy);
+        return true;
+    }
+    return false;
+}
+
+bool SnapshotRTree::remove(const Point& point) {
+    std::lock_guard<std::mutex> lock(writeMutex);
+
+    std::shared_ptr<SnapshotNode> copy;
+    std::vector<Point> orphanedPoints;
+    if (!removeRec(*current->rootNode(), point, copy, orphanedPoints)) return false;
+
+    SnapshotNodePtr root = std::move(copy);
+    for (const auto& pt : orphanedPoints) root = insertIntoRoot(root, pt);
+
+    // Retract height while the root has a single route
+    while (!root->isLeaf && root->children.size() == 1) root = root->children[0];
+    if (!root->isLeaf && root->children.empty()) root = std::make_shared<SnapshotNode>(true);
+
+    publish(std::move(root), current->size() - 1);
+    return true;
+}
+
+void SnapshotRTree::clear() {
+    std::lock_guard<std::mutex> lock(writeMutex);
+    publish(std::make_shared<SnapshotNode>(true), 0);
+}
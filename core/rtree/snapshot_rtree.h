@@ -0,0 +1,80 @@
+#ifndef SNAPSHOT_RTREE_H
+#define SNAPSHOT_RTREE_H
+
+#include "rtree.h" // Point, Rectangle
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Node of a copy-on-write R-Tree. Once a node is reachable from a published
+// root it is never modified again; writers copy the path they touch instead.
+struct SnapshotNode {
+    bool isLeaf;
+    Rectangle mbr;
+    std::vector<std::shared_ptr<const SnapshotNode>> children;
+    std::vector<Point> points; // For leaf nodes only
+
+    explicit SnapshotNode(bool leaf) : isLeaf(leaf) {}
+};
+
+using SnapshotNodePtr = std::shared_ptr<const SnapshotNode>;
+
+// Read handle pinned to one version of the tree. While a handle is alive every
+// node of its version stays alive, so long scans see a consistent index even
+// if writers publish newer versions in the meantime.
+class RTreeSnapshot {
+private:
+    SnapshotNodePtr root;
+    size_t count;
+    uint64_t version;
+
+    void searchRec(const SnapshotNode* node, const Rectangle& query, std::vector<Civilization>& results) const;
+
+public:
+    RTreeSnapshot() : root(std::make_shared<SnapshotNode>(true)), count(0), version(0) {}
+    RTreeSnapshot(SnapshotNodePtr r, size_t n, uint64_t v) : root(std::move(r)), count(n), version(v) {}
+
+    std::vector<Civilization> search(const Rectangle& query) const;
+    bool nearestNeighbor(const Point& point, Civilization& best, double& bestDist) const;
+    const SnapshotNodePtr& rootNode() const { return root; }
+    size_t size() const { return count; }
+    uint64_t getVersion() const { return version; }
+    int getHeight() const;
+};
+
+// Multi-version R-Tree: writers path-copy from leaf to root and publish the new
+// root atomically, readers grab a snapshot and never block on writers.
+// Writers are serialized among themselves; old versions are reclaimed by
+// shared_ptr reference counting once the last snapshot holding them is gone.
+class SnapshotRTree {
+private:
+    int MAX_CHILDREN;
+    int MIN_CHILDREN;
+
+    std::shared_ptr<const RTreeSnapshot> current; // accessed via std::atomic_load/store
+    std::mutex writeMutex;
+
+    void insertRec(const SnapshotNode& node, const Point& point,
+                   std::shared_ptr<SnapshotNode>& copy, std::shared_ptr<SnapshotNode>& split) const;
+    SnapshotNodePtr insertIntoRoot(const SnapshotNodePtr& root, const Point& point) const;
+
+    bool removeRec(const SnapshotNode& node, const Point& point,
+                   std::shared_ptr<SnapshotNode>& copy, std::vector<Point>& orphanedPoints) const;
+
+    std::shared_ptr<SnapshotNode> splitNode(SnapshotNode& node) const;
+    void publish(SnapshotNodePtr root, size_t count);
+
+public:
+    explicit SnapshotRTree(int maxChildren);
+
+    RTreeSnapshot snapshot() const;
+
+    void insert(const Point& point);
+    void insertBatch(const std::vector<Point>& points);
+    bool remove(const Point& point);
+    void clear();
+};
+
+#endif
@@ -0,0 +1,95 @@
+#ifndef SPATIAL_INDEX_H
+#define SPATIAL_INDEX_H
+
+#include "visit.h"
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Common interface of the point indexes (KDIndex, RTree), so the CLI, the
+// analytics and the REST server can use either engine interchangeably.
+//
+// Index requirements:
+//   using value_type = T;                      // record with latitude/longitude
+//   void build(std::vector<T> items);          // replace the contents
+//   const T* nearest(double lat, double lon, double& dist) const;
+//                                              // nullptr (dist = max) when empty
+//   std::vector<Neighbor<T>> kNearest(double lat, double lon, size_t k) const;
+//                                              // closest first
+//   bool range(double latMin, double latMax, double lonMin, double lonMax, F&& onHit) const;
+//   bool radius(double lat, double lon, double r, F&& onHit) const;
+//                                              // onHit(const T&) may return Visit::Stop;
+//                                              // false if the visitor stopped
+//   size_t count(double latMin, double latMax, double lonMin, double lonMax) const;
+//   size_t size() const;
+//
+// Optional, where nodes keep a score bound (KDIndex with a suitable Summary,
+// RTree by spatial score):
+//   std::vector<Ranked<T>> topKInRange(latMin, latMax, lonMin, lonMax, k, ...) const;
+//                                              // highest score first
+//
+// Boxes are inclusive on every edge. Distances are Euclidean in degrees, as
+// in the rest of the core.
+
+template <typename T>
+struct Neighbor {
+    const T* item;
+    double dist;
+};
+
+template <typename T>
+struct Ranked {
+    const T* item;
+    double score;
+};
+
+template <typename T>
+using VisitorPtr = void (*)(const T&);
+
+// Accepts every item; the default of the filtered (`keep`) query overloads
+struct KeepAll {
+    template <typename T>
+    bool operator()(const T&) const { return true; }
+};
+
+template <typename Index, typename = void>
+struct IsSpatialIndex : std::false_type {};
+
+template <typename Index>
+struct IsSpatialIndex<Index, std::void_t<
+    decltype(std::declval<Index&>().build(std::declval<std::vector<typename Index::value_type>>())),
+    decltype(std::declval<const Index&>().nearest(0.0, 0.0, std::declval<double&>())),
+    decltype(std::declval<const Index&>().kNearest(0.0, 0.0, std::size_t())),
+    decltype(std::declval<const Index&>().range(0.0, 0.0, 0.0, 0.0,
+                                                VisitorPtr<typename Index::value_type>())),
+    decltype(std::declval<const Index&>().radius(0.0, 0.0, 0.0,
+                                                 VisitorPtr<typename Index::value_type>())),
+    decltype(std::declval<const Index&>().count(0.0, 0.0, 0.0, 0.0)),
+    decltype(std::declval<const Index&>().size())>>
+    : std::bool_constant<
+          std::is_same_v<decltype(std::declval<const Index&>().nearest(0.0, 0.0, std::declval<double&>())),
+                         const typename Index::value_type*> &&
+          std::is_same_v<decltype(std::declval<const Index&>().kNearest(0.0, 0.0, std::size_t())),
+                         std::vector<Neighbor<typename Index::value_type>>>> {};
+
+template <typename Index>
+inline constexpr bool isSpatialIndex = IsSpatialIndex<Index>::value;
+
+// Passes hits offset .. offset+limit-1 of a range query to emit(item) and
+// sets `count` to how many were passed. Returns false if more hits remained.
+template <typename Index, typename F>
+bool rangePage(const Index& index, double latMin, double latMax, double lonMin, double lonMax,
+               size_t offset, size_t limit, size_t& count, F&& emit) {
+    size_t seen = 0;
+    count = 0;
+    return index.range(latMin, latMax, lonMin, lonMax, [&](const typename Index::value_type& item) {
+        if (seen++ < offset) return Visit::Continue;
+        if (count == limit) return Visit::Stop;
+        emit(item);
+        count++;
+        return Visit::Continue;
+    });
+}
+
+#endif
@@ -0,0 +1,61 @@
+#include "interval_tree.h"
+#include <algorithm>
+
+// ----------------------------------------------------
+// Construction
+// ----------------------------------------------------
+
+void IntervalTree::build(const std::vector<std::pair<int, int>>& intervals) {
+    nodes.clear();
+    byStart.clear();
+    byEnd.clear();
+
+    std::vector<YearInterval> items;
+    items.reserve(intervals.size());
+    for (size_t i = 0; i < intervals.size(); i++) {
+        if (intervals[i].second < intervals[i].first) continue;
+        items.push_back({intervals[i].first, intervals[i].second, static_cast<uint32_t>(i)});
+    }
+    byStart.reserve(items.size());
+    byEnd.reserve(items.size());
+    root = build(items);
+}
+
+int32_t IntervalTree::build(std::vector<YearInterval>& items) {
+    if (items.empty()) return -1;
+
+    // Median endpoint: at most half of the intervals lie wholly on either side
+    std::vector<int> endpoints;
+    endpoints.reserve(items.size() * 2);
+    for (const auto& it : items) {
+        endpoints.push_back(it.start);
+        endpoints.push_back(it.end);
+    }
+    auto mid = endpoints.begin() + endpoints.size() / 2;
+    std::nth_element(endpoints.begin(), mid, endpoints.end());
+    int center = *mid;
+
+    std::vector<YearInterval> left, right, here;
+    for (const auto& it : items) {
+        if (it.end < center) left.push_back(it);
+        else if (it.start > center) right.push_back(it);
+        else here.push_back(it);
+    }
+    items.clear();
+    items.shrink_to_fit();
+
+    auto n = static_cast<int32_t>(nodes.size());
+    uint32_t begin = static_cast<uint32_t>(byStart.size());
+    nodes.push_back({center, begin, static_cast<uint32_t>(begin + here.size())});
+
+    std::sort(here.begin(), here.end(), [](const YearInterval& a, const YearInterval& b) { return a.start < b.start; });
+    byStart.insert(byStart.end(), here.begin(), here.end());
+    std::sort(here.begin(), here.end(), [](const YearInterval& a, const YearInterval& b) { return a.end > b.end; });
+    byEnd.insert(byEnd.end(), here.begin(), here.end());
+
+    int32_t l = build(left);
+    int32_t r = build(right);
+    nodes[n].left = l;
+    nodes[n].right = r;
+    return n;
+}
@@ -0,0 +1,84 @@
+#ifndef INTERVAL_TREE_H
+#define INTERVAL_TREE_H
+
+#include "../visit.h"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Closed interval [start, end] and the position of the record it came from.
+struct YearInterval {
+    int start, end;
+    uint32_t pos;
+};
+
+// Static centered interval tree over closed integer intervals (years).
+//
+// Each node owns the intervals containing its center, stored twice: by
+// ascending start and by descending end. Intervals wholly left or right of
+// the center go to the children. Centers are endpoint medians, so the depth
+// is O(log n) and stab()/overlapping() cost O(log n + k): at every node on
+// the search path the scan stops at the first interval that misses.
+//
+// Nodes and interval lists live in flat arrays; a node's intervals are one
+// contiguous run of each.
+class IntervalTree {
+public:
+    // Replaces the contents; intervals with end < start are ignored
+    void build(const std::vector<std::pair<int, int>>& intervals);
+
+    // onHit(pos) for every interval containing `year`; may return Visit::Stop.
+    // Returns false if the visitor stopped.
+    template <typename F>
+    bool stab(int year, F&& onHit) const {
+        return overlapping(year, year, onHit);
+    }
+
+    // onHit(pos) for every interval sharing at least one year with [from, to]
+    template <typename F>
+    bool overlapping(int from, int to, F&& onHit) const {
+        int32_t n = root;
+        std::vector<int32_t> pending; // both sides when the query spans a center
+        while (true) {
+            while (n >= 0) {
+                const Node& node = nodes[n];
+                if (to < node.center) {
+                    for (uint32_t i = node.begin; i < node.end && byStart[i].start <= to; i++)
+                        if (invokeVisitor(onHit, byStart[i].pos) == Visit::Stop) return false;
+                    n = node.left;
+                } else if (from > node.center) {
+                    for (uint32_t i = node.begin; i < node.end && byEnd[i].end >= from; i++)
+                        if (invokeVisitor(onHit, byEnd[i].pos) == Visit::Stop) return false;
+                    n = node.right;
+                } else {
+                    for (uint32_t i = node.begin; i < node.end; i++)
+                        if (invokeVisitor(onHit, byStart[i].pos) == Visit::Stop) return false;
+                    if (node.right >= 0) pending.push_back(node.right);
+                    n = node.left;
+                }
+            }
+            if (pending.empty()) return true;
+            n = pending.back();
+            pending.pop_back();
+        }
+    }
+
+    size_t size() const { return byStart.size(); }
+
+private:
+    struct Node {
+        int center;
+        uint32_t begin, end;       // run in byStart / byEnd
+        int32_t left = -1, right = -1;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<YearInterval> byStart; // per node: ascending start
+    std::vector<YearInterval> byEnd;   // per node: descending end
+    int32_t root = -1;
+
+    int32_t build(std::vector<YearInterval>& items);
+};
+
+#endif
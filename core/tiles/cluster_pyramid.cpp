@@ -0,0 +1,147 @@
+#include "cluster_pyramid.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const double PI = 3.14159265358979323846;
+const double MERCATOR_LAT_LIMIT = 85.0511287798066;
+const int FINE_BITS = ClusterPyramid::MAX_ZOOM + ClusterPyramid::CELL_BITS;
+
+// Spreads the low 32 bits of v to the even bit positions
+uint64_t spreadBits(uint64_t v) {
+    v &= 0xFFFFFFFFull;
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8))  & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4))  & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2))  & 0x3333333333333333ull;
+    v = (v | (v << 1))  & 0x5555555555555555ull;
+    return v;
+}
+
+uint64_t morton(uint32_t x, uint32_t y) { return spreadBits(x) | (spreadBits(y) << 1); }
+
+// Inverse of spreadBits: gathers the even bits of v
+uint32_t compactBits(uint64_t v) {
+    v &= 0x5555555555555555ull;
+    v = (v | (v >> 1))  & 0x3333333333333333ull;
+    v = (v | (v >> 2))  & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v >> 4))  & 0x00FF00FF00FF00FFull;
+    v = (v | (v >> 8))  & 0x0000FFFF0000FFFFull;
+    v = (v | (v >> 16)) & 0x00000000FFFFFFFFull;
+    return static_cast<uint32_t>(v);
+}
+
+// Cell column/row of (lat, lon) on a 2^bits x 2^bits Mercator grid. Scaling
+// by a power of two is exact, so the cell at a coarser grid is always the
+// finer cell shifted right.
+std::pair<uint32_t, uint32_t> gridCell(double lat, double lon, int bits) {
+    double n = std::ldexp(1.0, bits);
+    double lim = n - 1;
+    double fx = (lon + 180.0) / 360.0;
+    double latRad = std::clamp(lat, -MERCATOR_LAT_LIMIT, MERCATOR_LAT_LIMIT) * PI / 180.0;
+    double fy = (1.0 - std::asinh(std::tan(latRad)) / PI) / 2.0;
+    double x = std::clamp(std::floor(fx * n), 0.0, lim);
+    double y = std::clamp(std::floor(fy * n), 0.0, lim);
+    return {static_cast<uint32_t>(x), static_cast<uint32_t>(y)};
+}
+
+// Merges neighbouring clusters whose codes agree above `shift` bits
+std::vector<TileCluster> coarsen(const std::vector<TileCluster>& level, int shift) {
+    std::vector<TileCluster> out;
+    for (const auto& c : level) {
+        if (!out.empty() && (out.back().code >> shift) == (c.code >> shift)) {
+            TileCluster& into = out.back();
+            into.count += c.count;
+            into.latSum += c.latSum;
+            into.lonSum += c.lonSum;
+        } else {
+            out.push_back(c);
+        }
+    }
+    return out;
+}
+
+}
+
+// ----------------------------------------------------
+// Construction
+// ----------------------------------------------------
+
+void ClusterPyramid::build(const std::vector<std::pair<double, double>>& latLons, double maxFraction) {
+    levels.clear();
+    if (latLons.empty()) return;
+
+    std::vector<std::pair<uint64_t, uint32_t>> order(latLons.size());
+    for (size_t i = 0; i < latLons.size(); ++i)
+        order[i] = {cellCode(latLons[i].first, latLons[i].second), static_cast<uint32_t>(i)};
+    std::sort(order.begin(), order.end());
+
+    std::vector<TileCluster> level;
+    for (const auto& [code, i] : order) {
+        if (!level.empty() && level.back().code == code) {
+            level.back().count++;
+            level.back().latSum += latLons[i].first;
+            level.back().lonSum += latLons[i].second;
+        } else {
+            level.push_back({code, 1, i, latLons[i].first, latLons[i].second});
+        }
+    }
+
+    // Walk up from the finest zoom; the first level that clusters enough
+    // becomes the top, and every coarser one is kept below it
+    double limit = maxFraction * latLons.size();
+    for (int z = MAX_ZOOM; z >= 0; --z) {
+        if (z < MAX_ZOOM) level = coarsen(level, cellShift(z));
+        if (levels.empty() && level.size() >= limit) continue;
+        if (levels.empty()) levels.resize(z + 1);
+        levels[z] = level;
+    }
+}
+
+// ----------------------------------------------------
+// Queries
+// ----------------------------------------------------
+
+std::pair<const TileCluster*, const TileCluster*> ClusterPyramid::tile(int z, uint32_t x, uint32_t y) const {
+    if (z < 0 || z > topZoom() || !validTile(z, x, y)) return {nullptr, nullptr};
+    const auto& level = levels[z];
+    int shift = 2 * (MAX_ZOOM - z + CELL_BITS);
+    uint64_t lo = morton(x, y) << shift;
+    uint64_t hi = (morton(x, y) + 1) << shift;
+    auto byCode = [](const TileCluster& c, uint64_t code) { return c.code < code; };
+    auto first = std::lower_bound(level.begin(), level.end(), lo, byCode);
+    auto last = std::lower_bound(first, level.end(), hi, byCode);
+    return {level.data() + (first - level.begin()), level.data() + (last - level.begin())};
+}
+
+size_t ClusterPyramid::clusterCount() const {
+    size_t total = 0;
+    for (const auto& level : levels) total += level.size();
+    return total;
+}
+
+TileBox ClusterPyramid::tileBounds(int z, uint32_t x, uint32_t y) {
+    double n = std::ldexp(1.0, z);
+    auto latAt = [n](double row) { return std::atan(std::sinh(PI * (1.0 - 2.0 * row / n))) * 180.0 / PI; };
+    return {latAt(y + 1.0), latAt(y), x / n * 360.0 - 180.0, (x + 1.0) / n * 360.0 - 180.0};
+}
+
+std::pair<uint32_t, uint32_t> ClusterPyramid::tileOf(double lat, double lon, int z) {
+    return gridCell(lat, lon, z);
+}
+
+uint64_t ClusterPyramid::cellCode(double lat, double lon) {
+    auto cell = gridCell(lat, lon, FINE_BITS);
+    return morton(cell.first, cell.second);
+}
+
+TileBox ClusterPyramid::cellBounds(int z, uint64_t code) {
+    int bits = z + CELL_BITS;
+    uint64_t cell = code >> cellShift(z);
+    uint32_t x = compactBits(cell), y = compactBits(cell >> 1);
+    TileBox box = tileBounds(bits, x, y);
+    if (y == 0) box.latMax = 90;
+    if (y == (1u << bits) - 1) box.latMin = -90;
+    return box;
+}
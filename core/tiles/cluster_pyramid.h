@@ -0,0 +1,76 @@
+#ifndef CLUSTER_PYRAMID_H
+#define CLUSTER_PYRAMID_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Web-Mercator tile z/x/y and its latitude/longitude box.
+struct TileBox {
+    double latMin, latMax, lonMin, lonMax;
+};
+
+// Points merged into one grid cell of a tile.
+struct TileCluster {
+    uint64_t code;    // Morton code of the finest cell holding the first member
+    uint32_t count;
+    uint32_t first;   // input position of the first member (in code order)
+    double latSum, lonSum;
+
+    double lat() const { return latSum / count; }
+    double lon() const { return lonSum / count; }
+};
+
+// Per-zoom grid clustering of points for slippy-map tiles.
+//
+// Each tile is cut into CELLS x CELLS cells and every non-empty cell becomes
+// one cluster with its count and centroid. Points are sorted once by the
+// Morton code of their finest cell; a cell at any coarser zoom is then a
+// code prefix, so each level is a linear merge of the one below and the
+// clusters of one tile are a contiguous run found by binary search.
+//
+// Levels are kept from zoom 0 up to topZoom(), the deepest zoom at which
+// clustering still merges a meaningful share of the points. Deeper tiles
+// are sparse enough to be answered with raw points from a range query.
+class ClusterPyramid {
+public:
+    static const int MAX_ZOOM = 18;
+    static const int CELL_BITS = 3; // 8 x 8 clusters per tile at most
+    static const int CELLS = 1 << CELL_BITS;
+
+    // `maxFraction`: a level is kept only while it has fewer clusters than
+    // this fraction of the points.
+    void build(const std::vector<std::pair<double, double>>& latLons, double maxFraction = 0.75);
+
+    // Deepest clustered zoom, or -1 when no level is worth keeping
+    int topZoom() const { return (int)levels.size() - 1; }
+
+    // Clusters of tile z/x/y (z <= topZoom()), in Morton order
+    std::pair<const TileCluster*, const TileCluster*> tile(int z, uint32_t x, uint32_t y) const;
+
+    size_t clusterCount() const;
+
+    static bool validTile(int z, uint32_t x, uint32_t y) {
+        return z >= 0 && z <= MAX_ZOOM && x < (1u << z) && y < (1u << z);
+    }
+    static TileBox tileBounds(int z, uint32_t x, uint32_t y);
+
+    // Tile column/row holding (lat, lon) at zoom z; latitudes beyond the
+    // Mercator limit fall in the edge rows.
+    static std::pair<uint32_t, uint32_t> tileOf(double lat, double lon, int z);
+
+    // Morton code of the finest cell holding (lat, lon), as in TileCluster::code.
+    // Two points share a zoom-z cluster when their codes agree above
+    // cellShift(z) bits.
+    static uint64_t cellCode(double lat, double lon);
+    static int cellShift(int z) { return 2 * (MAX_ZOOM - z); }
+
+    // Box of the zoom-z cluster cell holding `code`; edge rows reach the poles
+    static TileBox cellBounds(int z, uint64_t code);
+
+private:
+    std::vector<std::vector<TileCluster>> levels; // index = zoom
+};
+
+#endif
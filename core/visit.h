@@ -0,0 +1,22 @@
+#ifndef VISIT_H
+#define VISIT_H
+
+#include <type_traits>
+#include <utility>
+
+// Result of a query visitor callback: keep traversing or abort the whole query.
+enum class Visit { Continue, Stop };
+
+// Calls a visitor and normalises its result. Callbacks may return Visit, or
+// nothing at all when they never stop early.
+template <typename F, typename... Args>
+inline Visit invokeVisitor(F& onHit, Args&&... args) {
+    if constexpr (std::is_void_v<std::invoke_result_t<F&, Args&&...>>) {
+        onHit(std::forward<Args>(args)...);
+        return Visit::Continue;
+    } else {
+        return onHit(std::forward<Args>(args)...);
+    }
+}
+
+#endif
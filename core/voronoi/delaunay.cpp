@@ -0,0 +1,542 @@
+#include "delaunay.h"
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <limits>
+
+namespace {
+
+const uint32_t NONE = std::numeric_limits<uint32_t>::max();
+
+using Pt = std::pair<double, double>;
+
+// ----------------------------------------------------
+// Robust predicates
+// ----------------------------------------------------
+//
+// Evaluated in doubles first. When the result is within the rounding error
+// bound (Shewchuk's static filters), the sign is recomputed exactly on
+// expansions: sums of non-overlapping doubles in increasing magnitude,
+// whose sign is that of the last term. Only near-degenerate input (grids,
+// cocircular or collinear points) ever reaches the exact path.
+
+const double EPS = std::ldexp(1.0, -53);
+const double ORIENT_BOUND = (3.0 + 16.0 * EPS) * EPS;
+const double INCIRCLE_BOUND = (10.0 + 96.0 * EPS) * EPS;
+
+using Expansion = std::vector<double>;
+
+// Adds b to e exactly (Grow-Expansion with zero elimination)
+void grow(Expansion& e, double b) {
+    size_t out = 0;
+    double q = b;
+    for (double ei : e) {
+        double sum = q + ei;
+        double bv = sum - q;
+        double err = (q - (sum - bv)) + (ei - bv);
+        if (err != 0) e[out++] = err;
+        q = sum;
+    }
+    e.resize(out);
+    if (q != 0) e.push_back(q);
+}
+
+Expansion difference(double a, double b) {
+    Expansion e;
+    grow(e, a);
+    grow(e, -b);
+    return e;
+}
+
+Expansion product(const Expansion& e, const Expansion& f) {
+    Expansion out;
+    for (double x : e)
+        for (double y : f) {
+            double p = x * y;
+            grow(out, std::fma(x, y, -p)); // exact low part of x * y
+            grow(out, p);
+        }
+    return out;
+}
+
+Expansion sum(Expansion e, const Expansion& f, double sign = 1) {
+    for (double x : f) grow(e, sign * x);
+    return e;
+}
+
+double sign(const Expansion& e) { return e.empty() ? 0 : e.back(); }
+
+// > 0 when a, b, c turn counter-clockwise, 0 when collinear
+double orient(const Pt& a, const Pt& b, const Pt& c) {
+    double left = (a.first - c.first) * (b.second - c.second);
+    double right = (a.second - c.second) * (b.first - c.first);
+    double det = left - right;
+    if (std::abs(det) > ORIENT_BOUND * (std::abs(left) + std::abs(right))) return det;
+
+    Expansion acx = difference(a.first, c.first), bcy = difference(b.second, c.second);
+    Expansion acy = difference(a.second, c.second), bcx = difference(b.first, c.first);
+    return sign(sum(product(acx, bcy), product(acy, bcx), -1));
+}
+
+// > 0 when d is strictly inside the circumcircle of counter-clockwise a, b, c
+double inCircle(const Pt& a, const Pt& b, const Pt& c, const Pt& d) {
+    double adx = a.first - d.first, ady = a.second - d.second;
+    double bdx = b.first - d.first, bdy = b.second - d.second;
+    double cdx = c.first - d.first, cdy = c.second - d.second;
+    double alift = adx * adx + ady * ady, blift = bdx * bdx + bdy * bdy, clift = cdx * cdx + cdy * cdy;
+    double det = alift * (bdx * cdy - bdy * cdx) + blift * (cdx * ady - cdy * adx) + clift * (adx * bdy - ady * bdx);
+    double permanent = (std::abs(bdx * cdy) + std::abs(bdy * cdx)) * alift
+                     + (std::abs(cdx * ady) + std::abs(cdy * adx)) * blift
+                     + (std::abs(adx * bdy) + std::abs(ady * bdx)) * clift;
+    if (std::abs(det) > INCIRCLE_BOUND * permanent) return det;
+
+    Expansion ax = difference(a.first, d.first), ay = difference(a.second, d.second);
+    Expansion bx = difference(b.first, d.first), by = difference(b.second, d.second);
+    Expansion cx = difference(c.first, d.first), cy = difference(c.second, d.second);
+    Expansion al = sum(product(ax, ax), product(ay, ay));
+    Expansion bl = sum(product(bx, bx), product(by, by));
+    Expansion cl = sum(product(cx, cx), product(cy, cy));
+    Expansion bc = sum(product(bx, cy), product(by, cx), -1);
+    Expansion ca = sum(product(cx, ay), product(cy, ax), -1);
+    Expansion ab = sum(product(ax, by), product(ay, bx), -1);
+    return sign(sum(sum(product(al, bc), product(bl, ca)), product(cl, ab)));
+}
+
+// < 0 when q lies strictly between a and b (q on the line through them)
+double betweenSign(const Pt& a, const Pt& b, const Pt& q) {
+    Expansion dot = sum(product(difference(q.first, a.first), difference(q.first, b.first)),
+                        product(difference(q.second, a.second), difference(q.second, b.second)));
+    return sign(dot);
+}
+
+uint32_t spreadBits(uint32_t v) {
+    v &= 0xFFFF;
+    v = (v | (v << 8)) & 0x00FF00FF;
+    v = (v | (v << 4)) & 0x0F0F0F0F;
+    v = (v | (v << 2)) & 0x33333333;
+    v = (v | (v << 1)) & 0x55555555;
+    return v;
+}
+
+// Bowyer-Watson insertion over ghost triangles. A ghost (a, b, inf) sits on
+// hull edge a->b with the outside to its left; a point conflicts with it
+// when it lies outside that edge, the limit of a circumcircle through a
+// vertex at infinity.
+class Triangulator {
+public:
+    struct Tri {
+        uint32_t v[3]; // counter-clockwise; a ghost has inf at v[2]
+        uint32_t n[3]; // n[i] is across the edge opposite v[i]
+        bool dead = false;
+    };
+
+    std::vector<Tri> tris;
+    bool broken = false;
+
+    Triangulator(const std::vector<Pt>& pts) : pts(pts), inf((uint32_t)pts.size()),
+                                                startOf(pts.size() + 1, NONE) {}
+
+    // First three points must not be collinear
+    void run(const std::vector<uint32_t>& order) {
+        init(order[0], order[1], order[2]);
+        for (size_t i = 3; i < order.size() && !broken; i++) insert(order[i]);
+    }
+
+    // Checks the result independently of how it was built: every triangle
+    // counter-clockwise, no vertex strictly inside the circumcircle of the
+    // triangle across an edge, and a convex hull. Locally Delaunay
+    // everywhere means Delaunay, which is what makes the greedy walk exact.
+    bool verify() const {
+        for (uint32_t t = 0; t < tris.size(); t++) {
+            const Tri& T = tris[t];
+            if (T.dead) continue;
+            if (T.v[2] == inf) {
+                // Next hull edge b -> c must not turn outward
+                const Tri& next = tris[T.n[0]];
+                if (next.v[2] != inf || next.v[0] != T.v[1]) return false;
+                if (orient(pts[T.v[0]], pts[T.v[1]], pts[next.v[1]]) > 0) return false;
+                continue;
+            }
+            if (orient(pts[T.v[0]], pts[T.v[1]], pts[T.v[2]]) <= 0) return false;
+            for (int e = 0; e < 3; e++) {
+                uint32_t nb = T.n[e];
+                if (nb == NONE || tris[nb].dead) return false;
+                if (tris[nb].v[2] == inf) continue;
+                int j = slotOpposite(nb, T.v[(e + 1) % 3], T.v[(e + 2) % 3]);
+                if (j < 0) return false;
+                if (inCircle(pts[T.v[0]], pts[T.v[1]], pts[T.v[2]], pts[tris[nb].v[j]]) > 0) return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Edge {
+        uint32_t a, b, outside;
+    };
+
+    const std::vector<Pt>& pts;
+    uint32_t inf;
+    uint32_t last = 0;
+    std::vector<uint32_t> freeTris, cavity, mark;
+    std::vector<Edge> boundary;
+    std::vector<uint32_t> created;
+    std::vector<uint32_t> startOf; // new triangle whose cavity edge starts at a vertex
+    uint32_t stamp = 0;
+
+    uint32_t alloc() {
+        if (!freeTris.empty()) {
+            uint32_t t = freeTris.back();
+            freeTris.pop_back();
+            tris[t].dead = false;
+            return t;
+        }
+        tris.emplace_back();
+        mark.push_back(0);
+        return (uint32_t)tris.size() - 1;
+    }
+
+    // Rotated so that inf, if present, is last
+    void setVertices(uint32_t t, uint32_t a, uint32_t b, uint32_t c) {
+        uint32_t* v = tris[t].v;
+        if (a == inf)      { v[0] = b; v[1] = c; v[2] = a; }
+        else if (b == inf) { v[0] = c; v[1] = a; v[2] = b; }
+        else               { v[0] = a; v[1] = b; v[2] = c; }
+        tris[t].n[0] = tris[t].n[1] = tris[t].n[2] = NONE;
+    }
+
+    int slotOpposite(uint32_t t, uint32_t x, uint32_t y) const {
+        const uint32_t* v = tris[t].v;
+        for (int i = 0; i < 3; i++)
+            if (v[i] != x && v[i] != y) return i;
+        return -1;
+    }
+
+    // Makes t and u neighbors across their shared edge x-y
+    void link(uint32_t t, uint32_t u, uint32_t x, uint32_t y) {
+        int i = slotOpposite(t, x, y), j = slotOpposite(u, x, y);
+        if (i < 0 || j < 0) { broken = true; return; }
+        tris[t].n[i] = u;
+        tris[u].n[j] = t;
+    }
+
+    bool conflicts(uint32_t t, uint32_t p) const {
+        const Tri& T = tris[t];
+        const Pt& q = pts[p];
+        if (T.v[2] == inf) {
+            const Pt& a = pts[T.v[0]];
+            const Pt& b = pts[T.v[1]];
+            double o = orient(a, b, q);
+            if (o != 0) return o > 0;
+            // On the hull line: only inside the edge itself
+            return betweenSign(a, b, q) < 0;
+        }
+        return inCircle(pts[T.v[0]], pts[T.v[1]], pts[T.v[2]], q) > 0;
+    }
+
+    void init(uint32_t a, uint32_t b, uint32_t c) {
+        if (orient(pts[a], pts[b], pts[c]) < 0) std::swap(b, c);
+        uint32_t ids[4];
+        for (auto& id : ids) id = alloc();
+        setVertices(ids[0], a, b, c);
+        setVertices(ids[1], c, b, inf); // ghosts on the reversed hull edges
+        setVertices(ids[2], a, c, inf);
+        setVertices(ids[3], b, a, inf);
+        for (int i = 0; i < 4; i++)
+            for (int j = i + 1; j < 4; j++) {
+                const uint32_t* u = tris[ids[i]].v;
+                const uint32_t* w = tris[ids[j]].v;
+                uint32_t shared[3];
+                int k = 0;
+                for (int x = 0; x < 3; x++)
+                    if (std::find(w, w + 3, u[x]) != w + 3) shared[k++] = u[x];
+                if (k == 2) link(ids[i], ids[j], shared[0], shared[1]);
+            }
+        last = ids[0];
+    }
+
+    // Visibility walk from the last triangle created; falls back to a scan
+    // if rounding sends it in circles
+    uint32_t locate(uint32_t p) {
+        const Pt& q = pts[p];
+        uint32_t t = last;
+        for (size_t steps = 0; steps <= tris.size(); steps++) {
+            const Tri& T = tris[t];
+            if (T.v[2] == inf) {
+                if (conflicts(t, p)) return t;
+                t = T.n[2]; // step inside the hull
+                continue;
+            }
+            uint32_t next = NONE;
+            for (int k = 0; k < 3 && next == NONE; k++) {
+                int e = (int)((k + steps) % 3);
+                if (orient(pts[T.v[(e + 1) % 3]], pts[T.v[(e + 2) % 3]], q) < 0) next = T.n[e];
+            }
+            if (next == NONE) return t;
+            t = next;
+        }
+        for (uint32_t i = 0; i < tris.size(); i++)
+            if (!tris[i].dead && conflicts(i, p)) return i;
+        broken = true;
+        return t;
+    }
+
+    void insert(uint32_t p) {
+        uint32_t start = locate(p);
+        if (broken) return;
+
+        // Cavity: connected triangles whose circumcircle holds p. An edge p
+        // can't see (possible only through rounding) is never left on its
+        // border, so the new triangles are all counter-clockwise.
+        stamp++;
+        cavity.assign(1, start);
+        mark[start] = stamp;
+        for (size_t i = 0; i < cavity.size(); i++) {
+            uint32_t t = cavity[i];
+            for (int e = 0; e < 3; e++) {
+                uint32_t nb = tris[t].n[e];
+                if (mark[nb] == stamp) continue;
+                uint32_t a = tris[t].v[(e + 1) % 3], b = tris[t].v[(e + 2) % 3];
+                bool visible = a == inf || b == inf || orient(pts[a], pts[b], pts[p]) > 0;
+                if (!visible || conflicts(nb, p)) {
+                    mark[nb] = stamp;
+                    cavity.push_back(nb);
+                }
+            }
+        }
+
+        boundary.clear();
+        for (uint32_t t : cavity) {
+            for (int e = 0; e < 3; e++)
+                if (mark[tris[t].n[e]] != stamp)
+                    boundary.push_back({tris[t].v[(e + 1) % 3], tris[t].v[(e + 2) % 3], tris[t].n[e]});
+            tris[t].dead = true;
+            freeTris.push_back(t);
+        }
+
+        // Fan from p over the cavity border; neighbours across the fan
+        // edges meet through startOf
+        created.clear();
+        for (const Edge& e : boundary) {
+            uint32_t t = alloc();
+            setVertices(t, e.a, e.b, p);
+            link(t, e.outside, e.a, e.b);
+            startOf[e.a] = t;
+            created.push_back(t);
+        }
+        for (size_t i = 0; i < boundary.size(); i++) {
+            uint32_t next = startOf[boundary[i].b];
+            if (next == NONE) { broken = true; break; }
+            link(created[i], next, boundary[i].b, p);
+        }
+        for (const Edge& e : boundary) startOf[e.a] = NONE;
+        last = created.back();
+    }
+};
+
+}
+
+// ----------------------------------------------------
+// Construction
+// ----------------------------------------------------
+
+void Delaunay::build(const std::vector<std::pair<double, double>>& latLons) {
+    sites.clear();
+    firstPos.clear();
+    siteOf.assign(latLons.size(), 0);
+    triangles.clear();
+    valid = true;
+
+    // Distinct points; the lowest position of a run of duplicates sorts first
+    std::vector<uint32_t> byCoord(latLons.size());
+    for (uint32_t i = 0; i < byCoord.size(); i++) byCoord[i] = i;
+    std::sort(byCoord.begin(), byCoord.end(), [&](uint32_t a, uint32_t b) {
+        return latLons[a] != latLons[b] ? latLons[a] < latLons[b] : a < b;
+    });
+    std::vector<uint32_t> distinct;
+    for (size_t i = 0; i < byCoord.size(); i++)
+        if (i == 0 || latLons[byCoord[i]] != latLons[byCoord[i - 1]]) distinct.push_back(byCoord[i]);
+
+    // Morton order keeps consecutive insertions close, so walks stay short
+    double latMin = 0, latMax = 0, lonMin = 0, lonMax = 0;
+    if (!distinct.empty()) {
+        latMin = latMax = latLons[distinct[0]].first;
+        lonMin = lonMax = latLons[distinct[0]].second;
+    }
+    for (uint32_t i : distinct) {
+        latMin = std::min(latMin, latLons[i].first);
+        latMax = std::max(latMax, latLons[i].first);
+        lonMin = std::min(lonMin, latLons[i].second);
+        lonMax = std::max(lonMax, latLons[i].second);
+    }
+    double latScale = latMax > latMin ? 65535.0 / (latMax - latMin) : 0;
+    double lonScale = lonMax > lonMin ? 65535.0 / (lonMax - lonMin) : 0;
+    std::vector<std::pair<uint32_t, uint32_t>> coded; // (code, index in distinct)
+    coded.reserve(distinct.size());
+    for (uint32_t k = 0; k < distinct.size(); k++) {
+        const auto& p = latLons[distinct[k]];
+        uint32_t x = (uint32_t)((p.first - latMin) * latScale);
+        uint32_t y = (uint32_t)((p.second - lonMin) * lonScale);
+        coded.push_back({spreadBits(x) | (spreadBits(y) << 1), k});
+    }
+    std::sort(coded.begin(), coded.end());
+    std::vector<uint32_t> siteOfDistinct(distinct.size());
+    for (const auto& c : coded) {
+        siteOfDistinct[c.second] = (uint32_t)sites.size();
+        sites.push_back(latLons[distinct[c.second]]);
+        firstPos.push_back(distinct[c.second]);
+    }
+    for (size_t i = 0, k = 0; i < byCoord.size(); i++) {
+        if (i > 0 && latLons[byCoord[i]] != latLons[byCoord[i - 1]]) k++;
+        siteOf[byCoord[i]] = siteOfDistinct[k];
+    }
+
+    size_t n = sites.size();
+    std::vector<std::vector<uint32_t>> edges(n);
+    onHull.assign(n, true);
+
+    // The first point off the line through the first two starts the mesh
+    size_t third = 2;
+    while (third < n && orient(sites[0], sites[1], sites[third]) == 0) third++;
+
+    if (third < n) {
+        std::vector<uint32_t> order(n);
+        for (uint32_t i = 0; i < n; i++) order[i] = i;
+        std::swap(order[2], order[third]);
+        Triangulator tr(sites);
+        tr.run(order);
+        valid = !tr.broken && tr.verify();
+
+        std::fill(onHull.begin(), onHull.end(), false);
+        for (const auto& t : tr.tris) {
+            if (t.dead) continue;
+            for (int i = 0; i < 3; i++) {
+                uint32_t a = t.v[i], b = t.v[(i + 1) % 3];
+                if (a < n && b < n) edges[a].push_back(b); // each direction once
+            }
+            if (t.v[2] == n) onHull[t.v[0]] = onHull[t.v[1]] = true;
+            else triangles.push_back({t.v[0], t.v[1], t.v[2]});
+        }
+    } else {
+        // All on one line: the Voronoi cells are slabs, neighbours in line order
+        std::vector<uint32_t> line(n);
+        for (uint32_t i = 0; i < n; i++) line[i] = i;
+        std::sort(line.begin(), line.end(), [&](uint32_t a, uint32_t b) { return sites[a] < sites[b]; });
+        for (size_t i = 1; i < n; i++) {
+            edges[line[i - 1]].push_back(line[i]);
+            edges[line[i]].push_back(line[i - 1]);
+        }
+    }
+
+    adjStart.assign(n + 1, 0);
+    adj.clear();
+    for (size_t s = 0; s < n; s++) {
+        if (n > 1 && edges[s].empty()) valid = false;
+        adj.insert(adj.end(), edges[s].begin(), edges[s].end());
+        adjStart[s + 1] = (uint32_t)adj.size();
+    }
+
+    triStart.assign(n + 1, 0);
+    for (const auto& t : triangles)
+        for (uint32_t v : t) triStart[v + 1]++;
+    for (size_t s = 0; s < n; s++) triStart[s + 1] += triStart[s];
+    triOf.resize(triStart[n]);
+    std::vector<uint32_t> fill(triStart.begin(), triStart.end() - 1);
+    for (uint32_t t = 0; t < triangles.size(); t++)
+        for (uint32_t v : triangles[t]) triOf[fill[v]++] = t;
+
+    buildSeedGrid();
+}
+
+void Delaunay::buildSeedGrid() {
+    size_t n = sites.size();
+    seeds.clear();
+    gridRows = gridCols = 0;
+    if (!n) return;
+
+    double latMin = sites[0].first, latMax = latMin, lonMin = sites[0].second, lonMax = lonMin;
+    for (const auto& s : sites) {
+        latMin = std::min(latMin, s.first);
+        latMax = std::max(latMax, s.first);
+        lonMin = std::min(lonMin, s.second);
+        lonMax = std::max(lonMax, s.second);
+    }
+    // About two sites per cell
+    uint32_t side = std::max<uint32_t>(1, (uint32_t)std::sqrt(n / 2.0));
+    gridRows = gridCols = side;
+    gridLat0 = latMin;
+    gridLon0 = lonMin;
+    cellLat = latMax > latMin ? (latMax - latMin) / side : 1;
+    cellLon = lonMax > lonMin ? (lonMax - lonMin) / side : 1;
+
+    seeds.assign((size_t)side * side, NONE);
+    std::deque<uint32_t> frontier;
+    for (uint32_t s = 0; s < n; s++) {
+        size_t c = cellOf(sites[s].first, sites[s].second);
+        if (seeds[c] == NONE) {
+            seeds[c] = s;
+            frontier.push_back(c);
+        }
+    }
+    // Breadth-first from the occupied cells
+    while (!frontier.empty()) {
+        uint32_t c = frontier.front();
+        frontier.pop_front();
+        uint32_t r = c / side, k = c % side;
+        uint32_t next[4] = {r > 0 ? c - side : NONE, r + 1 < side ? c + side : NONE,
+                            k > 0 ? c - 1 : NONE, k + 1 < side ? c + 1 : NONE};
+        for (uint32_t x : next)
+            if (x != NONE && seeds[x] == NONE) {
+                seeds[x] = seeds[c];
+                frontier.push_back(x);
+            }
+    }
+}
+
+// Queries outside the points' bounding box use the nearest border cell
+size_t Delaunay::cellOf(double lat, double lon) const {
+    double r = std::clamp(std::floor((lat - gridLat0) / cellLat), 0.0, (double)(gridRows - 1));
+    double c = std::clamp(std::floor((lon - gridLon0) / cellLon), 0.0, (double)(gridCols - 1));
+    if (std::isnan(r) || std::isnan(c)) return 0;
+    return (size_t)r * gridCols + (size_t)c;
+}
+
+// ----------------------------------------------------
+// Voronoi cells
+// ----------------------------------------------------
+
+std::vector<uint32_t> Delaunay::neighbors(uint32_t pos) const {
+    std::vector<uint32_t> out;
+    if (pos >= siteOf.size()) return out;
+    uint32_t s = siteOf[pos];
+    for (uint32_t i = adjStart[s]; i < adjStart[s + 1]; i++) out.push_back(firstPos[adj[i]]);
+    return out;
+}
+
+bool Delaunay::cell(uint32_t pos, std::vector<std::pair<double, double>>& out) const {
+    out.clear();
+    if (pos >= siteOf.size()) return false;
+    uint32_t s = siteOf[pos];
+    if (onHull[s]) return false;
+
+    const Pt& o = sites[s];
+    for (uint32_t i = triStart[s]; i < triStart[s + 1]; i++) {
+        const auto& t = triangles[triOf[i]];
+        const Pt& a = sites[t[0]];
+        const Pt& b = sites[t[1]];
+        const Pt& c = sites[t[2]];
+        double bx = b.first - a.first, by = b.second - a.second;
+        double cx = c.first - a.first, cy = c.second - a.second;
+        double d = 2 * (bx * cy - by * cx);
+        double b2 = bx * bx + by * by, c2 = cx * cx + cy * cy;
+        out.push_back({a.first + (cy * b2 - by * c2) / d, a.second + (bx * c2 - cx * b2) / d});
+    }
+    std::sort(out.begin(), out.end(), [&](const Pt& p, const Pt& q) {
+        return std::atan2(p.second - o.second, p.first - o.first) < std::atan2(q.second - o.second, q.first - o.first);
+    });
+    // Cocircular sites give several triangles the same circumcenter
+    out.erase(std::unique(out.begin(), out.end(), [](const Pt& p, const Pt& q) {
+        return std::abs(p.first - q.first) < 1e-9 && std::abs(p.second - q.second) < 1e-9;
+    }), out.end());
+    return true;
+}
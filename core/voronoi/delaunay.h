@@ -0,0 +1,96 @@
+#ifndef DELAUNAY_H
+#define DELAUNAY_H
+
+#include "../query_stats.h"
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Delaunay triangulation of a static point set, for exact nearest-site
+// lookups as point location in the Voronoi diagram.
+//
+// Built once by Bowyer-Watson insertion in Morton order with robust
+// orientation and incircle predicates, each point located by walking from
+// the last triangle created. The hull is closed with ghost
+// triangles sharing one vertex at infinity, so there is no super-triangle
+// whose corners would distort the edges near the hull.
+//
+// nearest() jumps to a seed site through a coarse grid, then walks greedily
+// along Delaunay edges toward the query. A site with no Delaunay neighbor
+// closer to the query is the nearest site, so the walk ends at the exact
+// answer. Delaunay neighbors are Voronoi neighbors, and the circumcenters
+// around a site are its Voronoi cell.
+//
+// Coordinates are planar (lat, lon) as in the KD-tree. Duplicate points are
+// one site, reported as the lowest input position.
+class Delaunay {
+public:
+    void build(const std::vector<std::pair<double, double>>& latLons);
+
+    // Input position of the point nearest to (lat, lon) and its distance,
+    // or -1 when empty.
+    template <typename Stats = NoStats>
+    long nearest(double lat, double lon, double& dist, Stats&& stats = Stats()) const {
+        if (sites.empty()) return -1;
+        uint32_t cur = seed(lat, lon);
+        double best = dist2(cur, lat, lon);
+        stats.node();
+        stats.distance();
+        while (true) {
+            uint32_t next = cur;
+            for (uint32_t i = adjStart[cur]; i < adjStart[cur + 1]; i++) {
+                double d = dist2(adj[i], lat, lon);
+                if (d < best) { best = d; next = adj[i]; }
+            }
+            stats.distance(adjStart[cur + 1] - adjStart[cur]);
+            if (next == cur) break;
+            cur = next;
+            stats.node();
+        }
+        dist = std::sqrt(best);
+        return firstPos[cur];
+    }
+
+    // Input positions of the Voronoi neighbors of the point at `pos`
+    std::vector<uint32_t> neighbors(uint32_t pos) const;
+
+    // Voronoi cell of the point at `pos`, counter-clockwise, as (lat, lon)
+    // vertices. False for the unbounded cells of hull points.
+    bool cell(uint32_t pos, std::vector<std::pair<double, double>>& out) const;
+
+    size_t size() const { return sites.size(); }
+    size_t triangleCount() const { return triangles.size(); }
+
+    // True once build() has checked the result is Delaunay (every edge
+    // locally Delaunay, convex hull, no point left without neighbors);
+    // only then is nearest() exact.
+    bool exact() const { return valid; }
+
+private:
+    std::vector<std::pair<double, double>> sites; // distinct points, Morton order
+    std::vector<uint32_t> firstPos;               // site -> lowest input position
+    std::vector<uint32_t> siteOf;                 // input position -> site
+    std::vector<uint32_t> adjStart, adj;          // Delaunay edges, CSR by site
+    std::vector<uint32_t> triStart, triOf;        // incident triangles, CSR by site
+    std::vector<std::array<uint32_t, 3>> triangles; // counter-clockwise
+    std::vector<bool> onHull;
+    bool valid = true;
+
+    // Seed grid: one nearby site per cell, empty cells filled from neighbours
+    double gridLat0 = 0, gridLon0 = 0, cellLat = 1, cellLon = 1;
+    uint32_t gridRows = 0, gridCols = 0;
+    std::vector<uint32_t> seeds;
+
+    double dist2(uint32_t s, double lat, double lon) const {
+        double dl = sites[s].first - lat, dn = sites[s].second - lon;
+        return dl * dl + dn * dn;
+    }
+    uint32_t seed(double lat, double lon) const { return seeds[cellOf(lat, lon)]; }
+    size_t cellOf(double lat, double lon) const;
+    void buildSeedGrid();
+};
+
+#endif
@@ -0,0 +1,73 @@
+#include "region_loader.h"
+#include <fstream>
+#include <sstream>
+#include <iostream>
+
+std::vector<RegionBox> loadRegions(const std::string& filename) {
+    std::vector<RegionBox> regions;
+    std::ifstream file(filename);
+
+    if (!file.is_open()) {
+        std::cout << "Error opening regions file " << filename << "\n";
+        return regions;
+    }
+
+    std::string line;
+    getline(file, line); // header
+
+    while (getline(file, line)) {
+        if (line.empty()) continue;
+        std::stringstream ss(line);
+        RegionBox r;
+        std::string temp;
+
+        getline(ss, r.label, ',');
+        getline(ss, temp, ','); r.latMin = stod(temp);
+        getline(ss, temp, ','); r.latMax = stod(temp);
+        getline(ss, temp, ','); r.lonMin = stod(temp);
+        getline(ss, temp, ','); r.lonMax = stod(temp);
+
+        regions.push_back(r);
+    }
+
+    file.close();
+    return regions;
+}
+
+std::vector<RegionPolygon> loadRegionPolygons(const std::string& filename) {
+    std::vector<RegionPolygon> regions;
+    std::ifstream file(filename);
+
+    if (!file.is_open()) {
+        std::cout << "Error opening regions file " << filename << "\n";
+        return regions;
+    }
+
+    std::string line;
+    getline(file, line); // header
+
+    while (getline(file, line)) {
+        if (line.empty()) continue;
+        std::stringstream ss(line);
+        RegionPolygon r;
+        std::string vertices, vertex;
+
+        getline(ss, r.label, ',');
+        getline(ss, vertices);
+
+        std::stringstream vs(vertices);
+        while (getline(vs, vertex, '|')) {
+            std::stringstream coords(vertex);
+            double lat, lon;
+            if (coords >> lat >> lon) {
+                r.lats.push_back(lat);
+                r.lons.push_back(lon);
+            }
+        }
+
+        if (r.lats.size() >= 3) regions.push_back(r);
+    }
+
+    file.close();
+    return regions;
+}
@@ -0,0 +1,15 @@
+#ifndef REGION_LOADER_H
+#define REGION_LOADER_H
+
+#include <vector>
+#include <string>
+#include "../core/regions/region_index.h"
+
+// Reads `region,lat_min,lat_max,lon_min,lon_max` rows. Returns an empty list
+// when the file cannot be opened so callers can fall back to built-in regions.
+std::vector<RegionBox> loadRegions(const std::string& filename);
+
+// Reads `region,vertices` rows where vertices is `lat lon|lat lon|...`.
+std::vector<RegionPolygon> loadRegionPolygons(const std::string& filename);
+
+#endif
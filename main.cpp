@@ -17,12 +17,17 @@ void displayMenu()
     std::cout << "  4. Performance Benchmark Results\n";
     std::cout << "  5. Exit System\n";
     std::cout << "  6. Run Spatial Scaling Stress Test\n";
+    std::cout << "  7. Run Snapshot Read Latency Test\n";
+    std::cout << "  8. Run Bulk Region Assignment Benchmark\n";
+    std::cout << "  9. Run R-Tree Update Benchmark\n";
     std::cout << "======================================================\n";
-    std::cout << "Select Operation Mode (1-6): ";
+    std::cout << "Select Operation Mode (1-9): ";
 }
 
 int main()
 {
+    // Interactive: log lines must not overtake the menu prompts
+    Logger::setSynchronous(true);
     Logger::info("Initializing Spatial Intelligence System...");
     Logger::info("Loading dataset components...");
     auto civs = loadCivilizations("data/final_dataset.csv");
@@ -148,6 +153,18 @@ int main()
         {
             runSpatialScalingTest();
         }
+        else if (choice == 7)
+        {
+            runSnapshotConcurrencyTest();
+        }
+        else if (choice == 8)
+        {
+            runRegionAssignmentBenchmark();
+        }
+        else if (choice == 9)
+        {
+            runRTreeUpdateBenchmark();
+        }
         else if (choice == 5)
         {
             Logger::info("Shutting down Spatial Intelligence System...");
@@ -2,7 +2,8 @@
 echo =======================================================
 echo Building Civilization Spatial Intelligence System
 echo =======================================================
-g++ -std=c++17 -Wall -O2 -o mapper.exe civilization_mapper.cpp
+set CORE_SRC=core\kd_tree.cpp core\rtree\rtree.cpp core\rtree\snapshot_rtree.cpp core\regions\region_index.cpp core\temporal\interval_tree.cpp core\tiles\cluster_pyramid.cpp core\voronoi\delaunay.cpp utils\logger.cpp data\csv_loader.cpp data\region_loader.cpp
+g++ -std=c++17 -Wall -O2 -o mapper.exe civilization_mapper.cpp utils\compress.cpp utils\metrics.cpp %CORE_SRC% -lws2_32
 if %errorlevel% neq 0 (
     echo [!] Compilation failed. Please check your g++ installation or errors above.
     pause
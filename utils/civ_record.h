@@ -0,0 +1,40 @@
+#pragma once
+#include "../core/civilization.h"
+#include "json_writer.h"
+#include <string>
+#include <utility>
+
+// Core record (core/civilization.h) plus JSON-escaped copies of the strings.
+// The REST server's record type; the JSON benchmark measures this writer.
+struct CivRecord : Civilization
+{
+    std::string nameJSON;
+    std::string regionJSON;
+
+    CivRecord() = default;
+    CivRecord(Civilization c) : Civilization(std::move(c)) {}
+
+    // Call once the record is final (after region assignment)
+    void prepareJSON()
+    {
+        nameJSON.clear();   JsonWriter::escapeTo(nameJSON, name);
+        regionJSON.clear(); JsonWriter::escapeTo(regionJSON, region);
+    }
+
+    // Serialize straight into the response buffer
+    void writeJSON(JsonWriter& w) const
+    {
+        w.raw("{\"id\":").number((long long)id)
+         .raw(",\"name\":\"").raw(nameJSON)
+         .raw("\",\"latitude\":").number(latitude, 4)
+         .raw(",\"longitude\":").number(longitude, 4)
+         .raw(",\"start_year\":").number(startYear)
+         .raw(",\"end_year\":").number(endYear)
+         .raw(",\"region\":\"").raw(regionJSON)
+         .raw("\",\"resource_density\":").number(resourceDensity, 4)
+         .raw(",\"knowledge_density\":").number(knowledgeDensity, 4)
+         .raw(",\"military_strength\":").number(militaryStrength, 4)
+         .raw(",\"spatial_score\":").number(spatialScore(), 2)
+         .raw('}');
+    }
+};
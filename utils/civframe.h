@@ -0,0 +1,187 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Columnar binary frame served as "application/x-civframe".
+//
+// Layout, all integers little-endian:
+//
+//   offset 0   "CIVF"                 magic
+//          4   u8  version            (1)
+//          5   u8  flags              (bit 0: result truncated)
+//          6   u8  f64 column count   F
+//          7   u8  varint column count V
+//          8   u32 row count          N
+//         12   u32 dictionary size    D
+//         16   F columns of N float64 each; offsets are multiples of 8, so
+//              a column can be memcpy'd (or mapped) straight into a double[]
+//              V columns of N LEB128 varints each (signed values zigzag-encoded)
+//              D dictionary strings, each a varint byte length + UTF-8 bytes
+//
+// The column order is defined by the endpoint; strings are sent as varint
+// indexes into the dictionary.
+namespace CivFrame
+{
+    const uint8_t VERSION = 1;
+    const uint8_t FLAG_TRUNCATED = 1;
+    const size_t  HEADER_SIZE = 16;
+
+    inline uint64_t zigzag(int64_t v) { return (static_cast<uint64_t>(v) << 1) ^ static_cast<uint64_t>(v >> 63); }
+    inline int64_t unzigzag(uint64_t v) { return static_cast<int64_t>(v >> 1) ^ -static_cast<int64_t>(v & 1); }
+
+    inline void putVarint(std::string& out, uint64_t v)
+    {
+        while (v >= 0x80)
+        {
+            out.push_back(static_cast<char>(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back(static_cast<char>(v));
+    }
+
+    inline void putLE(std::string& out, uint64_t v, int bytes)
+    {
+        for (int i = 0; i < bytes; i++) out.push_back(static_cast<char>(v >> (8 * i)));
+    }
+
+    // Throws std::runtime_error on a truncated or over-long varint
+    inline uint64_t getVarint(const uint8_t*& p, const uint8_t* end)
+    {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7)
+        {
+            if (p == end) throw std::runtime_error("civframe: truncated varint");
+            uint8_t b = *p++;
+            v |= static_cast<uint64_t>(b & 0x7F) << shift;
+            if (!(b & 0x80)) return v;
+        }
+        throw std::runtime_error("civframe: varint too long");
+    }
+}
+
+// Accumulates one frame column by column; finish() lays it out.
+class CivFrameBuilder
+{
+public:
+    CivFrameBuilder(size_t f64Columns, size_t varintColumns)
+        : f64Cols(f64Columns), varintCols(varintColumns) {}
+
+    void reserve(size_t rows)
+    {
+        for (auto& c : f64Cols) c.reserve(rows);
+        for (auto& c : varintCols) c.reserve(rows * 2);
+    }
+
+    void f64(size_t column, double v) { f64Cols[column].push_back(v); }
+    void uvarint(size_t column, uint64_t v) { CivFrame::putVarint(varintCols[column], v); }
+    void svarint(size_t column, int64_t v) { CivFrame::putVarint(varintCols[column], CivFrame::zigzag(v)); }
+
+    // Dictionary index of `s`, adding it on first use
+    uint32_t intern(const std::string& s)
+    {
+        auto it = dictIndex.find(s);
+        if (it != dictIndex.end()) return it->second;
+        uint32_t id = static_cast<uint32_t>(dict.size());
+        dict.push_back(s);
+        dictIndex.emplace(s, id);
+        return id;
+    }
+
+    std::string finish(uint32_t rows, uint8_t flags = 0) const
+    {
+        std::string out;
+        out.append("CIVF", 4);
+        out.push_back(static_cast<char>(CivFrame::VERSION));
+        out.push_back(static_cast<char>(flags));
+        out.push_back(static_cast<char>(f64Cols.size()));
+        out.push_back(static_cast<char>(varintCols.size()));
+        CivFrame::putLE(out, rows, 4);
+        CivFrame::putLE(out, dict.size(), 4);
+
+        for (const auto& c : f64Cols)
+        {
+            for (double d : c)
+            {
+                uint64_t bits;
+                std::memcpy(&bits, &d, sizeof(bits));
+                CivFrame::putLE(out, bits, 8);
+            }
+        }
+        for (const auto& c : varintCols) out += c;
+        for (const auto& s : dict)
+        {
+            CivFrame::putVarint(out, s.size());
+            out += s;
+        }
+        return out;
+    }
+
+private:
+    std::vector<std::vector<double>> f64Cols;
+    std::vector<std::string> varintCols;
+    std::vector<std::string> dict;
+    std::unordered_map<std::string, uint32_t> dictIndex;
+};
+
+// Decoded view of a frame, for consumers and tests. Float columns are copied
+// out with memcpy on little-endian hosts.
+struct CivFrameData
+{
+    uint8_t flags = 0;
+    uint32_t rows = 0;
+    std::vector<std::vector<double>> f64;
+    std::vector<std::vector<uint64_t>> varints; // raw; apply CivFrame::unzigzag to signed columns
+    std::vector<std::string> dict;
+
+    // Throws std::runtime_error on malformed input
+    static CivFrameData parse(const std::string& frame)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(frame.data());
+        const uint8_t* end = p + frame.size();
+        if (frame.size() < CivFrame::HEADER_SIZE || std::memcmp(p, "CIVF", 4) != 0 || p[4] != CivFrame::VERSION)
+            throw std::runtime_error("civframe: bad header");
+
+        CivFrameData d;
+        d.flags = p[5];
+        size_t nF64 = p[6], nVar = p[7];
+        uint32_t dictSize;
+        std::memcpy(&d.rows, p + 8, 4);
+        std::memcpy(&dictSize, p + 12, 4);
+        p += CivFrame::HEADER_SIZE;
+
+        // Sizes are checked against the bytes left before anything is allocated,
+        // so a forged row count cannot trigger a huge allocation
+        if (nF64 && static_cast<uint64_t>(nF64) * d.rows * sizeof(double) > static_cast<uint64_t>(end - p))
+            throw std::runtime_error("civframe: truncated column");
+        d.f64.resize(nF64);
+        for (auto& c : d.f64)
+        {
+            c.resize(d.rows);
+            std::memcpy(c.data(), p, d.rows * sizeof(double));
+            p += d.rows * sizeof(double);
+        }
+
+        // Every varint takes at least one byte
+        if (static_cast<uint64_t>(nVar) * d.rows > static_cast<uint64_t>(end - p))
+            throw std::runtime_error("civframe: truncated column");
+        d.varints.resize(nVar);
+        for (auto& c : d.varints)
+        {
+            c.resize(d.rows);
+            for (auto& v : c) v = CivFrame::getVarint(p, end);
+        }
+
+        for (uint32_t i = 0; i < dictSize; i++)
+        {
+            uint64_t len = CivFrame::getVarint(p, end);
+            if (static_cast<uint64_t>(end - p) < len) throw std::runtime_error("civframe: truncated string");
+            d.dict.emplace_back(reinterpret_cast<const char*>(p), static_cast<size_t>(len));
+            p += len;
+        }
+        return d;
+    }
+};
@@ -0,0 +1,38 @@
+#include "compress.h"
+
+#ifdef CIVMAP_WITH_ZLIB
+#include <zlib.h>
+
+// windowBits 15 selects the zlib wrapper, 15 + 16 the gzip wrapper
+static bool compressStream(const std::string& in, std::string& out, int windowBits)
+{
+    z_stream zs{};
+    if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        return false;
+
+    std::string buf(deflateBound(&zs, static_cast<uLong>(in.size())), '\0');
+    zs.next_in   = reinterpret_cast<Bytef*>(const_cast<char*>(in.data()));
+    zs.avail_in  = static_cast<uInt>(in.size());
+    zs.next_out  = reinterpret_cast<Bytef*>(&buf[0]);
+    zs.avail_out = static_cast<uInt>(buf.size());
+
+    int rc = ::deflate(&zs, Z_FINISH);
+    deflateEnd(&zs);
+    if (rc != Z_STREAM_END) return false;
+
+    buf.resize(zs.total_out);
+    out = std::move(buf);
+    return true;
+}
+
+bool Compress::available() { return true; }
+bool Compress::gzip(const std::string& in, std::string& out) { return compressStream(in, out, 15 + 16); }
+bool Compress::deflate(const std::string& in, std::string& out) { return compressStream(in, out, 15); }
+
+#else
+
+bool Compress::available() { return false; }
+bool Compress::gzip(const std::string&, std::string&) { return false; }
+bool Compress::deflate(const std::string&, std::string&) { return false; }
+
+#endif
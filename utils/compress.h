@@ -0,0 +1,16 @@
+#pragma once
+#include <string>
+
+// One-shot zlib compression for pre-encoded response bodies.
+// Built with CIVMAP_WITH_ZLIB; otherwise available() is false and the
+// encoders leave `out` untouched and return false.
+namespace Compress
+{
+    bool available();
+
+    // RFC 1952 gzip stream (Content-Encoding: gzip)
+    bool gzip(const std::string& in, std::string& out);
+
+    // RFC 1950 zlib stream (Content-Encoding: deflate)
+    bool deflate(const std::string& in, std::string& out);
+}
@@ -0,0 +1,181 @@
+#pragma once
+#include <charconv>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Reader for flat JSON objects: {"key": scalar, ...} where a scalar is a
+// string, number, true/false or null. Nested objects and arrays are
+// rejected. Enough for request bodies; throws std::runtime_error on
+// malformed input.
+class JsonReader
+{
+public:
+    struct Value
+    {
+        enum Kind { String, Number, Bool, Null } kind = Null;
+        std::string text; // unescaped string, or the number's literal
+        double number = 0;
+        bool boolean = false;
+    };
+
+    static std::map<std::string, Value> parseObject(std::string_view in)
+    {
+        JsonReader r(in);
+        std::map<std::string, Value> out;
+        r.expect('{');
+        if (r.peek() == '}') { r.pos++; r.end(); return out; }
+        while (true)
+        {
+            std::string key = r.parseString();
+            r.expect(':');
+            out[key] = r.parseScalar();
+            char c = r.next();
+            if (c == '}') break;
+            if (c != ',') r.fail("expected ',' or '}'");
+        }
+        r.end();
+        return out;
+    }
+
+private:
+    std::string_view s;
+    size_t pos = 0;
+
+    explicit JsonReader(std::string_view in) : s(in) {}
+
+    [[noreturn]] void fail(const std::string& what) const
+    {
+        throw std::runtime_error("Invalid JSON at offset " + std::to_string(pos) + ": " + what);
+    }
+
+    void skipSpace()
+    {
+        while (pos < s.size() && (s[pos] == ' ' || s[pos] == '\t' || s[pos] == '\n' || s[pos] == '\r')) pos++;
+    }
+
+    char peek()
+    {
+        skipSpace();
+        if (pos == s.size()) fail("unexpected end");
+        return s[pos];
+    }
+
+    char next() { char c = peek(); pos++; return c; }
+
+    void expect(char c)
+    {
+        if (next() != c) { pos--; fail(std::string("expected '") + c + "'"); }
+    }
+
+    void end()
+    {
+        skipSpace();
+        if (pos != s.size()) fail("trailing characters");
+    }
+
+    bool consume(std::string_view word)
+    {
+        if (s.substr(pos, word.size()) != word) return false;
+        pos += word.size();
+        return true;
+    }
+
+    Value parseScalar()
+    {
+        Value v;
+        char c = peek();
+        if (c == '"') { v.kind = Value::String; v.text = parseString(); }
+        else if (consume("true"))  { v.kind = Value::Bool; v.boolean = true; }
+        else if (consume("false")) { v.kind = Value::Bool; }
+        else if (consume("null"))  { v.kind = Value::Null; }
+        else if (c == '-' || (c >= '0' && c <= '9'))
+        {
+            auto r = std::from_chars(s.data() + pos, s.data() + s.size(), v.number);
+            if (r.ec != std::errc()) fail("bad number");
+            v.kind = Value::Number;
+            v.text.assign(s.data() + pos, r.ptr);
+            pos = r.ptr - s.data();
+        }
+        else fail(c == '{' || c == '[' ? "nested values are not supported" : "unexpected character");
+        return v;
+    }
+
+    std::string parseString()
+    {
+        if (next() != '"') { pos--; fail("expected string"); }
+        std::string out;
+        while (true)
+        {
+            if (pos == s.size()) fail("unterminated string");
+            char c = s[pos++];
+            if (c == '"') return out;
+            if (static_cast<unsigned char>(c) < 0x20) fail("control character in string");
+            if (c != '\\') { out.push_back(c); continue; }
+            if (pos == s.size()) fail("unterminated string");
+            switch (s[pos++])
+            {
+            case '"':  out.push_back('"');  break;
+            case '\\': out.push_back('\\'); break;
+            case '/':  out.push_back('/');  break;
+            case 'b':  out.push_back('\b'); break;
+            case 'f':  out.push_back('\f'); break;
+            case 'n':  out.push_back('\n'); break;
+            case 'r':  out.push_back('\r'); break;
+            case 't':  out.push_back('\t'); break;
+            case 'u':  appendUtf8(out, parseCodePoint()); break;
+            default:   fail("bad escape");
+            }
+        }
+    }
+
+    uint32_t parseHex4()
+    {
+        if (s.size() - pos < 4) fail("bad \\u escape");
+        uint32_t v = 0;
+        auto r = std::from_chars(s.data() + pos, s.data() + pos + 4, v, 16);
+        if (r.ec != std::errc() || r.ptr != s.data() + pos + 4) fail("bad \\u escape");
+        pos += 4;
+        return v;
+    }
+
+    // \uXXXX, combining a UTF-16 surrogate pair into one code point
+    uint32_t parseCodePoint()
+    {
+        uint32_t cp = parseHex4();
+        if (cp >= 0xD800 && cp <= 0xDBFF)
+        {
+            if (!consume("\\u")) fail("unpaired surrogate");
+            uint32_t lo = parseHex4();
+            if (lo < 0xDC00 || lo > 0xDFFF) fail("unpaired surrogate");
+            cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+        }
+        else if (cp >= 0xDC00 && cp <= 0xDFFF) fail("unpaired surrogate");
+        return cp;
+    }
+
+    static void appendUtf8(std::string& out, uint32_t cp)
+    {
+        if (cp < 0x80) out.push_back(static_cast<char>(cp));
+        else if (cp < 0x800)
+        {
+            out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else if (cp < 0x10000)
+        {
+            out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+        else
+        {
+            out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+            out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+        }
+    }
+};
@@ -0,0 +1,112 @@
+#pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+// Append-only JSON output buffer.
+//
+// Numbers are formatted with std::to_chars straight into the buffer, so
+// output is locale-independent and never goes through a stream. clear()
+// keeps the capacity, which makes a reused writer allocation-free once it
+// has grown to the size of the largest response.
+class JsonWriter
+{
+public:
+    void clear() { buf.clear(); }
+    void reserve(size_t n) { buf.reserve(n); }
+
+    const char* data() const { return buf.data(); }
+    size_t size() const { return buf.size(); }
+    const std::string& str() const { return buf; }
+
+    // Verbatim text: punctuation, literal keys, pre-escaped fragments
+    JsonWriter& raw(std::string_view s) { buf.append(s.data(), s.size()); return *this; }
+    JsonWriter& raw(char c) { buf.push_back(c); return *this; }
+
+    // Quoted and escaped string value
+    JsonWriter& string(std::string_view s)
+    {
+        buf.push_back('"');
+        escapeTo(buf, s);
+        buf.push_back('"');
+        return *this;
+    }
+
+    // "name": — `name` must not need escaping
+    JsonWriter& key(std::string_view name)
+    {
+        buf.push_back('"');
+        buf.append(name.data(), name.size());
+        buf.append("\":", 2);
+        return *this;
+    }
+
+    JsonWriter& number(long long v)
+    {
+        char tmp[24];
+        auto r = std::to_chars(tmp, tmp + sizeof(tmp), v);
+        buf.append(tmp, r.ptr - tmp);
+        return *this;
+    }
+
+    JsonWriter& number(int v) { return number(static_cast<long long>(v)); }
+    JsonWriter& number(size_t v) { return number(static_cast<long long>(v)); }
+
+    // Fixed notation with `precision` decimals, or the shortest round-trip
+    // form when precision is negative
+    JsonWriter& number(double v, int precision = -1)
+    {
+        char tmp[64];
+        std::to_chars_result r = precision < 0
+            ? std::to_chars(tmp, tmp + sizeof(tmp), v)
+            : std::to_chars(tmp, tmp + sizeof(tmp), v, std::chars_format::fixed, precision);
+        if (r.ec != std::errc()) return raw("null"); // out of range for the scratch buffer
+        buf.append(tmp, r.ptr - tmp);
+        return *this;
+    }
+
+    JsonWriter& boolean(bool v) { return raw(v ? std::string_view("true") : std::string_view("false")); }
+
+    // Escapes `s` for use inside a JSON string literal and appends it to `out`
+    static void escapeTo(std::string& out, std::string_view s)
+    {
+        static const char hex[] = "0123456789abcdef";
+        size_t run = 0; // start of the pending run of characters that need no escaping
+        for (size_t i = 0; i < s.size(); i++)
+        {
+            unsigned char c = static_cast<unsigned char>(s[i]);
+            if (c >= 0x20 && c != '"' && c != '\\') continue;
+
+            out.append(s.data() + run, i - run);
+            run = i + 1;
+            switch (c)
+            {
+                case '"':  out.append("\\\"", 2); break;
+                case '\\': out.append("\\\\", 2); break;
+                case '\n': out.append("\\n", 2);  break;
+                case '\r': out.append("\\r", 2);  break;
+                case '\t': out.append("\\t", 2);  break;
+                default:
+                {
+                    char u[6] = {'\\', 'u', '0', '0', hex[c >> 4], hex[c & 0xF]};
+                    out.append(u, 6);
+                }
+            }
+        }
+        out.append(s.data() + run, s.size() - run);
+    }
+
+private:
+    std::string buf;
+};
+
+// Writer owned by the calling thread. Cleared on every call, capacity kept,
+// so each server worker reuses one buffer across requests.
+inline JsonWriter& threadJsonWriter()
+{
+    thread_local JsonWriter writer;
+    writer.clear();
+    return writer;
+}
@@ -1,26 +1,266 @@
 #include "logger.h"
-#include <iostream>
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <ctime>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <thread>
 
-std::string currentTime()
+namespace
 {
-    auto now = std::chrono::system_clock::now();
-    auto time = std::chrono::system_clock::to_time_t(now);
-    return std::ctime(&time);
+
+using Logger::Level;
+
+const char* const TAGS[] = {"[DEBUG] ", "[INFO] ", "[WARN] ", "[ERROR] "};
+
+// Bounded MPSC ring (Vyukov): each slot's sequence number says whether it
+// is free for the producer claiming position `pos` (seq == pos) or holds a
+// line for the consumer (seq == pos + 1).
+struct Slot
+{
+    std::atomic<uint64_t> seq{0};
+    Level level = Level::Info;
+    bool tagged = true;
+    uint16_t len = 0;
+    char text[Logger::Line::MAX];
+};
+
+const size_t CAPACITY = 4096; // power of two
+
+struct State
+{
+    std::array<Slot, CAPACITY> ring;
+    alignas(64) std::atomic<uint64_t> tail{0}; // next position to claim
+    alignas(64) uint64_t head = 0;             // consumer only
+
+    std::atomic<int> minLevel{static_cast<int>(Level::Info)};
+    std::atomic<bool> synchronous{false};
+    std::atomic<bool> stopped{false};
+
+    std::atomic<uint32_t> requestRate{0};
+    std::atomic<int64_t> rateSecond{-1};
+    std::atomic<uint32_t> rateCount{0};
+
+    std::atomic<uint64_t> written{0}, dropped{0}, sampledOut{0};
+
+    // Wakes the writer; producers only lock when it is asleep
+    std::mutex m;
+    std::condition_variable wake;
+    std::condition_variable drained;
+    std::atomic<bool> sleeping{false};
+    uint64_t writtenPos = 0; // all positions below this are on the stream
+    std::thread worker;
+
+    std::mutex syncMutex; // synchronous mode and shutdown
+
+    State()
+    {
+        for (size_t i = 0; i < CAPACITY; i++) ring[i].seq.store(i, std::memory_order_relaxed);
+        worker = std::thread([this] { run(); });
+        std::atexit([] { instance().stop(); });
+    }
+
+    static State& instance()
+    {
+        // Never destroyed: threads still logging during static teardown
+        // fall back to synchronous writes instead of touching a dead object
+        static State* s = new State;
+        return *s;
+    }
+
+    static void emit(std::string& out, Level level, bool tagged, const char* text, size_t len)
+    {
+        if (tagged) out += TAGS[static_cast<int>(level)];
+        out.append(text, len);
+        out += '\n';
+    }
+
+    void writeNow(Level level, bool tagged, std::string_view text)
+    {
+        std::string line;
+        emit(line, level, tagged, text.data(), text.size());
+        std::lock_guard<std::mutex> lock(syncMutex);
+        FILE* f = level >= Level::Warn ? stderr : stdout;
+        std::fwrite(line.data(), 1, line.size(), f);
+        std::fflush(f);
+        written.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void push(Level level, bool tagged, std::string_view text)
+    {
+        uint64_t pos = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        while (true)
+        {
+            slot = &ring[pos & (CAPACITY - 1)];
+            uint64_t seq = slot->seq.load(std::memory_order_acquire);
+            int64_t diff = static_cast<int64_t>(seq) - static_cast<int64_t>(pos);
+            if (diff == 0)
+            {
+                if (tail.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return;
+            }
+            else
+            {
+                pos = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        slot->tagged = tagged;
+        slot->len = static_cast<uint16_t>(text.size());
+        std::memcpy(slot->text, text.data(), text.size());
+        slot->seq.store(pos + 1, std::memory_order_release);
+
+        // Pairs with the fence in run(): either we see the writer asleep or
+        // it sees this line before going to sleep
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (sleeping.load(std::memory_order_relaxed))
+        {
+            std::lock_guard<std::mutex> lock(m);
+            wake.notify_one();
+        }
+    }
+
+    // Moves every ready line into the two batch buffers
+    size_t drain(std::string& out, std::string& err)
+    {
+        size_t n = 0;
+        while (true)
+        {
+            Slot& slot = ring[head & (CAPACITY - 1)];
+            if (slot.seq.load(std::memory_order_acquire) != head + 1) break;
+            emit(slot.level >= Level::Warn ? err : out, slot.level, slot.tagged, slot.text, slot.len);
+            slot.seq.store(head + CAPACITY, std::memory_order_release);
+            head++;
+            n++;
+        }
+        return n;
+    }
+
+    void run()
+    {
+        std::string out, err;
+        while (true)
+        {
+            out.clear();
+            err.clear();
+            size_t n = drain(out, err);
+            if (n)
+            {
+                std::lock_guard<std::mutex> lock(syncMutex);
+                if (!out.empty()) { std::fwrite(out.data(), 1, out.size(), stdout); std::fflush(stdout); }
+                if (!err.empty()) { std::fwrite(err.data(), 1, err.size(), stderr); std::fflush(stderr); }
+                written.fetch_add(n, std::memory_order_relaxed);
+            }
+
+            std::unique_lock<std::mutex> lock(m);
+            writtenPos = head;
+            drained.notify_all();
+            if (n) continue;
+            if (stopped.load()) return;
+            sleeping.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            if (ring[head & (CAPACITY - 1)].seq.load(std::memory_order_acquire) != head + 1)
+                wake.wait_for(lock, std::chrono::milliseconds(100));
+            sleeping.store(false, std::memory_order_relaxed);
+        }
+    }
+
+    void flush()
+    {
+        uint64_t target = tail.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(m);
+        wake.notify_one();
+        drained.wait_for(lock, std::chrono::seconds(2), [&] { return writtenPos >= target || stopped.load(); });
+    }
+
+    void stop()
+    {
+        if (stopped.load()) return;
+        flush();
+        {
+            std::lock_guard<std::mutex> lock(m);
+            stopped.store(true);
+            wake.notify_one();
+        }
+        if (worker.joinable()) worker.join();
+    }
+};
+
+} // namespace
+
+namespace Logger
+{
+
+void setLevel(Level l) { State::instance().minLevel.store(static_cast<int>(l), std::memory_order_relaxed); }
+
+Level level() { return static_cast<Level>(State::instance().minLevel.load(std::memory_order_relaxed)); }
+
+Level parseLevel(const std::string& name, Level fallback)
+{
+    if (name == "debug") return Level::Debug;
+    if (name == "info")  return Level::Info;
+    if (name == "warn")  return Level::Warn;
+    if (name == "error") return Level::Error;
+    if (name == "off")   return Level::Off;
+    return fallback;
 }
 
-void Logger::info(const std::string& message)
+void setSynchronous(bool on)
 {
-    std::cout << "[INFO] " << message << std::endl;
+    if (on) flush();
+    State::instance().synchronous.store(on);
 }
 
-void Logger::warn(const std::string& message)
+void setRequestRate(uint32_t perSecond) { State::instance().requestRate.store(perSecond); }
+
+bool sampleRequest()
 {
-    std::cout << "[WARN] " << message << std::endl;
+    State& s = State::instance();
+    uint32_t limit = s.requestRate.load(std::memory_order_relaxed);
+    if (limit == 0) return true;
+
+    int64_t now = std::chrono::duration_cast<std::chrono::seconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64_t second = s.rateSecond.load(std::memory_order_relaxed);
+    if (second != now && s.rateSecond.compare_exchange_strong(second, now, std::memory_order_relaxed))
+        s.rateCount.store(0, std::memory_order_relaxed);
+    if (s.rateCount.fetch_add(1, std::memory_order_relaxed) < limit) return true;
+    s.sampledOut.fetch_add(1, std::memory_order_relaxed);
+    return false;
 }
 
-void Logger::error(const std::string& message)
+void write(Level l, bool tagged, std::string_view text)
 {
-    std::cout << "[ERROR] " << message << std::endl;
+    State& s = State::instance();
+    if (s.synchronous.load(std::memory_order_relaxed) || s.stopped.load(std::memory_order_relaxed))
+        s.writeNow(l, tagged, text);
+    else
+        s.push(l, tagged, text.substr(0, Line::MAX));
+}
+
+void flush() { State::instance().flush(); }
+
+Stats stats()
+{
+    State& s = State::instance();
+    Stats out;
+    out.written = s.written.load(std::memory_order_relaxed);
+    out.dropped = s.dropped.load(std::memory_order_relaxed);
+    out.sampledOut = s.sampledOut.load(std::memory_order_relaxed);
+    return out;
+}
+
+void debug(const std::string& message) { if (enabled(Level::Debug)) write(Level::Debug, true, message); }
+void info(const std::string& message)  { if (enabled(Level::Info))  write(Level::Info,  true, message); }
+void warn(const std::string& message)  { if (enabled(Level::Warn))  write(Level::Warn,  true, message); }
+void error(const std::string& message) { if (enabled(Level::Error)) write(Level::Error, true, message); }
+
 }
@@ -1,9 +1,122 @@
 #pragma once
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <string_view>
+#include <type_traits>
 
+// Lowest level compiled in (0 debug, 1 info, 2 warn, 3 error). Lines below it
+// cost nothing at run time when logged through LOG_DEBUG/LOG_INFO/... .
+#ifndef CIVMAP_LOG_MIN_LEVEL
+#define CIVMAP_LOG_MIN_LEVEL 0
+#endif
+
+// Asynchronous logger.
+//
+// Callers format a line on their own stack and push it into a bounded
+// lock-free MPSC ring; one background thread drains the ring and writes
+// whole batches with a single fwrite + fflush. Nothing on the calling side
+// locks or touches stdout. When the ring is full the line is dropped and
+// counted instead of blocking the caller.
 namespace Logger
 {
+    enum class Level { Debug, Info, Warn, Error, Off };
+
+    // Runtime threshold; lines below it are discarded (default Info)
+    void setLevel(Level level);
+    Level level();
+
+    // "debug", "info", "warn", "error" or "off"; anything else gives `fallback`
+    Level parseLevel(const std::string& name, Level fallback = Level::Info);
+
+    inline bool enabled(Level l)
+    {
+        return static_cast<int>(l) >= CIVMAP_LOG_MIN_LEVEL && l >= level();
+    }
+
+    // Write every line inline instead of through the background thread.
+    // For interactive programs whose prompts must not overtake log lines.
+    void setSynchronous(bool on);
+
+    // Per-request lines beyond `perSecond` in any one second are counted
+    // and skipped; 0 logs them all
+    void setRequestRate(uint32_t perSecond);
+
+    // True if this request line fits in the current second's budget
+    bool sampleRequest();
+
+    // `tagged` prefixes the line with its level, e.g. "[INFO] "
+    void write(Level level, bool tagged, std::string_view text);
+
+    // Blocks until everything logged so far has been written
+    void flush();
+
+    struct Stats
+    {
+        uint64_t written = 0;
+        uint64_t dropped = 0;    // ring full
+        uint64_t sampledOut = 0; // over the request rate
+    };
+    Stats stats();
+
+    void debug(const std::string& message);
     void info(const std::string& message);
     void warn(const std::string& message);
     void error(const std::string& message);
+
+    // Formats one line into a fixed stack buffer (longer lines are cut)
+    // and submits it when destroyed. Use through the LOG_* macros.
+    class Line
+    {
+    public:
+        static const size_t MAX = 240;
+
+        Line(Level l, bool tagged = true) : lvl(l), tag(tagged) {}
+        ~Line() { write(lvl, tag, std::string_view(buf, len)); }
+        Line(const Line&) = delete;
+        Line& operator=(const Line&) = delete;
+
+        Line& operator<<(std::string_view s)
+        {
+            size_t n = s.size() < MAX - len ? s.size() : MAX - len;
+            for (size_t i = 0; i < n; i++) buf[len + i] = s[i];
+            len += n;
+            return *this;
+        }
+        Line& operator<<(const char* s) { return *this << std::string_view(s); }
+        Line& operator<<(const std::string& s) { return *this << std::string_view(s); }
+        Line& operator<<(char c) { return *this << std::string_view(&c, 1); }
+
+        template <typename T, typename = std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
+        Line& operator<<(T v)
+        {
+            auto r = std::to_chars(buf + len, buf + MAX, v);
+            if (r.ec == std::errc()) len = r.ptr - buf;
+            return *this;
+        }
+
+    private:
+        Level lvl;
+        bool tag;
+        size_t len = 0;
+        char buf[MAX];
+    };
 }
+
+#define CIVMAP_LOG_AT(level, tagged, ...)                                   \
+    do {                                                                    \
+        if (::Logger::enabled(level)) ::Logger::Line(level, tagged) << __VA_ARGS__; \
+    } while (0)
+
+#define LOG_DEBUG(...) CIVMAP_LOG_AT(::Logger::Level::Debug, true, __VA_ARGS__)
+#define LOG_INFO(...)  CIVMAP_LOG_AT(::Logger::Level::Info,  true, __VA_ARGS__)
+#define LOG_WARN(...)  CIVMAP_LOG_AT(::Logger::Level::Warn,  true, __VA_ARGS__)
+#define LOG_ERROR(...) CIVMAP_LOG_AT(::Logger::Level::Error, true, __VA_ARGS__)
+
+// Access-log line: untagged, Info level, subject to the request rate
+#define LOG_REQUEST(...)                                                    \
+    do {                                                                    \
+        if (::Logger::enabled(::Logger::Level::Info) && ::Logger::sampleRequest()) \
+            ::Logger::Line(::Logger::Level::Info, false) << __VA_ARGS__;    \
+    } while (0)
@@ -0,0 +1,248 @@
+#include "metrics.h"
+#include <cmath>
+#include <cstdio>
+#include <limits>
+
+namespace Metrics
+{
+
+static thread_local Route* activeRoute = nullptr;
+
+size_t threadShard()
+{
+    static std::atomic<size_t> next{0};
+    thread_local size_t shard = next.fetch_add(1, std::memory_order_relaxed) % SHARDS;
+    return shard;
+}
+
+uint64_t Counter::value() const
+{
+    uint64_t total = 0;
+    for (const auto& s : shards) total += s.v.load(std::memory_order_relaxed);
+    return total;
+}
+
+// ----------------------------------------------------
+// Histogram
+// ----------------------------------------------------
+
+void Histogram::record(uint64_t ns)
+{
+    uint64_t us = (ns + 999) / 1000;
+    int bucket = us <= 1 ? 0 : 64 - __builtin_clzll(us - 1); // ceil(log2(us))
+    if (bucket > BUCKETS - 1) bucket = BUCKETS - 1;
+
+    Shard& s = shards[threadShard()];
+    s.counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    s.count.fetch_add(1, std::memory_order_relaxed);
+    s.sumNs.fetch_add(ns, std::memory_order_relaxed);
+}
+
+Histogram::Snapshot Histogram::snapshot() const
+{
+    Snapshot snap;
+    for (const auto& s : shards)
+    {
+        for (int i = 0; i < BUCKETS; i++) snap.counts[i] += s.counts[i].load(std::memory_order_relaxed);
+        snap.sumNs += s.sumNs.load(std::memory_order_relaxed);
+    }
+    // Derive the total from the buckets so it is consistent with them even
+    // while other threads are recording
+    for (uint64_t c : snap.counts) snap.count += c;
+    return snap;
+}
+
+double Histogram::upperBound(int i)
+{
+    if (i >= BUCKETS - 1) return std::numeric_limits<double>::infinity();
+    return std::ldexp(1e-6, i);
+}
+
+double Histogram::Snapshot::quantile(double q) const
+{
+    if (count == 0) return 0.0;
+    double rank = q * count;
+    uint64_t cumulative = 0;
+    for (int i = 0; i < BUCKETS; i++)
+    {
+        if (counts[i] == 0) continue;
+        if (cumulative + counts[i] >= rank)
+        {
+            double lower = i == 0 ? 0.0 : upperBound(i - 1);
+            if (i == BUCKETS - 1) return lower; // nothing to interpolate towards
+            double upper = upperBound(i);
+            return lower + (upper - lower) * (rank - cumulative) / counts[i];
+        }
+        cumulative += counts[i];
+    }
+    return upperBound(BUCKETS - 2);
+}
+
+// ----------------------------------------------------
+// Request scopes
+// ----------------------------------------------------
+
+RequestScope::RequestScope(Route& r, const int& s)
+    : route(r), status(s), start(std::chrono::steady_clock::now()), outer(activeRoute)
+{
+    route.inFlight.fetch_add(1, std::memory_order_relaxed);
+    activeRoute = &route;
+}
+
+RequestScope::~RequestScope()
+{
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    route.latency.record(static_cast<uint64_t>(ns));
+    if (status >= 400) route.errors.add();
+    route.inFlight.fetch_sub(1, std::memory_order_relaxed);
+    activeRoute = outer;
+}
+
+PhaseTimer::PhaseTimer(Phase p) : phase(p), start(std::chrono::steady_clock::now()) {}
+
+void PhaseTimer::stop()
+{
+    if (!running) return;
+    running = false;
+    if (!activeRoute) return;
+    auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    activeRoute->phaseNs[static_cast<size_t>(phase)].add(static_cast<uint64_t>(ns));
+}
+
+// ----------------------------------------------------
+// Registry + Prometheus text exposition
+// ----------------------------------------------------
+
+Route& Registry::route(const std::string& name)
+{
+    for (auto& r : routes)
+        if (r.name == name) return r;
+    routes.emplace_back(name);
+    return routes.back();
+}
+
+void Registry::gauge(const std::string& name, const std::string& help,
+                     const std::string& labels, std::function<double()> sample)
+{
+    sampled.push_back({name, "gauge", help, labels, std::move(sample)});
+}
+
+void Registry::counter(const std::string& name, const std::string& help,
+                       const std::string& labels, std::function<double()> sample)
+{
+    sampled.push_back({name, "counter", help, labels, std::move(sample)});
+}
+
+static void appendNumber(std::string& out, double v)
+{
+    if (std::isinf(v)) { out += v > 0 ? "+Inf" : "-Inf"; return; }
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.9g", v);
+    out += buf;
+}
+
+static void appendHeader(std::string& out, const char* name, const char* type, const char* help)
+{
+    out += "# HELP "; out += name; out += ' '; out += help; out += '\n';
+    out += "# TYPE "; out += name; out += ' '; out += type; out += '\n';
+}
+
+std::string Registry::renderPrometheus() const
+{
+    static const char* const PHASE_NAMES[] = {"index", "serialize"};
+    static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+    std::vector<Histogram::Snapshot> snaps;
+    for (const auto& r : routes) snaps.push_back(r.latency.snapshot());
+
+    std::string out;
+    appendHeader(out, "civmap_http_requests_total", "counter", "Requests handled, by route.");
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        out += "civmap_http_requests_total{route=\"" + routes[i].name + "\"} ";
+        appendNumber(out, double(snaps[i].count));
+        out += '\n';
+    }
+
+    appendHeader(out, "civmap_http_errors_total", "counter", "Responses with status >= 400, by route.");
+    for (const auto& r : routes)
+    {
+        out += "civmap_http_errors_total{route=\"" + r.name + "\"} ";
+        appendNumber(out, double(r.errors.value()));
+        out += '\n';
+    }
+
+    appendHeader(out, "civmap_http_in_flight", "gauge", "Requests currently being handled, by route.");
+    for (const auto& r : routes)
+    {
+        out += "civmap_http_in_flight{route=\"" + r.name + "\"} ";
+        appendNumber(out, double(r.inFlight.load(std::memory_order_relaxed)));
+        out += '\n';
+    }
+
+    appendHeader(out, "civmap_http_request_duration_seconds", "histogram",
+                 "Request latency, log2 buckets from 1us.");
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        const std::string labels = "route=\"" + routes[i].name + "\"";
+        uint64_t cumulative = 0;
+        for (int b = 0; b < Histogram::BUCKETS; b++)
+        {
+            cumulative += snaps[i].counts[b];
+            out += "civmap_http_request_duration_seconds_bucket{" + labels + ",le=\"";
+            appendNumber(out, Histogram::upperBound(b));
+            out += "\"} ";
+            appendNumber(out, double(cumulative));
+            out += '\n';
+        }
+        out += "civmap_http_request_duration_seconds_sum{" + labels + "} ";
+        appendNumber(out, snaps[i].sumNs / 1e9);
+        out += "\ncivmap_http_request_duration_seconds_count{" + labels + "} ";
+        appendNumber(out, double(snaps[i].count));
+        out += '\n';
+    }
+
+    appendHeader(out, "civmap_http_request_latency_seconds", "summary",
+                 "Request latency quantiles estimated from the histogram.");
+    for (size_t i = 0; i < routes.size(); i++)
+    {
+        for (double q : QUANTILES)
+        {
+            out += "civmap_http_request_latency_seconds{route=\"" + routes[i].name + "\",quantile=\"";
+            appendNumber(out, q);
+            out += "\"} ";
+            appendNumber(out, snaps[i].quantile(q));
+            out += '\n';
+        }
+    }
+
+    appendHeader(out, "civmap_phase_seconds_total", "counter",
+                 "Time spent in index traversal vs response serialization, by route.");
+    for (const auto& r : routes)
+    {
+        for (size_t p = 0; p < static_cast<size_t>(Phase::Count); p++)
+        {
+            out += "civmap_phase_seconds_total{route=\"" + r.name + "\",phase=\"" + PHASE_NAMES[p] + "\"} ";
+            appendNumber(out, r.phaseNs[p].value() / 1e9);
+            out += '\n';
+        }
+    }
+
+    std::string lastName;
+    for (const auto& g : sampled)
+    {
+        if (g.name != lastName)
+        {
+            appendHeader(out, g.name.c_str(), g.type.c_str(), g.help.c_str());
+            lastName = g.name;
+        }
+        out += g.name;
+        if (!g.labels.empty()) out += "{" + g.labels + "}";
+        out += ' ';
+        appendNumber(out, g.sample());
+        out += '\n';
+    }
+    return out;
+}
+
+}
@@ -0,0 +1,139 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <string>
+#include <vector>
+
+// In-process request metrics rendered in the Prometheus text format.
+//
+// Hot-path recording is lock-free: every counter and histogram is split into
+// cache-line aligned shards, and each thread writes only to the shard picked
+// for it on first use, so concurrent requests do not bounce cache lines.
+// Reads (scrapes) sum the shards.
+namespace Metrics
+{
+    const size_t SHARDS = 16;
+
+    // Shard owned by the calling thread, assigned round-robin on first use
+    size_t threadShard();
+
+    class Counter
+    {
+    public:
+        void add(uint64_t n = 1) { shards[threadShard()].v.fetch_add(n, std::memory_order_relaxed); }
+        uint64_t value() const;
+
+    private:
+        struct alignas(64) Shard { std::atomic<uint64_t> v{0}; };
+        std::array<Shard, SHARDS> shards;
+    };
+
+    // Log2-bucketed latency histogram: bucket i counts durations up to
+    // 2^i microseconds (1 us .. ~67 s), the last bucket is +Inf.
+    class Histogram
+    {
+    public:
+        static const int BUCKETS = 28;
+
+        struct Snapshot
+        {
+            std::array<uint64_t, BUCKETS> counts{};
+            uint64_t count = 0;
+            uint64_t sumNs = 0;
+
+            // Interpolated within the bucket holding the q-th observation, in seconds
+            double quantile(double q) const;
+        };
+
+        void record(uint64_t ns);
+        Snapshot snapshot() const;
+
+        // Upper bound of bucket i in seconds (+Inf for the last bucket)
+        static double upperBound(int i);
+
+    private:
+        struct alignas(64) Shard
+        {
+            std::array<std::atomic<uint64_t>, BUCKETS> counts{};
+            std::atomic<uint64_t> count{0};
+            std::atomic<uint64_t> sumNs{0};
+        };
+        std::array<Shard, SHARDS> shards;
+    };
+
+    enum class Phase { Index, Serialize, Count };
+
+    // Everything recorded for one route
+    struct Route
+    {
+        explicit Route(std::string n) : name(std::move(n)) {}
+
+        std::string name;
+        Histogram latency;
+        Counter errors;                 // responses with status >= 400
+        std::atomic<int64_t> inFlight{0};
+        std::array<Counter, static_cast<size_t>(Phase::Count)> phaseNs;
+    };
+
+    // Times one request: in-flight gauge, latency histogram, error count.
+    // While alive it is the target of PhaseTimer on this thread.
+    class RequestScope
+    {
+    public:
+        RequestScope(Route& route, const int& status);
+        ~RequestScope();
+
+    private:
+        Route& route;
+        const int& status;
+        std::chrono::steady_clock::time_point start;
+        Route* outer;
+    };
+
+    // Adds the lifetime of the scope (or up to stop()) to the current
+    // request's phase total. A no-op outside a RequestScope.
+    class PhaseTimer
+    {
+    public:
+        explicit PhaseTimer(Phase p);
+        ~PhaseTimer() { stop(); }
+
+        void stop();
+
+    private:
+        Phase phase;
+        std::chrono::steady_clock::time_point start;
+        bool running = true;
+    };
+
+    class Registry
+    {
+    public:
+        // Register every route before serving; returned references stay valid
+        Route& route(const std::string& name);
+
+        // Values sampled at scrape time; `labels` is a pre-rendered label set
+        // such as index="kdtree", or empty. Samples of one name must be
+        // registered consecutively.
+        void gauge(const std::string& name, const std::string& help,
+                   const std::string& labels, std::function<double()> sample);
+        void counter(const std::string& name, const std::string& help,
+                     const std::string& labels, std::function<double()> sample);
+
+        std::string renderPrometheus() const;
+
+    private:
+        struct Sampled
+        {
+            std::string name, type, help, labels;
+            std::function<double()> sample;
+        };
+
+        std::deque<Route> routes;
+        std::vector<Sampled> sampled;
+    };
+}
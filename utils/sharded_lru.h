@@ -0,0 +1,104 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Thread-safe LRU map split into independently locked shards, so concurrent
+// lookups of different keys rarely contend. Each shard evicts its own least
+// recently used entry once it holds capacity / shards entries.
+template <typename Key, typename Value, typename Hash = std::hash<Key>>
+class ShardedLRU
+{
+public:
+    explicit ShardedLRU(size_t capacity, size_t shardCount = 16)
+    {
+        if (shardCount == 0) shardCount = 1;
+        size_t perShard = std::max<size_t>(1, capacity / shardCount);
+        for (size_t i = 0; i < shardCount; i++)
+            shards.push_back(std::make_unique<Shard>(perShard));
+    }
+
+    // Copies the value into `out` and marks the entry most recently used
+    bool get(const Key& key, Value& out)
+    {
+        Shard& s = shardFor(key);
+        std::lock_guard<std::mutex> lock(s.m);
+        auto it = s.index.find(key);
+        if (it == s.index.end()) return false;
+        s.order.splice(s.order.begin(), s.order, it->second);
+        out = it->second->second;
+        return true;
+    }
+
+    void put(const Key& key, Value value)
+    {
+        Shard& s = shardFor(key);
+        std::lock_guard<std::mutex> lock(s.m);
+        auto it = s.index.find(key);
+        if (it != s.index.end())
+        {
+            it->second->second = std::move(value);
+            s.order.splice(s.order.begin(), s.order, it->second);
+            return;
+        }
+        s.order.emplace_front(key, std::move(value));
+        s.index[key] = s.order.begin();
+        if (s.order.size() > s.capacity)
+        {
+            s.index.erase(s.order.back().first);
+            s.order.pop_back();
+        }
+    }
+
+    size_t size() const
+    {
+        size_t n = 0;
+        for (const auto& s : shards)
+        {
+            std::lock_guard<std::mutex> lock(s->m);
+            n += s->order.size();
+        }
+        return n;
+    }
+
+    void clear()
+    {
+        for (auto& s : shards)
+        {
+            std::lock_guard<std::mutex> lock(s->m);
+            s->index.clear();
+            s->order.clear();
+        }
+    }
+
+private:
+    struct Shard
+    {
+        explicit Shard(size_t cap) : capacity(cap) {}
+        mutable std::mutex m;
+        std::list<std::pair<Key, Value>> order; // most recently used first
+        std::unordered_map<Key, typename std::list<std::pair<Key, Value>>::iterator, Hash> index;
+        size_t capacity;
+    };
+
+    // std::hash is the identity for integers on common standard libraries;
+    // mix the bits so packed keys spread over every shard
+    Shard& shardFor(const Key& key)
+    {
+        uint64_t h = hasher(key);
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        return *shards[h % shards.size()];
+    }
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    Hash hasher;
+};
@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Collapses identical concurrent computations into one. The first caller
+// for a key (the leader) computes the value; callers arriving with the same
+// key while it runs (followers) wait on a shared future and get the same
+// immutable result, or the leader's exception. Nothing is kept once the
+// leader finishes: a later caller computes afresh, so this only absorbs
+// bursts and never serves stale results.
+template <typename Value>
+class SingleFlight
+{
+public:
+    using Result = std::shared_ptr<const Value>;
+
+    std::atomic<uint64_t> leaders{0}, followers{0}, abandoned{0};
+
+    // compute() must return a Value. Followers wait at most until `deadline`
+    // and get nullptr if the leader is still running by then.
+    template <typename F>
+    Result run(const std::string& key, std::chrono::steady_clock::time_point deadline, F&& compute)
+    {
+        std::promise<Result> promise;
+        std::shared_future<Result> pending;
+        {
+            std::lock_guard<std::mutex> lock(m);
+            auto it = inFlight.find(key);
+            if (it != inFlight.end()) pending = it->second;
+            else inFlight.emplace(key, promise.get_future().share());
+        }
+
+        if (pending.valid())
+        {
+            followers++;
+            if (pending.wait_until(deadline) != std::future_status::ready)
+            {
+                abandoned++;
+                return nullptr;
+            }
+            return pending.get();
+        }
+
+        leaders++;
+        Result result;
+        try
+        {
+            result = std::make_shared<const Value>(compute());
+        }
+        catch (...)
+        {
+            finish(key);
+            promise.set_exception(std::current_exception());
+            throw;
+        }
+        finish(key);
+        promise.set_value(result);
+        return result;
+    }
+
+    size_t inFlightCount() const
+    {
+        std::lock_guard<std::mutex> lock(m);
+        return inFlight.size();
+    }
+
+private:
+    mutable std::mutex m;
+    std::unordered_map<std::string, std::shared_future<Result>> inFlight;
+
+    // Followers already holding the future still get the value
+    void finish(const std::string& key)
+    {
+        std::lock_guard<std::mutex> lock(m);
+        inFlight.erase(key);
+    }
+};